@@ -1,5 +1,6 @@
 #include <solanaceae/plugin/solana_plugin_v1.h>
 
+#include <solanaceae/util/config_model.hpp>
 #include <solanaceae/contact/contact_store_i.hpp>
 
 #include <solanaceae/ngc_ext/ngcext.hpp>
@@ -13,6 +14,7 @@
 #include <entt/entt.hpp>
 #include <entt/fwd.hpp>
 
+#include <algorithm>
 #include <memory>
 #include <iostream>
 
@@ -64,6 +66,18 @@ SOLANA_PLUGIN_EXPORT uint32_t solana_plugin_start(struct SolanaAPI* solana_api)
 
 		PLUG_PROVIDE_INSTANCE(SHA1_NGCFT1, plugin_name, g_sha1_ngcft1.get());
 
+		// optional, without it the hash cache stays off
+		if (auto* conf = PLUG_RESOLVE_INSTANCE_OPT(ConfigModelI); conf != nullptr) {
+			if (const auto hash_threads = conf->get_int("SHA1_NGCFT1", "hash_threads"); hash_threads.has_value() && hash_threads.value() >= 0) {
+				g_sha1_ngcft1->setHashThreads(hash_threads.value());
+			}
+
+			if (const auto hash_cache_path = conf->get_string("SHA1_NGCFT1", "hash_cache_path"); hash_cache_path.has_value()) {
+				const int64_t max_bytes = conf->get_int("SHA1_NGCFT1", "hash_cache_max_bytes").value_or(16*1024*1024);
+				g_sha1_ngcft1->setHashCachePath(std::string_view{hash_cache_path.value()}, std::max<int64_t>(max_bytes, 0));
+			}
+		}
+
 		Contact::registerNGCFT1SHA1Components2Str(*g_cs_ptr);
 
 		// optinally add imgui
@@ -1,6 +1,9 @@
 #include "./ngcext.hpp"
 
 #include <iostream>
+#include <chrono>
+#include <type_traits>
+#include <cstring>
 #include <cassert>
 
 NGCEXTEventProvider::NGCEXTEventProvider(ToxI& t, ToxEventProviderI& tep) : _t(t), _tep(tep), _tep_sr(_tep.newSubRef(this)) {
@@ -12,6 +15,18 @@ NGCEXTEventProvider::NGCEXTEventProvider(ToxI& t, ToxEventProviderI& tep) : _t(t
 
 #define _DATA_HAVE(x, error) if ((data_size - curser) < (x)) { error; }
 
+// - 1 byte (transfer_id), or 2 bytes in the wide variants
+static bool read_transfer_id(const uint8_t* data, size_t data_size, size_t& curser, bool wide, uint16_t& transfer_id) {
+	const size_t tid_size = wide ? sizeof(uint16_t) : sizeof(uint8_t);
+	_DATA_HAVE(tid_size, std::cerr << "NGCEXT: packet too small, missing transfer_id\n"; return false)
+
+	transfer_id = 0u;
+	for (size_t i = 0; i < tid_size; i++, curser++) {
+		transfer_id |= uint16_t(data[curser]) << (i*8);
+	}
+	return true;
+}
+
 bool NGCEXTEventProvider::parse_ft1_request(
 	uint32_t group_number, uint32_t peer_number,
 	const uint8_t* data, size_t data_size,
@@ -30,7 +45,7 @@ bool NGCEXTEventProvider::parse_ft1_request(
 	}
 
 	// - X bytes (file_kind dependent id, differnt sizes)
-	e.file_id = {data+curser, data+curser+(data_size-curser)};
+	e.file_id = ByteSpan{data+curser, data_size-curser};
 
 	return dispatch(
 		NGCEXT_Event::FT1_REQUEST,
@@ -72,7 +87,7 @@ bool NGCEXTEventProvider::parse_ft1_init(
 	e.transfer_id = data[curser++];
 
 	// - X bytes (file_kind dependent id, differnt sizes)
-	e.file_id = {data+curser, data+curser+(data_size-curser)};
+	e.file_id = ByteSpan{data+curser, data_size-curser};
 
 	return dispatch(
 		NGCEXT_Event::FT1_INIT,
@@ -146,6 +161,22 @@ bool NGCEXTEventProvider::parse_ft1_init_ack_v3(
 	uint32_t group_number, uint32_t peer_number,
 	const uint8_t* data, size_t data_size,
 	bool _private
+) {
+	return parse_ft1_init_ack_v3(group_number, peer_number, data, data_size, _private, false);
+}
+
+bool NGCEXTEventProvider::parse_ft1_init_ack_wide(
+	uint32_t group_number, uint32_t peer_number,
+	const uint8_t* data, size_t data_size,
+	bool _private
+) {
+	return parse_ft1_init_ack_v3(group_number, peer_number, data, data_size, _private, true);
+}
+
+bool NGCEXTEventProvider::parse_ft1_init_ack_v3(
+	uint32_t group_number, uint32_t peer_number,
+	const uint8_t* data, size_t data_size,
+	bool _private, bool wide
 ) {
 	if (!_private) {
 		std::cerr << "NGCEXT: ft1_init_ack_v3 cant be public\n";
@@ -157,9 +188,10 @@ bool NGCEXTEventProvider::parse_ft1_init_ack_v3(
 	e.peer_number = peer_number;
 	size_t curser = 0;
 
-	// - 1 byte (temporary_file_tf_id)
-	_DATA_HAVE(sizeof(e.transfer_id), std::cerr << "NGCEXT: packet too small, missing transfer_id\n"; return false)
-	e.transfer_id = data[curser++];
+	// - 1 or 2 bytes (temporary_file_tf_id)
+	if (!read_transfer_id(data, data_size, curser, wide, e.transfer_id)) {
+		return false;
+	}
 
 	// - 2 byte (max_lossy_data_size)
 	if ((data_size - curser) >= sizeof(e.max_lossy_data_size)) {
@@ -188,6 +220,22 @@ bool NGCEXTEventProvider::parse_ft1_data(
 	uint32_t group_number, uint32_t peer_number,
 	const uint8_t* data, size_t data_size,
 	bool _private
+) {
+	return parse_ft1_data(group_number, peer_number, data, data_size, _private, false);
+}
+
+bool NGCEXTEventProvider::parse_ft1_data_wide(
+	uint32_t group_number, uint32_t peer_number,
+	const uint8_t* data, size_t data_size,
+	bool _private
+) {
+	return parse_ft1_data(group_number, peer_number, data, data_size, _private, true);
+}
+
+bool NGCEXTEventProvider::parse_ft1_data(
+	uint32_t group_number, uint32_t peer_number,
+	const uint8_t* data, size_t data_size,
+	bool _private, bool wide
 ) {
 	if (!_private) {
 		std::cerr << "NGCEXT: ft1_data cant be public\n";
@@ -199,9 +247,10 @@ bool NGCEXTEventProvider::parse_ft1_data(
 	e.peer_number = peer_number;
 	size_t curser = 0;
 
-	// - 1 byte (temporary_file_tf_id)
-	_DATA_HAVE(sizeof(e.transfer_id), std::cerr << "NGCEXT: packet too small, missing transfer_id\n"; return false)
-	e.transfer_id = data[curser++];
+	// - 1 or 2 bytes (temporary_file_tf_id)
+	if (!read_transfer_id(data, data_size, curser, wide, e.transfer_id)) {
+		return false;
+	}
 
 	// - 2 bytes (sequence_id)
 	e.sequence_id = 0u;
@@ -212,7 +261,7 @@ bool NGCEXTEventProvider::parse_ft1_data(
 
 	// - X bytes (the data fragment)
 	// (size is implicit)
-	e.data = {data+curser, data+curser+(data_size-curser)};
+	e.data = ByteSpan{data+curser, data_size-curser};
 
 	return dispatch(
 		NGCEXT_Event::FT1_DATA,
@@ -224,6 +273,22 @@ bool NGCEXTEventProvider::parse_ft1_data_ack(
 	uint32_t group_number, uint32_t peer_number,
 	const uint8_t* data, size_t data_size,
 	bool _private
+) {
+	return parse_ft1_data_ack(group_number, peer_number, data, data_size, _private, false);
+}
+
+bool NGCEXTEventProvider::parse_ft1_data_ack_wide(
+	uint32_t group_number, uint32_t peer_number,
+	const uint8_t* data, size_t data_size,
+	bool _private
+) {
+	return parse_ft1_data_ack(group_number, peer_number, data, data_size, _private, true);
+}
+
+bool NGCEXTEventProvider::parse_ft1_data_ack(
+	uint32_t group_number, uint32_t peer_number,
+	const uint8_t* data, size_t data_size,
+	bool _private, bool wide
 ) {
 	if (!_private) {
 		std::cerr << "NGCEXT: ft1_data_ack cant be public\n";
@@ -235,17 +300,19 @@ bool NGCEXTEventProvider::parse_ft1_data_ack(
 	e.peer_number = peer_number;
 	size_t curser = 0;
 
-	// - 1 byte (temporary_file_tf_id)
-	_DATA_HAVE(sizeof(e.transfer_id), std::cerr << "NGCEXT: packet too small, missing transfer_id\n"; return false)
-	e.transfer_id = data[curser++];
+	// - 1 or 2 bytes (temporary_file_tf_id)
+	if (!read_transfer_id(data, data_size, curser, wide, e.transfer_id)) {
+		return false;
+	}
 
-	e.sequence_ids.reserve(std::max<int64_t>(data_size-curser, 1)/sizeof(uint16_t));
-	while (curser < data_size) {
-		_DATA_HAVE(sizeof(uint16_t), std::cerr << "NGCEXT: packet too small, missing seq_id\n"; return false)
-		uint16_t seq_id = data[curser++];
-		seq_id |= data[curser++] << (1*8);
-		e.sequence_ids.push_back(seq_id);
+	// - array [ (of sequece ids)
+	//   - 2 bytes (sequece id)
+	// - ]
+	if ((data_size - curser) % sizeof(uint16_t) != 0) {
+		std::cerr << "NGCEXT: packet too small, missing seq_id\n";
+		return false;
 	}
+	e.sequence_ids = {ByteSpan{data+curser, data_size-curser}};
 
 	return dispatch(
 		NGCEXT_Event::FT1_DATA_ACK,
@@ -253,6 +320,188 @@ bool NGCEXTEventProvider::parse_ft1_data_ack(
 	);
 }
 
+bool NGCEXTEventProvider::parse_ft1_data_sack(
+	uint32_t group_number, uint32_t peer_number,
+	const uint8_t* data, size_t data_size,
+	bool _private
+) {
+	return parse_ft1_data_sack(group_number, peer_number, data, data_size, _private, false);
+}
+
+bool NGCEXTEventProvider::parse_ft1_data_sack_wide(
+	uint32_t group_number, uint32_t peer_number,
+	const uint8_t* data, size_t data_size,
+	bool _private
+) {
+	return parse_ft1_data_sack(group_number, peer_number, data, data_size, _private, true);
+}
+
+bool NGCEXTEventProvider::parse_ft1_data_sack(
+	uint32_t group_number, uint32_t peer_number,
+	const uint8_t* data, size_t data_size,
+	bool _private, bool wide
+) {
+	if (!_private) {
+		std::cerr << "NGCEXT: ft1_data_sack cant be public\n";
+		return false;
+	}
+
+	Events::NGCEXT_ft1_data_sack e;
+	e.group_number = group_number;
+	e.peer_number = peer_number;
+	size_t curser = 0;
+
+	// - 1 or 2 bytes (temporary_file_tf_id)
+	if (!read_transfer_id(data, data_size, curser, wide, e.transfer_id)) {
+		return false;
+	}
+
+	// - 2 bytes (next_sequence_id)
+	e.next_sequence_id = 0u;
+	_DATA_HAVE(sizeof(e.next_sequence_id), std::cerr << "NGCEXT: packet too small, missing next_sequence_id\n"; return false)
+	for (size_t i = 0; i < sizeof(e.next_sequence_id); i++, curser++) {
+		e.next_sequence_id |= uint16_t(data[curser]) << (i*8);
+	}
+
+	// - X bytes (sack bitset)
+	e.sack_bitset = ByteSpan{data+curser, data_size-curser};
+
+	return dispatch(
+		NGCEXT_Event::FT1_DATA_SACK,
+		e
+	);
+}
+
+bool NGCEXTEventProvider::parse_ft1_data_fec(
+	uint32_t group_number, uint32_t peer_number,
+	const uint8_t* data, size_t data_size,
+	bool _private
+) {
+	return parse_ft1_data_fec(group_number, peer_number, data, data_size, _private, false);
+}
+
+bool NGCEXTEventProvider::parse_ft1_data_fec_wide(
+	uint32_t group_number, uint32_t peer_number,
+	const uint8_t* data, size_t data_size,
+	bool _private
+) {
+	return parse_ft1_data_fec(group_number, peer_number, data, data_size, _private, true);
+}
+
+bool NGCEXTEventProvider::parse_ft1_data_fec(
+	uint32_t group_number, uint32_t peer_number,
+	const uint8_t* data, size_t data_size,
+	bool _private, bool wide
+) {
+	if (!_private) {
+		std::cerr << "NGCEXT: ft1_data_fec cant be public\n";
+		return false;
+	}
+
+	Events::NGCEXT_ft1_data_fec e;
+	e.group_number = group_number;
+	e.peer_number = peer_number;
+	size_t curser = 0;
+
+	// - 1 or 2 bytes (temporary_file_tf_id)
+	if (!read_transfer_id(data, data_size, curser, wide, e.transfer_id)) {
+		return false;
+	}
+
+	// - 2 bytes (first_sequence_id)
+	e.first_sequence_id = 0u;
+	_DATA_HAVE(sizeof(e.first_sequence_id), std::cerr << "NGCEXT: packet too small, missing first_sequence_id\n"; return false)
+	for (size_t i = 0; i < sizeof(e.first_sequence_id); i++, curser++) {
+		e.first_sequence_id |= uint16_t(data[curser]) << (i*8);
+	}
+
+	// - 1 byte (count)
+	_DATA_HAVE(sizeof(e.count), std::cerr << "NGCEXT: packet too small, missing count\n"; return false)
+	e.count = data[curser++];
+
+	// - 2 bytes (size_xor)
+	e.size_xor = 0u;
+	_DATA_HAVE(sizeof(e.size_xor), std::cerr << "NGCEXT: packet too small, missing size_xor\n"; return false)
+	for (size_t i = 0; i < sizeof(e.size_xor); i++, curser++) {
+		e.size_xor |= uint16_t(data[curser]) << (i*8);
+	}
+
+	// - X bytes (parity)
+	e.parity = ByteSpan{data+curser, data_size-curser};
+
+	return dispatch(
+		NGCEXT_Event::FT1_DATA_FEC,
+		e
+	);
+}
+
+bool NGCEXTEventProvider::parse_ft1_mtu_probe(
+	uint32_t group_number, uint32_t peer_number,
+	const uint8_t* data, size_t data_size,
+	bool _private
+) {
+	if (!_private) {
+		std::cerr << "NGCEXT: ft1_mtu_probe cant be public\n";
+		return false;
+	}
+
+	Events::NGCEXT_ft1_mtu_probe e;
+	e.group_number = group_number;
+	e.peer_number = peer_number;
+	size_t curser = 0;
+
+	// - 1 byte (probe_id)
+	_DATA_HAVE(sizeof(e.probe_id), std::cerr << "NGCEXT: packet too small, missing probe_id\n"; return false)
+	e.probe_id = data[curser++];
+
+	// - 2 bytes (probe_size)
+	e.probe_size = 0u;
+	_DATA_HAVE(sizeof(e.probe_size), std::cerr << "NGCEXT: packet too small, missing probe_size\n"; return false)
+	for (size_t i = 0; i < sizeof(e.probe_size); i++, curser++) {
+		e.probe_size |= uint16_t(data[curser]) << (i*8);
+	}
+
+	// - X bytes (padding)
+	e.padding = ByteSpan{data+curser, data_size-curser};
+
+	return dispatch(
+		NGCEXT_Event::FT1_MTU_PROBE,
+		e
+	);
+}
+
+bool NGCEXTEventProvider::parse_ft1_mtu_probe_ack(
+	uint32_t group_number, uint32_t peer_number,
+	const uint8_t* data, size_t data_size,
+	bool _private
+) {
+	if (!_private) {
+		std::cerr << "NGCEXT: ft1_mtu_probe_ack cant be public\n";
+		return false;
+	}
+
+	Events::NGCEXT_ft1_mtu_probe_ack e;
+	e.group_number = group_number;
+	e.peer_number = peer_number;
+	size_t curser = 0;
+
+	// - 1 byte (probe_id)
+	_DATA_HAVE(sizeof(e.probe_id), std::cerr << "NGCEXT: packet too small, missing probe_id\n"; return false)
+	e.probe_id = data[curser++];
+
+	// - 2 bytes (probe_size)
+	e.probe_size = 0u;
+	_DATA_HAVE(sizeof(e.probe_size), std::cerr << "NGCEXT: packet too small, missing probe_size\n"; return false)
+	for (size_t i = 0; i < sizeof(e.probe_size); i++, curser++) {
+		e.probe_size |= uint16_t(data[curser]) << (i*8);
+	}
+
+	return dispatch(
+		NGCEXT_Event::FT1_MTU_PROBE_ACK,
+		e
+	);
+}
+
 bool NGCEXTEventProvider::parse_ft1_message(
 	uint32_t group_number, uint32_t peer_number,
 	const uint8_t* data, size_t data_size,
@@ -283,7 +532,7 @@ bool NGCEXTEventProvider::parse_ft1_message(
 	}
 
 	// - X bytes (file_kind dependent id, differnt sizes)
-	e.file_id = {data+curser, data+curser+(data_size-curser)};
+	e.file_id = ByteSpan{data+curser, data_size-curser};
 
 	return dispatch(
 		NGCEXT_Event::FT1_MESSAGE,
@@ -322,20 +571,17 @@ bool NGCEXTEventProvider::parse_ft1_have(
 
 	_DATA_HAVE(file_id_size, std::cerr << "NGCEXT: packet too small, missing file_id, or file_id_size too large(" << data_size-curser << ")\n"; return false)
 
-	e.file_id = {data+curser, data+curser+file_id_size};
+	e.file_id = ByteSpan{data+curser, file_id_size};
 	curser += file_id_size;
 
 	// - array [
 	//   - 4 bytes (chunk index)
 	// - ]
-	while (curser < data_size) {
-		_DATA_HAVE(sizeof(uint32_t), std::cerr << "NGCEXT: packet too small, broken chunk index\n"; return false)
-		uint32_t chunk_index = 0u;
-		for (size_t i = 0; i < sizeof(chunk_index); i++, curser++) {
-			chunk_index |= uint32_t(data[curser]) << (i*8);
-		}
-		e.chunks.push_back(chunk_index);
+	if ((data_size - curser) % sizeof(uint32_t) != 0) {
+		std::cerr << "NGCEXT: packet too small, broken chunk index\n";
+		return false;
 	}
+	e.chunks = {ByteSpan{data+curser, data_size-curser}};
 
 	return dispatch(
 		NGCEXT_Event::FT1_HAVE,
@@ -374,7 +620,7 @@ bool NGCEXTEventProvider::parse_ft1_bitset(
 
 	_DATA_HAVE(file_id_size, std::cerr << "NGCEXT: packet too small, missing file_id, or file_id_size too large (" << data_size-curser << ")\n"; return false)
 
-	e.file_id = {data+curser, data+curser+file_id_size};
+	e.file_id = ByteSpan{data+curser, file_id_size};
 	curser += file_id_size;
 
 	e.start_chunk = 0u;
@@ -389,7 +635,7 @@ bool NGCEXTEventProvider::parse_ft1_bitset(
 	// - ] (filled up with zero)
 	// high to low?
 	// simply rest of file packet
-	e.chunk_bitset = {data+curser, data+curser+(data_size-curser)};
+	e.chunk_bitset = ByteSpan{data+curser, data_size-curser};
 
 	return dispatch(
 		NGCEXT_Event::FT1_BITSET,
@@ -420,7 +666,7 @@ bool NGCEXTEventProvider::parse_ft1_have_all(
 	_DATA_HAVE(1, std::cerr << "NGCEXT: packet too small, missing file_id\n"; return false)
 
 	// - X bytes (file_id, differnt sizes)
-	e.file_id = {data+curser, data+curser+(data_size-curser)};
+	e.file_id = ByteSpan{data+curser, data_size-curser};
 
 	return dispatch(
 		NGCEXT_Event::FT1_HAVE_ALL,
@@ -432,6 +678,22 @@ bool NGCEXTEventProvider::parse_ft1_init2(
 	uint32_t group_number, uint32_t peer_number,
 	const uint8_t* data, size_t data_size,
 	bool _private
+) {
+	return parse_ft1_init2(group_number, peer_number, data, data_size, _private, false);
+}
+
+bool NGCEXTEventProvider::parse_ft1_init3(
+	uint32_t group_number, uint32_t peer_number,
+	const uint8_t* data, size_t data_size,
+	bool _private
+) {
+	return parse_ft1_init2(group_number, peer_number, data, data_size, _private, true);
+}
+
+bool NGCEXTEventProvider::parse_ft1_init2(
+	uint32_t group_number, uint32_t peer_number,
+	const uint8_t* data, size_t data_size,
+	bool _private, bool wide
 ) {
 	if (!_private) {
 		std::cerr << "NGCEXT: ft1_init2 cant be public\n";
@@ -457,16 +719,17 @@ bool NGCEXTEventProvider::parse_ft1_init2(
 		e.file_size |= uint64_t(data[curser]) << (i*8);
 	}
 
-	// - 1 byte (temporary_file_tf_id)
-	_DATA_HAVE(sizeof(e.transfer_id), std::cerr << "NGCEXT: packet too small, missing transfer_id\n"; return false)
-	e.transfer_id = data[curser++];
+	// - 1 or 2 bytes (temporary_file_tf_id)
+	if (!read_transfer_id(data, data_size, curser, wide, e.transfer_id)) {
+		return false;
+	}
 
 	// - 1 byte feature flags
 	_DATA_HAVE(sizeof(e.feature_flags), std::cerr << "NGCEXT: packet too small, missing feature_flags\n"; return false)
 	e.feature_flags = data[curser++];
 
 	// - X bytes (file_kind dependent id, differnt sizes)
-	e.file_id = {data+curser, data+curser+(data_size-curser)};
+	e.file_id = ByteSpan{data+curser, data_size-curser};
 
 	return dispatch(
 		NGCEXT_Event::FT1_INIT2,
@@ -486,7 +749,7 @@ bool NGCEXTEventProvider::parse_pc1_announce(
 	size_t curser = 0;
 
 	// - X bytes (id, differnt sizes)
-	e.id = {data+curser, data+curser+(data_size-curser)};
+	e.id = ByteSpan{data+curser, data_size-curser};
 
 	return dispatch(
 		NGCEXT_Event::PC1_ANNOUNCE,
@@ -494,61 +757,113 @@ bool NGCEXTEventProvider::parse_pc1_announce(
 	);
 }
 
-bool NGCEXTEventProvider::handlePacket(
+const std::array<NGCEXTEventProvider::ParseFn, 256>& NGCEXTEventProvider::handlerTableOld(void) {
+	static const std::array<ParseFn, 256> table = [](void) {
+		std::array<ParseFn, 256> t{};
+		// HS1_REQUEST_LAST_IDS and HS1_RESPONSE_LAST_IDS are not handled
+		t[static_cast<uint8_t>(NGCEXT_Event_old::FT1_REQUEST)] = &NGCEXTEventProvider::parse_ft1_request;
+		t[static_cast<uint8_t>(NGCEXT_Event_old::FT1_INIT)] = &NGCEXTEventProvider::parse_ft1_init;
+		//t[static_cast<uint8_t>(NGCEXT_Event_old::FT1_INIT_ACK)] = &NGCEXTEventProvider::parse_ft1_init_ack;
+		//t[static_cast<uint8_t>(NGCEXT_Event_old::FT1_INIT_ACK)] = &NGCEXTEventProvider::parse_ft1_init_ack_v2;
+		t[static_cast<uint8_t>(NGCEXT_Event_old::FT1_INIT_ACK)] = &NGCEXTEventProvider::parse_ft1_init_ack_v3;
+		t[static_cast<uint8_t>(NGCEXT_Event_old::FT1_DATA)] = &NGCEXTEventProvider::parse_ft1_data;
+		t[static_cast<uint8_t>(NGCEXT_Event_old::FT1_DATA_ACK)] = &NGCEXTEventProvider::parse_ft1_data_ack;
+		t[static_cast<uint8_t>(NGCEXT_Event_old::FT1_MESSAGE)] = &NGCEXTEventProvider::parse_ft1_message;
+		t[static_cast<uint8_t>(NGCEXT_Event_old::FT1_HAVE)] = &NGCEXTEventProvider::parse_ft1_have;
+		t[static_cast<uint8_t>(NGCEXT_Event_old::FT1_BITSET)] = &NGCEXTEventProvider::parse_ft1_bitset;
+		t[static_cast<uint8_t>(NGCEXT_Event_old::FT1_HAVE_ALL)] = &NGCEXTEventProvider::parse_ft1_have_all;
+		t[static_cast<uint8_t>(NGCEXT_Event_old::FT1_INIT2)] = &NGCEXTEventProvider::parse_ft1_init2;
+		t[static_cast<uint8_t>(NGCEXT_Event_old::FT1_DATA_SACK)] = &NGCEXTEventProvider::parse_ft1_data_sack;
+		t[static_cast<uint8_t>(NGCEXT_Event_old::FT1_MTU_PROBE)] = &NGCEXTEventProvider::parse_ft1_mtu_probe;
+		t[static_cast<uint8_t>(NGCEXT_Event_old::FT1_MTU_PROBE_ACK)] = &NGCEXTEventProvider::parse_ft1_mtu_probe_ack;
+		t[static_cast<uint8_t>(NGCEXT_Event_old::FT1_DATA_FEC)] = &NGCEXTEventProvider::parse_ft1_data_fec;
+		t[static_cast<uint8_t>(NGCEXT_Event_old::FT1_INIT3)] = &NGCEXTEventProvider::parse_ft1_init3;
+		t[static_cast<uint8_t>(NGCEXT_Event_old::FT1_INIT_ACK_WIDE)] = &NGCEXTEventProvider::parse_ft1_init_ack_wide;
+		t[static_cast<uint8_t>(NGCEXT_Event_old::FT1_DATA_WIDE)] = &NGCEXTEventProvider::parse_ft1_data_wide;
+		t[static_cast<uint8_t>(NGCEXT_Event_old::FT1_DATA_ACK_WIDE)] = &NGCEXTEventProvider::parse_ft1_data_ack_wide;
+		t[static_cast<uint8_t>(NGCEXT_Event_old::FT1_DATA_SACK_WIDE)] = &NGCEXTEventProvider::parse_ft1_data_sack_wide;
+		t[static_cast<uint8_t>(NGCEXT_Event_old::FT1_DATA_FEC_WIDE)] = &NGCEXTEventProvider::parse_ft1_data_fec_wide;
+		t[static_cast<uint8_t>(NGCEXT_Event_old::PC1_ANNOUNCE)] = &NGCEXTEventProvider::parse_pc1_announce;
+		return t;
+	}();
+	return table;
+}
+
+const std::array<NGCEXTEventProvider::ParseFn, 256>& NGCEXTEventProvider::handlerTableNew(void) {
+	static const std::array<ParseFn, 256> table = [](void) {
+		std::array<ParseFn, 256> t{};
+		t[static_cast<uint8_t>(NGCEXT_Event_new::FT1_REQUEST)] = &NGCEXTEventProvider::parse_ft1_request;
+		t[static_cast<uint8_t>(NGCEXT_Event_new::FT1_INIT)] = &NGCEXTEventProvider::parse_ft1_init;
+		t[static_cast<uint8_t>(NGCEXT_Event_new::FT1_INIT2)] = &NGCEXTEventProvider::parse_ft1_init2;
+		t[static_cast<uint8_t>(NGCEXT_Event_new::FT1_INIT_ACK)] = &NGCEXTEventProvider::parse_ft1_init_ack_v3;
+		t[static_cast<uint8_t>(NGCEXT_Event_new::FT1_DATA)] = &NGCEXTEventProvider::parse_ft1_data;
+		t[static_cast<uint8_t>(NGCEXT_Event_new::FT1_DATA_ACK)] = &NGCEXTEventProvider::parse_ft1_data_ack;
+		t[static_cast<uint8_t>(NGCEXT_Event_new::FT1_MESSAGE)] = &NGCEXTEventProvider::parse_ft1_message;
+		t[static_cast<uint8_t>(NGCEXT_Event_new::FT1_HAVE)] = &NGCEXTEventProvider::parse_ft1_have;
+		t[static_cast<uint8_t>(NGCEXT_Event_new::FT1_BITSET)] = &NGCEXTEventProvider::parse_ft1_bitset;
+		t[static_cast<uint8_t>(NGCEXT_Event_new::FT1_HAVE_ALL)] = &NGCEXTEventProvider::parse_ft1_have_all;
+		t[static_cast<uint8_t>(NGCEXT_Event_new::FT1_DATA_SACK)] = &NGCEXTEventProvider::parse_ft1_data_sack;
+		t[static_cast<uint8_t>(NGCEXT_Event_new::FT1_MTU_PROBE)] = &NGCEXTEventProvider::parse_ft1_mtu_probe;
+		t[static_cast<uint8_t>(NGCEXT_Event_new::FT1_MTU_PROBE_ACK)] = &NGCEXTEventProvider::parse_ft1_mtu_probe_ack;
+		t[static_cast<uint8_t>(NGCEXT_Event_new::FT1_DATA_FEC)] = &NGCEXTEventProvider::parse_ft1_data_fec;
+		t[static_cast<uint8_t>(NGCEXT_Event_new::FT1_INIT3)] = &NGCEXTEventProvider::parse_ft1_init3;
+		t[static_cast<uint8_t>(NGCEXT_Event_new::FT1_INIT_ACK_WIDE)] = &NGCEXTEventProvider::parse_ft1_init_ack_wide;
+		t[static_cast<uint8_t>(NGCEXT_Event_new::FT1_DATA_WIDE)] = &NGCEXTEventProvider::parse_ft1_data_wide;
+		t[static_cast<uint8_t>(NGCEXT_Event_new::FT1_DATA_ACK_WIDE)] = &NGCEXTEventProvider::parse_ft1_data_ack_wide;
+		t[static_cast<uint8_t>(NGCEXT_Event_new::FT1_DATA_SACK_WIDE)] = &NGCEXTEventProvider::parse_ft1_data_sack_wide;
+		t[static_cast<uint8_t>(NGCEXT_Event_new::FT1_DATA_FEC_WIDE)] = &NGCEXTEventProvider::parse_ft1_data_fec_wide;
+		t[static_cast<uint8_t>(NGCEXT_Event_new::PC1_ANNOUNCE)] = &NGCEXTEventProvider::parse_pc1_announce;
+		return t;
+	}();
+	return table;
+}
+
+void NGCEXTEventProvider::PacketTypeStats::addTime(uint64_t ns) {
+	time_total_ns += ns;
+
+	// log2 buckets of microseconds, 0 is <1us, last is everything above
+	uint64_t us = ns / 1000;
+	size_t bucket = 0;
+	while (us > 0 && bucket < time_hist.size()-1) {
+		us >>= 1;
+		bucket++;
+	}
+	time_hist[bucket]++;
+}
+
+bool NGCEXTEventProvider::runHandler(
+	ParseFn fn,
+	PacketTypeStats& stats,
 	const uint32_t group_number,
 	const uint32_t peer_number,
 	const uint8_t* data,
 	const size_t data_size,
-	const bool _private
+	const bool _private,
+	const bool has_fallback
 ) {
-	if (handlePacket_old(group_number, peer_number, data, data_size, _private)) {
-		return true;
+	if (!_collect_stats) {
+		return (this->*fn)(group_number, peer_number, data, data_size, _private);
 	}
 
-	if (data_size < 2) {
-		return false; // waht
-	}
+	const auto time_start = std::chrono::steady_clock::now();
+	const bool ret = (this->*fn)(group_number, peer_number, data, data_size, _private);
+	const auto time_end = std::chrono::steady_clock::now();
 
-	// pkg id is 2 bytes and green rage starts with 0x90
-	if (data[0] != 0x90) {
+	if (!ret && has_fallback) {
 		return false;
 	}
 
-	NGCEXT_Event_new pkg_type = static_cast<NGCEXT_Event_new>(data[1]);
-
-	switch (pkg_type) {
-		case NGCEXT_Event_new::FT1_REQUEST:
-			return parse_ft1_request(group_number, peer_number, data+2, data_size-2, _private);
-		case NGCEXT_Event_new::FT1_INIT:
-			return parse_ft1_init(group_number, peer_number, data+2, data_size-2, _private);
-		case NGCEXT_Event_new::FT1_INIT2:
-			return parse_ft1_init2(group_number, peer_number, data+2, data_size-2, _private);
-		case NGCEXT_Event_new::FT1_INIT_ACK:
-			//return parse_ft1_init_ack(group_number, peer_number, data+2, data_size-2, _private);
-			//return parse_ft1_init_ack_v2(group_number, peer_number, data+2, data_size-2, _private);
-			return parse_ft1_init_ack_v3(group_number, peer_number, data+2, data_size-2, _private);
-		case NGCEXT_Event_new::FT1_DATA:
-			return parse_ft1_data(group_number, peer_number, data+2, data_size-2, _private);
-		case NGCEXT_Event_new::FT1_DATA_ACK:
-			return parse_ft1_data_ack(group_number, peer_number, data+2, data_size-2, _private);
-		case NGCEXT_Event_new::FT1_MESSAGE:
-			return parse_ft1_message(group_number, peer_number, data+2, data_size-2, _private);
-		case NGCEXT_Event_new::FT1_HAVE:
-			return parse_ft1_have(group_number, peer_number, data+2, data_size-2, _private);
-		case NGCEXT_Event_new::FT1_BITSET:
-			return parse_ft1_bitset(group_number, peer_number, data+2, data_size-2, _private);
-		case NGCEXT_Event_new::FT1_HAVE_ALL:
-			return parse_ft1_have_all(group_number, peer_number, data+2, data_size-2, _private);
-		case NGCEXT_Event_new::PC1_ANNOUNCE:
-			return parse_pc1_announce(group_number, peer_number, data+2, data_size-2, _private);
-		default:
-			return false;
+	stats.count++;
+	stats.bytes += data_size;
+	if (!ret) {
+		stats.count_unhandled++;
 	}
+	stats.addTime(std::chrono::duration_cast<std::chrono::nanoseconds>(time_end - time_start).count());
 
-	return false;
+	return ret;
 }
 
-bool NGCEXTEventProvider::handlePacket_old(
+bool NGCEXTEventProvider::handlePacket(
 	const uint32_t group_number,
 	const uint32_t peer_number,
 	const uint8_t* data,
@@ -559,44 +874,142 @@ bool NGCEXTEventProvider::handlePacket_old(
 		return false; // waht
 	}
 
-	NGCEXT_Event pkg_type = static_cast<NGCEXT_Event>(data[0]);
-
-	switch (pkg_type) {
-		case NGCEXT_Event_old::HS1_REQUEST_LAST_IDS:
-			return false;
-		case NGCEXT_Event_old::HS1_RESPONSE_LAST_IDS:
-			return false;
-		case NGCEXT_Event_old::FT1_REQUEST:
-			return parse_ft1_request(group_number, peer_number, data+1, data_size-1, _private);
-		case NGCEXT_Event_old::FT1_INIT:
-			return parse_ft1_init(group_number, peer_number, data+1, data_size-1, _private);
-		case NGCEXT_Event_old::FT1_INIT_ACK:
-			//return parse_ft1_init_ack(group_number, peer_number, data+1, data_size-1, _private);
-			//return parse_ft1_init_ack_v2(group_number, peer_number, data+1, data_size-1, _private);
-			return parse_ft1_init_ack_v3(group_number, peer_number, data+1, data_size-1, _private);
-		case NGCEXT_Event_old::FT1_DATA:
-			return parse_ft1_data(group_number, peer_number, data+1, data_size-1, _private);
-		case NGCEXT_Event_old::FT1_DATA_ACK:
-			return parse_ft1_data_ack(group_number, peer_number, data+1, data_size-1, _private);
-		case NGCEXT_Event_old::FT1_MESSAGE:
-			return parse_ft1_message(group_number, peer_number, data+1, data_size-1, _private);
-		case NGCEXT_Event_old::FT1_HAVE:
-			return parse_ft1_have(group_number, peer_number, data+1, data_size-1, _private);
-		case NGCEXT_Event_old::FT1_BITSET:
-			return parse_ft1_bitset(group_number, peer_number, data+1, data_size-1, _private);
-		case NGCEXT_Event_old::FT1_HAVE_ALL:
-			return parse_ft1_have_all(group_number, peer_number, data+1, data_size-1, _private);
-		case NGCEXT_Event_old::FT1_INIT2:
-			return parse_ft1_init2(group_number, peer_number, data+1, data_size-1, _private);
-		case NGCEXT_Event_old::PC1_ANNOUNCE:
-			return parse_pc1_announce(group_number, peer_number, data+1, data_size-1, _private);
-		default:
+	// pkg id is 2 bytes and green rage starts with 0x90
+	// NOTE: old FT1_HAVE_ALL is 0x90 too, so it only gets a try if the second byte is not a known new id
+	// (or the new handler rejected it)
+	if (data_size >= 2 && data[0] == 0x90) {
+		if (const auto fn = handlerTableNew()[data[1]]; fn != nullptr) {
+			const auto fn_old = _legacy_packets ? handlerTableOld()[0x90] : nullptr;
+			if (runHandler(fn, _packet_stats.new_ids[data[1]], group_number, peer_number, data+2, data_size-2, _private, fn_old != nullptr)) {
+				return true;
+			}
+			if (fn_old == nullptr) {
+				return false;
+			}
+
+			if (runHandler(fn_old, _packet_stats.old_ids[0x90], group_number, peer_number, data+1, data_size-1, _private, true)) {
+				return true;
+			}
+
+			// neither took it, count it where it most likely belongs
+			if (_collect_stats) {
+				auto& stats = _packet_stats.new_ids[data[1]];
+				stats.count++;
+				stats.bytes += data_size-2;
+				stats.count_unhandled++;
+			}
 			return false;
+		}
+	}
+
+	// old pkg ids are 1 byte
+	if (_legacy_packets) {
+		if (const auto fn = handlerTableOld()[data[0]]; fn != nullptr) {
+			return runHandler(fn, _packet_stats.old_ids[data[0]], group_number, peer_number, data+1, data_size-1, _private);
+		}
 	}
 
 	return false;
 }
 
+void NGCEXTEventProvider::setLegacyPacketsEnabled(bool enabled) {
+	_legacy_packets = enabled;
+}
+
+void NGCEXTEventProvider::setCollectStats(bool enabled) {
+	_collect_stats = enabled;
+}
+
+const NGCEXTEventProvider::PacketStats& NGCEXTEventProvider::getPacketStats(void) const {
+	return _packet_stats;
+}
+
+void NGCEXTEventProvider::resetPacketStats(void) {
+	_packet_stats = {};
+}
+
+// reused for every packet we send, keeps its capacity
+// per thread, the private sends can happen on multiple threads
+static thread_local std::vector<uint8_t> tl_pkg_buffer;
+
+NGCEXTSendQueue::NGCEXTSendQueue(size_t capacity) : _slots(capacity) {
+	for (auto& slot : _slots) {
+		slot.data.reserve(max_packet_size);
+	}
+}
+
+bool NGCEXTSendQueue::push(uint32_t group_number, uint32_t peer_number, bool lossless, const std::vector<uint8_t>& pkg) {
+	if (_count >= _slots.size() || pkg.size() > max_packet_size) {
+		return false;
+	}
+
+	auto& slot = _slots[_count++];
+	slot.group_number = group_number;
+	slot.peer_number = peer_number;
+	slot.lossless = lossless;
+	slot.data.assign(pkg.cbegin(), pkg.cend()); // fits the reserved capacity
+
+	return true;
+}
+
+// see setThreadSendQueue()
+static thread_local NGCEXTSendQueue* tl_send_queue {nullptr};
+
+void NGCEXTEventProvider::setThreadSendQueue(NGCEXTSendQueue* queue) {
+	tl_send_queue = queue;
+}
+
+bool NGCEXTEventProvider::sendCustomPrivatePacket(uint32_t group_number, uint32_t peer_number, bool lossless, const std::vector<uint8_t>& pkg) {
+	if (tl_send_queue != nullptr) {
+		return tl_send_queue->push(group_number, peer_number, lossless, pkg);
+	}
+
+	return _t.toxGroupSendCustomPrivatePacket(group_number, peer_number, lossless, pkg) == TOX_ERR_GROUP_SEND_CUSTOM_PRIVATE_PACKET_OK;
+}
+
+// writes into a (reused) buffer, using bulk copies
+// the buffer keeps its capacity across packets, so no allocations after warmup
+struct PacketWriter {
+	std::vector<uint8_t>& pkg;
+
+	PacketWriter(std::vector<uint8_t>& buffer, size_t size_hint) : pkg(buffer) {
+		pkg.clear();
+		pkg.reserve(size_hint);
+	}
+
+	template<typename T>
+	void writeLE(const T value) {
+		static_assert(std::is_integral_v<T>);
+		uint8_t bytes[sizeof(T)];
+		for (size_t i = 0; i < sizeof(T); i++) {
+			bytes[i] = (value >> (i*8)) & 0xff;
+		}
+		pkg.insert(pkg.end(), bytes, bytes+sizeof(T));
+	}
+
+	void writePkgID(const NGCEXT_Event pkg_id) {
+		pkg.push_back(static_cast<uint8_t>(pkg_id));
+	}
+
+	// 1 byte, or 2 bytes for ids that need the wide packets
+	void writeTransferID(const uint16_t transfer_id) {
+		if (transfer_id > 0xff) {
+			writeLE(transfer_id);
+		} else {
+			writeLE(static_cast<uint8_t>(transfer_id));
+		}
+	}
+
+	void write(const uint8_t* data, size_t data_size) {
+		if (data_size == 0) {
+			return;
+		}
+		const size_t offset = pkg.size();
+		pkg.resize(offset + data_size);
+		std::memcpy(pkg.data() + offset, data, data_size);
+	}
+};
+
 bool NGCEXTEventProvider::send_ft1_request(
 	uint32_t group_number, uint32_t peer_number,
 	uint32_t file_kind,
@@ -605,17 +1018,13 @@ bool NGCEXTEventProvider::send_ft1_request(
 	// - 1 byte packet id
 	// - 4 byte file_kind
 	// - X bytes file_id
-	std::vector<uint8_t> pkg;
-	pkg.push_back(static_cast<uint8_t>(NGCEXT_Event::FT1_REQUEST));
-	for (size_t i = 0; i < sizeof(file_kind); i++) {
-		pkg.push_back((file_kind>>(i*8)) & 0xff);
-	}
-	for (size_t i = 0; i < file_id_size; i++) {
-		pkg.push_back(file_id[i]);
-	}
+	PacketWriter pw{tl_pkg_buffer, 1+sizeof(file_kind)+file_id_size};
+	pw.writePkgID(NGCEXT_Event::FT1_REQUEST);
+	pw.writeLE(file_kind);
+	pw.write(file_id, file_id_size);
 
 	// lossless
-	return _t.toxGroupSendCustomPrivatePacket(group_number, peer_number, true, pkg) == TOX_ERR_GROUP_SEND_CUSTOM_PRIVATE_PACKET_OK;
+	return sendCustomPrivatePacket(group_number, peer_number, true, pw.pkg);
 }
 
 bool NGCEXTEventProvider::send_ft1_init(
@@ -631,46 +1040,42 @@ bool NGCEXTEventProvider::send_ft1_init(
 	// - 1 byte (temporary_file_tf_id, for this peer only, technically just a prefix to distinguish between simultainious fts)
 	// - X bytes (file_kind dependent id, differnt sizes)
 
-	std::vector<uint8_t> pkg;
-	pkg.push_back(static_cast<uint8_t>(NGCEXT_Event::FT1_INIT));
-	for (size_t i = 0; i < sizeof(file_kind); i++) {
-		pkg.push_back((file_kind>>(i*8)) & 0xff);
-	}
-	for (size_t i = 0; i < sizeof(file_size); i++) {
-		pkg.push_back((file_size>>(i*8)) & 0xff);
-	}
-	pkg.push_back(transfer_id);
-	for (size_t i = 0; i < file_id_size; i++) {
-		pkg.push_back(file_id[i]);
-	}
+	PacketWriter pw{tl_pkg_buffer, 1+sizeof(file_kind)+sizeof(file_size)+1+file_id_size};
+	pw.writePkgID(NGCEXT_Event::FT1_INIT);
+	pw.writeLE(file_kind);
+	pw.writeLE(file_size);
+	pw.writeLE(transfer_id);
+	pw.write(file_id, file_id_size);
 
 	// lossless
-	return _t.toxGroupSendCustomPrivatePacket(group_number, peer_number, true, pkg) == TOX_ERR_GROUP_SEND_CUSTOM_PRIVATE_PACKET_OK;
+	return sendCustomPrivatePacket(group_number, peer_number, true, pw.pkg);
 }
 
 bool NGCEXTEventProvider::send_ft1_init_ack(
 	uint32_t group_number, uint32_t peer_number,
-	uint8_t transfer_id
+	uint16_t transfer_id,
+	uint8_t feature_flags
 ) {
 	// - 1 byte packet id
-	// - 1 byte transfer_id
-	std::vector<uint8_t> pkg;
-	pkg.push_back(static_cast<uint8_t>(NGCEXT_Event::FT1_INIT_ACK));
-	pkg.push_back(transfer_id);
+	// - 1 byte transfer_id (2 bytes wide)
+	PacketWriter pw{tl_pkg_buffer, 1+2+sizeof(uint16_t)+1};
+	pw.writePkgID(transfer_id > 0xff ? NGCEXT_Event::FT1_INIT_ACK_WIDE : NGCEXT_Event::FT1_INIT_ACK);
+	pw.writeTransferID(transfer_id);
 
 	// - 2 bytes max_lossy_data_size
 	const uint16_t max_lossy_data_size = _t.toxGroupMaxCustomLossyPacketLength() - 4;
-	for (size_t i = 0; i < sizeof(uint16_t); i++) {
-		pkg.push_back((max_lossy_data_size>>(i*8)) & 0xff);
-	}
+	pw.writeLE(max_lossy_data_size);
+
+	// - 1 byte feature_flags (v3)
+	pw.writeLE(feature_flags);
 
 	// lossless
-	return _t.toxGroupSendCustomPrivatePacket(group_number, peer_number, true, pkg) == TOX_ERR_GROUP_SEND_CUSTOM_PRIVATE_PACKET_OK;
+	return sendCustomPrivatePacket(group_number, peer_number, true, pw.pkg);
 }
 
 bool NGCEXTEventProvider::send_ft1_data(
 	uint32_t group_number, uint32_t peer_number,
-	uint8_t transfer_id,
+	uint16_t transfer_id,
 	uint16_t sequence_id,
 	const uint8_t* data, size_t data_size
 ) {
@@ -679,40 +1084,124 @@ bool NGCEXTEventProvider::send_ft1_data(
 	// TODO
 	// check header_size+data_size <= max pkg size
 
-	std::vector<uint8_t> pkg;
-	pkg.reserve(2048); // saves a ton of allocations
-	pkg.push_back(static_cast<uint8_t>(NGCEXT_Event::FT1_DATA));
-	pkg.push_back(transfer_id);
-	pkg.push_back(sequence_id & 0xff);
-	pkg.push_back((sequence_id >> (1*8)) & 0xff);
+	PacketWriter pw{tl_pkg_buffer, 2048}; // saves a ton of allocations
+	pw.writePkgID(transfer_id > 0xff ? NGCEXT_Event::FT1_DATA_WIDE : NGCEXT_Event::FT1_DATA);
+	pw.writeTransferID(transfer_id);
+	pw.writeLE(sequence_id);
+	pw.write(data, data_size);
+
+	// lossy
+	return sendCustomPrivatePacket(group_number, peer_number, false, pw.pkg);
+}
 
-	// TODO: optimize
-	for (size_t i = 0; i < data_size; i++) {
-		pkg.push_back(data[i]);
+size_t NGCEXTEventProvider::send_ft1_data_batch(
+	uint32_t group_number, uint32_t peer_number,
+	uint16_t transfer_id,
+	Span<FT1DataSegment> segments
+) {
+	// header is the same for all, only write once
+	PacketWriter pw{tl_pkg_buffer, 2048};
+	pw.writePkgID(transfer_id > 0xff ? NGCEXT_Event::FT1_DATA_WIDE : NGCEXT_Event::FT1_DATA);
+	pw.writeTransferID(transfer_id);
+	const size_t header_size = pw.pkg.size();
+
+	for (size_t i = 0; i < segments.size; i++) {
+		const auto& seg = segments.ptr[i];
+		assert(seg.data.size > 0);
+
+		pw.pkg.resize(header_size);
+		pw.writeLE(seg.sequence_id);
+		pw.write(seg.data.ptr, seg.data.size);
+
+		// lossy
+		if (!sendCustomPrivatePacket(group_number, peer_number, false, pw.pkg)) {
+			return i;
+		}
 	}
 
-	// lossy
-	return _t.toxGroupSendCustomPrivatePacket(group_number, peer_number, false, pkg) == TOX_ERR_GROUP_SEND_CUSTOM_PRIVATE_PACKET_OK;
+	return segments.size;
 }
 
 bool NGCEXTEventProvider::send_ft1_data_ack(
 	uint32_t group_number, uint32_t peer_number,
-	uint8_t transfer_id,
+	uint16_t transfer_id,
 	const uint16_t* seq_ids, size_t seq_ids_size
 ) {
-	std::vector<uint8_t> pkg;
-	pkg.reserve(1+1+2*32); // 32acks in a single pkg should be unlikely
-	pkg.push_back(static_cast<uint8_t>(NGCEXT_Event::FT1_DATA_ACK));
-	pkg.push_back(transfer_id);
+	PacketWriter pw{tl_pkg_buffer, 1+2+2*32}; // 32acks in a single pkg should be unlikely
+	pw.writePkgID(transfer_id > 0xff ? NGCEXT_Event::FT1_DATA_ACK_WIDE : NGCEXT_Event::FT1_DATA_ACK);
+	pw.writeTransferID(transfer_id);
 
-	// TODO: optimize
 	for (size_t i = 0; i < seq_ids_size; i++) {
-		pkg.push_back(seq_ids[i] & 0xff);
-		pkg.push_back((seq_ids[i] >> (1*8)) & 0xff);
+		pw.writeLE(seq_ids[i]);
 	}
 
 	// lossy
-	return _t.toxGroupSendCustomPrivatePacket(group_number, peer_number, false, pkg) == TOX_ERR_GROUP_SEND_CUSTOM_PRIVATE_PACKET_OK;
+	return sendCustomPrivatePacket(group_number, peer_number, false, pw.pkg);
+}
+
+bool NGCEXTEventProvider::send_ft1_data_sack(
+	uint32_t group_number, uint32_t peer_number,
+	uint16_t transfer_id,
+	uint16_t next_seq_id,
+	const uint8_t* sack_bitset_data, size_t sack_bitset_size // size is bytes
+) {
+	PacketWriter pw{tl_pkg_buffer, 1+2+sizeof(next_seq_id)+sack_bitset_size};
+	pw.writePkgID(transfer_id > 0xff ? NGCEXT_Event::FT1_DATA_SACK_WIDE : NGCEXT_Event::FT1_DATA_SACK);
+	pw.writeTransferID(transfer_id);
+	pw.writeLE(next_seq_id);
+	pw.write(sack_bitset_data, sack_bitset_size);
+
+	// lossy
+	return sendCustomPrivatePacket(group_number, peer_number, false, pw.pkg);
+}
+
+bool NGCEXTEventProvider::send_ft1_data_fec(
+	uint32_t group_number, uint32_t peer_number,
+	uint16_t transfer_id,
+	uint16_t first_seq_id,
+	uint8_t count,
+	uint16_t size_xor,
+	const uint8_t* parity, size_t parity_size
+) {
+	PacketWriter pw{tl_pkg_buffer, 1+2+sizeof(first_seq_id)+sizeof(count)+sizeof(size_xor)+parity_size};
+	pw.writePkgID(transfer_id > 0xff ? NGCEXT_Event::FT1_DATA_FEC_WIDE : NGCEXT_Event::FT1_DATA_FEC);
+	pw.writeTransferID(transfer_id);
+	pw.writeLE(first_seq_id);
+	pw.writeLE(count);
+	pw.writeLE(size_xor);
+	pw.write(parity, parity_size);
+
+	// lossy
+	return sendCustomPrivatePacket(group_number, peer_number, false, pw.pkg);
+}
+
+bool NGCEXTEventProvider::send_ft1_mtu_probe(
+	uint32_t group_number, uint32_t peer_number,
+	uint8_t probe_id,
+	uint16_t probe_size
+) {
+	PacketWriter pw{tl_pkg_buffer, 1+1+sizeof(probe_size)+probe_size};
+	pw.writePkgID(NGCEXT_Event::FT1_MTU_PROBE);
+	pw.writeLE(probe_id);
+	pw.writeLE(probe_size);
+	pw.pkg.resize(pw.pkg.size()+probe_size, 0u); // padding
+
+	// lossy
+	return sendCustomPrivatePacket(group_number, peer_number, false, pw.pkg);
+}
+
+bool NGCEXTEventProvider::send_ft1_mtu_probe_ack(
+	uint32_t group_number, uint32_t peer_number,
+	uint8_t probe_id,
+	uint16_t probe_size
+) {
+	PacketWriter pw{tl_pkg_buffer, 1+1+sizeof(probe_size)};
+	pw.writePkgID(NGCEXT_Event::FT1_MTU_PROBE_ACK);
+	pw.writeLE(probe_id);
+	pw.writeLE(probe_size);
+
+	// lossy
+	return sendCustomPrivatePacket(group_number, peer_number, false, pw.pkg);
 }
 
 bool NGCEXTEventProvider::send_all_ft1_message(
@@ -721,21 +1210,14 @@ bool NGCEXTEventProvider::send_all_ft1_message(
 	uint32_t file_kind,
 	const uint8_t* file_id, size_t file_id_size
 ) {
-	std::vector<uint8_t> pkg;
-	pkg.push_back(static_cast<uint8_t>(NGCEXT_Event::FT1_MESSAGE));
-
-	for (size_t i = 0; i < sizeof(message_id); i++) {
-		pkg.push_back((message_id>>(i*8)) & 0xff);
-	}
-	for (size_t i = 0; i < sizeof(file_kind); i++) {
-		pkg.push_back((file_kind>>(i*8)) & 0xff);
-	}
-	for (size_t i = 0; i < file_id_size; i++) {
-		pkg.push_back(file_id[i]);
-	}
+	PacketWriter pw{tl_pkg_buffer, 1+sizeof(message_id)+sizeof(file_kind)+file_id_size};
+	pw.writePkgID(NGCEXT_Event::FT1_MESSAGE);
+	pw.writeLE(message_id);
+	pw.writeLE(file_kind);
+	pw.write(file_id, file_id_size);
 
 	// lossless
-	return _t.toxGroupSendCustomPacket(group_number, true, pkg) == TOX_ERR_GROUP_SEND_CUSTOM_PACKET_OK;
+	return _t.toxGroupSendCustomPacket(group_number, true, pw.pkg) == TOX_ERR_GROUP_SEND_CUSTOM_PACKET_OK;
 }
 
 bool NGCEXTEventProvider::send_ft1_have(
@@ -750,31 +1232,22 @@ bool NGCEXTEventProvider::send_ft1_have(
 		return false;
 	}
 
-	std::vector<uint8_t> pkg;
-	pkg.push_back(static_cast<uint8_t>(NGCEXT_Event::FT1_HAVE));
-
-	for (size_t i = 0; i < sizeof(file_kind); i++) {
-		pkg.push_back((file_kind>>(i*8)) & 0xff);
-	}
+	PacketWriter pw{tl_pkg_buffer, 1+sizeof(file_kind)+sizeof(uint16_t)+file_id_size+chunks_size*sizeof(uint32_t)};
+	pw.writePkgID(NGCEXT_Event::FT1_HAVE);
+	pw.writeLE(file_kind);
 
 	// file id not last in packet, needs explicit size
 	const uint16_t file_id_size_cast = file_id_size;
-	for (size_t i = 0; i < sizeof(file_id_size_cast); i++) {
-		pkg.push_back((file_id_size_cast>>(i*8)) & 0xff);
-	}
-	for (size_t i = 0; i < file_id_size; i++) {
-		pkg.push_back(file_id[i]);
-	}
+	pw.writeLE(file_id_size_cast);
+	pw.write(file_id, file_id_size);
 
 	// rest is chunks
 	for (size_t c_i = 0; c_i < chunks_size; c_i++) {
-		for (size_t i = 0; i < sizeof(chunks_data[c_i]); i++) {
-			pkg.push_back((chunks_data[c_i]>>(i*8)) & 0xff);
-		}
+		pw.writeLE(chunks_data[c_i]);
 	}
 
 	// lossless
-	return _t.toxGroupSendCustomPrivatePacket(group_number, peer_number, true, pkg) == TOX_ERR_GROUP_SEND_CUSTOM_PRIVATE_PACKET_OK;
+	return sendCustomPrivatePacket(group_number, peer_number, true, pw.pkg);
 }
 
 bool NGCEXTEventProvider::send_ft1_bitset(
@@ -784,32 +1257,21 @@ bool NGCEXTEventProvider::send_ft1_bitset(
 	uint32_t start_chunk,
 	const uint8_t* bitset_data, size_t bitset_size // size is bytes
 ) {
-	std::vector<uint8_t> pkg;
-	pkg.push_back(static_cast<uint8_t>(NGCEXT_Event::FT1_BITSET));
-
-	for (size_t i = 0; i < sizeof(file_kind); i++) {
-		pkg.push_back((file_kind>>(i*8)) & 0xff);
-	}
+	PacketWriter pw{tl_pkg_buffer, 1+sizeof(file_kind)+sizeof(uint16_t)+file_id_size+sizeof(start_chunk)+bitset_size};
+	pw.writePkgID(NGCEXT_Event::FT1_BITSET);
+	pw.writeLE(file_kind);
 
 	// file id not last in packet, needs explicit size
 	const uint16_t file_id_size_cast = file_id_size;
-	for (size_t i = 0; i < sizeof(file_id_size_cast); i++) {
-		pkg.push_back((file_id_size_cast>>(i*8)) & 0xff);
-	}
-	for (size_t i = 0; i < file_id_size; i++) {
-		pkg.push_back(file_id[i]);
-	}
+	pw.writeLE(file_id_size_cast);
+	pw.write(file_id, file_id_size);
 
-	for (size_t i = 0; i < sizeof(start_chunk); i++) {
-		pkg.push_back((start_chunk>>(i*8)) & 0xff);
-	}
+	pw.writeLE(start_chunk);
 
-	for (size_t i = 0; i < bitset_size; i++) {
-		pkg.push_back(bitset_data[i]);
-	}
+	pw.write(bitset_data, bitset_size);
 
 	// lossless
-	return _t.toxGroupSendCustomPrivatePacket(group_number, peer_number, true, pkg) == TOX_ERR_GROUP_SEND_CUSTOM_PRIVATE_PACKET_OK;
+	return sendCustomPrivatePacket(group_number, peer_number, true, pw.pkg);
 }
 
 bool NGCEXTEventProvider::send_ft1_have_all(
@@ -817,25 +1279,20 @@ bool NGCEXTEventProvider::send_ft1_have_all(
 	uint32_t file_kind,
 	const uint8_t* file_id, size_t file_id_size
 ) {
-	std::vector<uint8_t> pkg;
-	pkg.push_back(static_cast<uint8_t>(NGCEXT_Event::FT1_HAVE_ALL));
-
-	for (size_t i = 0; i < sizeof(file_kind); i++) {
-		pkg.push_back((file_kind>>(i*8)) & 0xff);
-	}
-	for (size_t i = 0; i < file_id_size; i++) {
-		pkg.push_back(file_id[i]);
-	}
+	PacketWriter pw{tl_pkg_buffer, 1+sizeof(file_kind)+file_id_size};
+	pw.writePkgID(NGCEXT_Event::FT1_HAVE_ALL);
+	pw.writeLE(file_kind);
+	pw.write(file_id, file_id_size);
 
 	// lossless
-	return _t.toxGroupSendCustomPrivatePacket(group_number, peer_number, true, pkg) == TOX_ERR_GROUP_SEND_CUSTOM_PRIVATE_PACKET_OK;
+	return sendCustomPrivatePacket(group_number, peer_number, true, pw.pkg);
 }
 
 bool NGCEXTEventProvider::send_ft1_init2(
 	uint32_t group_number, uint32_t peer_number,
 	uint32_t file_kind,
 	uint64_t file_size,
-	uint8_t transfer_id,
+	uint16_t transfer_id,
 	uint8_t feature_flags,
 	const uint8_t* file_id, size_t file_id_size
 ) {
@@ -843,56 +1300,49 @@ bool NGCEXTEventProvider::send_ft1_init2(
 	// - 4 byte (file_kind)
 	// - 8 bytes (data size)
 	// - 1 byte (temporary_file_tf_id, for this peer only, technically just a prefix to distinguish between simultainious fts)
+	//   2 bytes in FT1_INIT3
 	// - 1 byte (feature_flags)
 	// - X bytes (file_kind dependent id, differnt sizes)
 
-	std::vector<uint8_t> pkg;
-	pkg.push_back(static_cast<uint8_t>(NGCEXT_Event::FT1_INIT2));
-	for (size_t i = 0; i < sizeof(file_kind); i++) {
-		pkg.push_back((file_kind>>(i*8)) & 0xff);
-	}
-	for (size_t i = 0; i < sizeof(file_size); i++) {
-		pkg.push_back((file_size>>(i*8)) & 0xff);
-	}
-	pkg.push_back(transfer_id);
-	pkg.push_back(feature_flags);
-	for (size_t i = 0; i < file_id_size; i++) {
-		pkg.push_back(file_id[i]);
-	}
+	PacketWriter pw{tl_pkg_buffer, 1+sizeof(file_kind)+sizeof(file_size)+2+1+file_id_size};
+	pw.writePkgID(transfer_id > 0xff ? NGCEXT_Event::FT1_INIT3 : NGCEXT_Event::FT1_INIT2);
+	pw.writeLE(file_kind);
+	pw.writeLE(file_size);
+	pw.writeTransferID(transfer_id);
+	pw.writeLE(feature_flags);
+	pw.write(file_id, file_id_size);
 
 	// lossless
-	return _t.toxGroupSendCustomPrivatePacket(group_number, peer_number, true, pkg) == TOX_ERR_GROUP_SEND_CUSTOM_PRIVATE_PACKET_OK;
+	return sendCustomPrivatePacket(group_number, peer_number, true, pw.pkg);
 }
 
-static std::vector<uint8_t> build_pc1_announce(const uint8_t* id_data, size_t id_size) {
+static const std::vector<uint8_t>& build_pc1_announce(std::vector<uint8_t>& buffer, const uint8_t* id_data, size_t id_size) {
 	// - 1 byte packet id
 	// - X bytes (id, differnt sizes)
 
-	std::vector<uint8_t> pkg;
-	pkg.push_back(static_cast<uint8_t>(NGCEXT_Event::PC1_ANNOUNCE));
-	for (size_t i = 0; i < id_size; i++) {
-		pkg.push_back(id_data[i]);
-	}
-	return pkg;
+	PacketWriter pw{buffer, 1+id_size};
+	pw.writePkgID(NGCEXT_Event::PC1_ANNOUNCE);
+	pw.write(id_data, id_size);
+	return pw.pkg;
 }
 
 bool NGCEXTEventProvider::send_pc1_announce(
 	uint32_t group_number, uint32_t peer_number,
 	const uint8_t* id_data, size_t id_size
 ) {
-	auto pkg = build_pc1_announce(id_data, id_size);
+	const auto& pkg = build_pc1_announce(tl_pkg_buffer, id_data, id_size);
 
 	std::cout << "NEEP: sending PC1_ANNOUNCE s:" << pkg.size() - sizeof(NGCEXT_Event::PC1_ANNOUNCE) << "\n";
 
 	// lossless?
-	return _t.toxGroupSendCustomPrivatePacket(group_number, peer_number, true, pkg) == TOX_ERR_GROUP_SEND_CUSTOM_PRIVATE_PACKET_OK;
+	return sendCustomPrivatePacket(group_number, peer_number, true, pkg);
 }
 
 bool NGCEXTEventProvider::send_all_pc1_announce(
 	uint32_t group_number,
 	const uint8_t* id_data, size_t id_size
 ) {
-	auto pkg = build_pc1_announce(id_data, id_size);
+	const auto& pkg = build_pc1_announce(tl_pkg_buffer, id_data, id_size);
 
 	std::cout << "NEEP: sending all PC1_ANNOUNCE s:" << pkg.size() - sizeof(NGCEXT_Event::PC1_ANNOUNCE) << "\n";
 
@@ -8,11 +8,44 @@
 
 #include <solanaceae/toxcore/tox_key.hpp>
 
+#include <solanaceae/util/span.hpp>
+
 #include <vector>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+// non-owning view into a packed little endian array of T (as found in packets)
+template<typename T>
+struct LEArrayView {
+	ByteSpan bytes;
+
+	size_t size(void) const { return bytes.size / sizeof(T); }
+	bool empty(void) const { return size() == 0; }
+
+	T operator[](size_t i) const {
+		T value {0};
+		for (size_t j = 0; j < sizeof(T); j++) {
+			value |= T(bytes.ptr[i*sizeof(T) + j]) << (j*8);
+		}
+		return value;
+	}
+};
+
+// feature flags, as used in FT1_INIT2 and FT1_INIT_ACK
+enum NGCEXT_FT1_Feature : uint8_t {
+	FT1_FEATURE_ZSTD = 0x01, // data is a single streaming zstd frame, file_size stays uncompressed
+	FT1_FEATURE_SACK = 0x02, // receiver acks using FT1_DATA_SACK
+	FT1_FEATURE_FEC = 0x04, // sender adds FT1_DATA_FEC xor parity
+	FT1_FEATURE_ZSTD_DICT = 0x08, // with zstd, using the dictionary both have for the file_kind
+	FT1_FEATURE_WIDE_IDS = 0x10, // peer understands 2 byte transfer ids (FT1_INIT3 and the _WIDE packets), not per transfer
+};
 
 namespace Events {
 
-	// TODO: implement events as non-owning
+	// events are non-owning, spans point into the packet
+	// and are only valid for the duration of the dispatch
+	// copy if you need to keep the data
 
 	struct NGCEXT_ft1_request {
 		uint32_t group_number;
@@ -24,7 +57,7 @@ namespace Events {
 		uint32_t file_kind;
 
 		// - X bytes (file_kind dependent id, differnt sizes)
-		std::vector<uint8_t> file_id;
+		ByteSpan file_id;
 	};
 
 	// DEPRECATED: use FT1_INIT2 instead
@@ -44,22 +77,25 @@ namespace Events {
 		uint8_t transfer_id;
 
 		// - X bytes (file_kind dependent id, differnt sizes)
-		std::vector<uint8_t> file_id;
+		ByteSpan file_id;
 	};
 
 	struct NGCEXT_ft1_init_ack {
 		uint32_t group_number;
 		uint32_t peer_number;
 
-		// - 1 byte (transfer_id)
-		uint8_t transfer_id;
+		// - 1 byte (transfer_id), 2 bytes in the _WIDE variant
+		uint16_t transfer_id;
 
 		// - 2 byte (self_max_lossy_data_size)
 		uint16_t max_lossy_data_size;
 
 		// - 1 byte feature flags
 		//   - 0x01 advertised zstd compression
-		//   - 0x02
+		//   - 0x02 sack acks (FT1_DATA_SACK)
+		//   - 0x04 xor parity (FT1_DATA_FEC)
+		//   - 0x08 zstd with the file_kind dictionary
+		//   - 0x10 2 byte transfer ids
 		uint8_t feature_flags;
 	};
 
@@ -69,28 +105,89 @@ namespace Events {
 
 		// data fragment
 
-		// - 1 byte (temporary_file_tf_id)
-		uint8_t transfer_id;
+		// - 1 byte (temporary_file_tf_id), 2 bytes in the _WIDE variant
+		uint16_t transfer_id;
 
 		// - 2 bytes (sequece id)
 		uint16_t sequence_id;
 
 		// - X bytes (the data fragment)
 		// (size is implicit)
-		std::vector<uint8_t> data;
+		ByteSpan data;
 	};
 
 	struct NGCEXT_ft1_data_ack {
 		uint32_t group_number;
 		uint32_t peer_number;
 
-		// - 1 byte (temporary_file_tf_id)
-		uint8_t transfer_id;
+		// - 1 byte (temporary_file_tf_id), 2 bytes in the _WIDE variant
+		uint16_t transfer_id;
 
 		// - array [ (of sequece ids)
 		//   - 2 bytes (sequece id)
 		// - ]
-		std::vector<uint16_t> sequence_ids;
+		LEArrayView<uint16_t> sequence_ids;
+	};
+
+	struct NGCEXT_ft1_data_sack {
+		uint32_t group_number;
+		uint32_t peer_number;
+
+		// - 1 byte (temporary_file_tf_id), 2 bytes in the _WIDE variant
+		uint16_t transfer_id;
+
+		// - 2 bytes (next expected sequence id, all before it are received)
+		uint16_t next_sequence_id;
+
+		// - array [
+		//   - 1 bit (received sequence id next_sequence_id+1+i)
+		// - ] (low to high, filled up with zero)
+		ByteSpan sack_bitset;
+	};
+
+	struct NGCEXT_ft1_data_fec {
+		uint32_t group_number;
+		uint32_t peer_number;
+
+		// - 1 byte (temporary_file_tf_id), 2 bytes in the _WIDE variant
+		uint16_t transfer_id;
+
+		// - 2 bytes (first sequence id of the block)
+		uint16_t first_sequence_id;
+
+		// - 1 byte (number of consecutive sequence ids in the block)
+		uint8_t count;
+
+		// - 2 bytes (xor of all data sizes in the block)
+		uint16_t size_xor;
+
+		// - X bytes (xor of all data in the block, zero padded to the largest)
+		ByteSpan parity;
+	};
+
+	struct NGCEXT_ft1_mtu_probe {
+		uint32_t group_number;
+		uint32_t peer_number;
+
+		// - 1 byte (probe_id)
+		uint8_t probe_id;
+
+		// - 2 bytes (probed data size, same as the padding size)
+		uint16_t probe_size;
+
+		// - X bytes (padding, content ignored)
+		ByteSpan padding;
+	};
+
+	struct NGCEXT_ft1_mtu_probe_ack {
+		uint32_t group_number;
+		uint32_t peer_number;
+
+		// - 1 byte (probe_id)
+		uint8_t probe_id;
+
+		// - 2 bytes (received padding size)
+		uint16_t probe_size;
 	};
 
 	struct NGCEXT_ft1_message {
@@ -104,7 +201,7 @@ namespace Events {
 		uint32_t file_kind;
 
 		// - X bytes (file_kind dependent id, differnt sizes)
-		std::vector<uint8_t> file_id;
+		ByteSpan file_id;
 	};
 
 	struct NGCEXT_ft1_have {
@@ -115,12 +212,12 @@ namespace Events {
 		uint32_t file_kind;
 
 		// - X bytes (file_kind dependent id, differnt sizes)
-		std::vector<uint8_t> file_id;
+		ByteSpan file_id;
 
 		// - array [
 		//   - 4 bytes (chunk index)
 		// - ]
-		std::vector<uint32_t> chunks;
+		LEArrayView<uint32_t> chunks;
 	};
 
 	struct NGCEXT_ft1_bitset {
@@ -131,7 +228,7 @@ namespace Events {
 		uint32_t file_kind;
 
 		// - X bytes (file_kind dependent id, differnt sizes)
-		std::vector<uint8_t> file_id;
+		ByteSpan file_id;
 
 		uint32_t start_chunk;
 
@@ -139,7 +236,7 @@ namespace Events {
 		//   - 1 bit (have chunk)
 		// - ] (filled up with zero)
 		// high to low?
-		std::vector<uint8_t> chunk_bitset;
+		ByteSpan chunk_bitset;
 	};
 
 	struct NGCEXT_ft1_have_all {
@@ -150,7 +247,7 @@ namespace Events {
 		uint32_t file_kind;
 
 		// - X bytes (file_kind dependent id, differnt sizes)
-		std::vector<uint8_t> file_id;
+		ByteSpan file_id;
 	};
 
 	struct NGCEXT_ft1_init2 {
@@ -166,15 +263,19 @@ namespace Events {
 		uint64_t file_size;
 
 		// - 1 byte (temporary_file_tf_id, for this peer only, technically just a prefix to distinguish between simultainious fts)
-		uint8_t transfer_id;
+		//   2 bytes in FT1_INIT3
+		uint16_t transfer_id;
 
 		// - 1 byte feature flags
 		//   - 0x01 advertise zstd compression
-		//   - 0x02
+		//   - 0x02 sack acks (FT1_DATA_SACK)
+		//   - 0x04 xor parity (FT1_DATA_FEC)
+		//   - 0x08 zstd with the file_kind dictionary
+		//   - 0x10 2 byte transfer ids
 		uint8_t feature_flags;
 
 		// - X bytes (file_kind dependent id, differnt sizes)
-		std::vector<uint8_t> file_id;
+		ByteSpan file_id;
 	};
 
 	struct NGCEXT_pc1_announce {
@@ -182,7 +283,7 @@ namespace Events {
 		uint32_t peer_number;
 
 		// - X bytes (id, differnt sizes)
-		std::vector<uint8_t> id;
+		ByteSpan id;
 	};
 
 } // Events
@@ -289,6 +390,81 @@ enum class NGCEXT_Event_old : uint8_t {
 	// - X bytes (file_kind dependent id, differnt sizes)
 	FT1_INIT2,
 
+	// acknowlage data fragments, cumulative + selective
+	// only used if negotiated (FT1_FEATURE_SACK in init2 and init_ack)
+	// - 1 byte (temporary_file_tf_id)
+	// - 2 bytes (next expected sequence id, all before it are received)
+	// - array [
+	//   - 1 bit (received sequence id next+1+i)
+	// - ] (low to high, filled up with zero, max 32 bytes)
+	FT1_DATA_SACK,
+
+	// segment size probe, padded to be exactly as big as a FT1_DATA packet with probe_size data
+	// lossy, the receiver replies with FT1_MTU_PROBE_ACK
+	// - 1 byte (probe_id)
+	// - 2 bytes (probe_size)
+	// - X bytes (padding, probe_size bytes)
+	FT1_MTU_PROBE,
+
+	// the probe made it
+	// - 1 byte (probe_id)
+	// - 2 bytes (received padding size)
+	FT1_MTU_PROBE_ACK,
+
+	// xor parity over a block of data fragments, a single lost one can be rebuilt
+	// only used if negotiated (FT1_FEATURE_FEC in init2 and init_ack)
+	// - 1 byte (temporary_file_tf_id)
+	// - 2 bytes (first sequence id of the block)
+	// - 1 byte (number of sequence ids in the block)
+	// - 2 bytes (xor of the data sizes)
+	// - X bytes (xor of the data, zero padded)
+	FT1_DATA_FEC,
+
+	// tell the other side you want to start a FT, with a 2 byte transfer_id
+	// only sent to peers known to understand it (FT1_FEATURE_WIDE_IDS), and only for ids above 0xff
+	// the transfer then uses the _WIDE packets, the rest stays the same
+	// - 4 byte (file_kind)
+	// - 8 bytes (data size, can be 0 if unknown, BUT files have to be atleast 1 byte)
+	// - 2 bytes (temporary_file_tf_id)
+	// - 1 byte feature flags
+	// - X bytes (file_kind dependent id, differnt sizes)
+	FT1_INIT3,
+
+	// FT1_INIT_ACK with a 2 byte transfer_id
+	// - 2 bytes (transfer_id)
+	// - 2 byte (self_max_lossy_data_size)
+	// - 1 byte feature flags
+	FT1_INIT_ACK_WIDE,
+
+	// FT1_DATA with a 2 byte transfer_id
+	// - 2 bytes (temporary_file_tf_id)
+	// - 2 bytes (sequece id)
+	// - X bytes (the data fragment)
+	FT1_DATA_WIDE,
+
+	// FT1_DATA_ACK with a 2 byte transfer_id
+	// - 2 bytes (temporary_file_tf_id)
+	// - array [ (of sequece ids)
+	//   - 2 bytes (sequece id)
+	// - ]
+	FT1_DATA_ACK_WIDE,
+
+	// FT1_DATA_SACK with a 2 byte transfer_id
+	// - 2 bytes (temporary_file_tf_id)
+	// - 2 bytes (next expected sequence id, all before it are received)
+	// - array [
+	//   - 1 bit (received sequence id next+1+i)
+	// - ]
+	FT1_DATA_SACK_WIDE,
+
+	// FT1_DATA_FEC with a 2 byte transfer_id
+	// - 2 bytes (temporary_file_tf_id)
+	// - 2 bytes (first sequence id of the block)
+	// - 1 byte (number of sequence ids in the block)
+	// - 2 bytes (xor of the data sizes)
+	// - X bytes (xor of the data, zero padded)
+	FT1_DATA_FEC_WIDE,
+
 	// TODO: FT1_IDONTHAVE, tell a peer you no longer have said chunk
 	// TODO: FT1_REJECT, tell a peer you wont fulfil the request
 	// TODO: FT1_CANCEL, tell a peer you stop the transfer
@@ -394,6 +570,82 @@ enum class NGCEXT_Event_new : uint8_t {
 	// - X bytes (file_kind dependent id, differnt sizes)
 	FT1_HAVE_ALL = 0x09,
 
+	// acknowlage data fragments, cumulative + selective
+	// only used if negotiated (FT1_FEATURE_SACK in init2 and init_ack)
+	// - 1 byte (temporary_file_tf_id)
+	// - 2 bytes (next expected sequence id, all before it are received)
+	// - array [
+	//   - 1 bit (received sequence id next+1+i)
+	// - ] (low to high, filled up with zero, max 32 bytes)
+	FT1_DATA_SACK = 0x0a,
+
+	// segment size probe, padded to be exactly as big as a FT1_DATA packet with probe_size data
+	// lossy, the receiver replies with FT1_MTU_PROBE_ACK
+	// - 1 byte (probe_id)
+	// - 2 bytes (probe_size)
+	// - X bytes (padding, probe_size bytes)
+	FT1_MTU_PROBE = 0x0b,
+
+	// the probe made it
+	// - 1 byte (probe_id)
+	// - 2 bytes (received padding size)
+	FT1_MTU_PROBE_ACK = 0x0c,
+
+	// xor parity over a block of data fragments, a single lost one can be rebuilt
+	// only used if negotiated (FT1_FEATURE_FEC in init2 and init_ack)
+	// - 1 byte (temporary_file_tf_id)
+	// - 2 bytes (first sequence id of the block)
+	// - 1 byte (number of sequence ids in the block)
+	// - 2 bytes (xor of the data sizes)
+	// - X bytes (xor of the data, zero padded)
+	FT1_DATA_FEC = 0x0d,
+
+	// tell the other side you want to start a FT, with a 2 byte transfer_id
+	// only sent to peers known to understand it (FT1_FEATURE_WIDE_IDS), and only for ids above 0xff
+	// the transfer then uses the _WIDE packets, the rest stays the same
+	// - 4 byte (file_kind)
+	// - 8 bytes (data size, can be 0 if unknown, BUT files have to be atleast 1 byte)
+	// - 2 bytes (temporary_file_tf_id)
+	// - 1 byte feature flags
+	// - X bytes (file_kind dependent id, differnt sizes)
+	FT1_INIT3 = 0x0e,
+
+	// FT1_INIT_ACK with a 2 byte transfer_id
+	// - 2 bytes (transfer_id)
+	// - 2 byte (self_max_lossy_data_size)
+	// - 1 byte feature flags
+	FT1_INIT_ACK_WIDE = 0x0f,
+
+	// FT1_DATA with a 2 byte transfer_id
+	// - 2 bytes (temporary_file_tf_id)
+	// - 2 bytes (sequece id)
+	// - X bytes (the data fragment)
+	// 0x10 is PC1_ANNOUNCE
+	FT1_DATA_WIDE = 0x11,
+
+	// FT1_DATA_ACK with a 2 byte transfer_id
+	// - 2 bytes (temporary_file_tf_id)
+	// - array [ (of sequece ids)
+	//   - 2 bytes (sequece id)
+	// - ]
+	FT1_DATA_ACK_WIDE = 0x12,
+
+	// FT1_DATA_SACK with a 2 byte transfer_id
+	// - 2 bytes (temporary_file_tf_id)
+	// - 2 bytes (next expected sequence id, all before it are received)
+	// - array [
+	//   - 1 bit (received sequence id next+1+i)
+	// - ]
+	FT1_DATA_SACK_WIDE = 0x13,
+
+	// FT1_DATA_FEC with a 2 byte transfer_id
+	// - 2 bytes (temporary_file_tf_id)
+	// - 2 bytes (first sequence id of the block)
+	// - 1 byte (number of sequence ids in the block)
+	// - 2 bytes (xor of the data sizes)
+	// - X bytes (xor of the data, zero padded)
+	FT1_DATA_FEC_WIDE = 0x14,
+
 	// TODO: FT1_IDONTHAVE, tell a peer you no longer have said chunk(s)
 	// TODO: FT1_REJECT, tell a peer you wont fulfil the request(s)
 	// TODO: FT1_CANCEL, tell a peer you stoped the transfer
@@ -420,6 +672,10 @@ struct NGCEXTEventI {
 	virtual bool onEvent(const Events::NGCEXT_ft1_init_ack&) { return false; }
 	virtual bool onEvent(const Events::NGCEXT_ft1_data&) { return false; }
 	virtual bool onEvent(const Events::NGCEXT_ft1_data_ack&) { return false; }
+	virtual bool onEvent(const Events::NGCEXT_ft1_data_sack&) { return false; }
+	virtual bool onEvent(const Events::NGCEXT_ft1_data_fec&) { return false; }
+	virtual bool onEvent(const Events::NGCEXT_ft1_mtu_probe&) { return false; }
+	virtual bool onEvent(const Events::NGCEXT_ft1_mtu_probe_ack&) { return false; }
 	virtual bool onEvent(const Events::NGCEXT_ft1_message&) { return false; }
 	virtual bool onEvent(const Events::NGCEXT_ft1_have&) { return false; }
 	virtual bool onEvent(const Events::NGCEXT_ft1_bitset&) { return false; }
@@ -430,14 +686,86 @@ struct NGCEXTEventI {
 
 using NGCEXTEventProviderI = EventProviderI<NGCEXTEventI>;
 
+// a private packet built on some thread, for the thread owning tox to send
+struct NGCEXTQueuedPacket {
+	uint32_t group_number {0};
+	uint32_t peer_number {0};
+	bool lossless {false};
+	std::vector<uint8_t> data; // capacity is reserved up front and kept
+};
+
+// bounded, with all slots allocated up front, so queueing a packet never allocates
+// not thread safe, every producing thread needs its own, drain once they are done
+struct NGCEXTSendQueue {
+	// tox's max custom packet length, lossy and lossless
+	static constexpr size_t max_packet_size {1373};
+
+	std::vector<NGCEXTQueuedPacket> _slots;
+	size_t _count {0};
+
+	explicit NGCEXTSendQueue(size_t capacity = 1024);
+
+	// false if full or the packet does not fit a slot (tox would reject it too)
+	bool push(uint32_t group_number, uint32_t peer_number, bool lossless, const std::vector<uint8_t>& pkg);
+
+	size_t size(void) const { return _count; }
+	const NGCEXTQueuedPacket& operator[](size_t i) const { return _slots[i]; }
+
+	// keeps the slots
+	void clear(void) { _count = 0; }
+};
+
 class NGCEXTEventProvider : public ToxEventI, public NGCEXTEventProviderI {
 	ToxI& _t;
 	ToxEventProviderI& _tep;
 	ToxEventProviderI::SubscriptionReference _tep_sr;
 
+	public:
+		struct PacketTypeStats {
+			uint64_t count {0};
+			uint64_t count_unhandled {0}; // parse error or nobody handled it
+			uint64_t bytes {0};
+
+			// time spent parsing + handling (dispatch is synchronous)
+			uint64_t time_total_ns {0};
+			// log2 buckets in microseconds, [0] is <1us, [i] is [2^(i-1), 2^i)us, last is open ended
+			std::array<uint64_t, 18> time_hist {};
+
+			void addTime(uint64_t ns);
+		};
+
+		struct PacketStats {
+			// indexed by the 1 byte NGCEXT_Event_old
+			std::array<PacketTypeStats, 256> old_ids;
+			// indexed by the second byte of the 0x90 prefixed NGCEXT_Event_new
+			std::array<PacketTypeStats, 256> new_ids;
+		};
+
+	private:
+		// we still send old ids, so dont disable unless all peers understand new
+		bool _legacy_packets {true};
+		bool _collect_stats {true};
+		PacketStats _packet_stats;
+
 	public:
 		NGCEXTEventProvider(ToxI& t, ToxEventProviderI& tep);
 
+		void setLegacyPacketsEnabled(bool enabled);
+		void setCollectStats(bool enabled);
+
+		const PacketStats& getPacketStats(void) const;
+		void resetPacketStats(void);
+
+		// private packets sent by the calling thread go into queue instead of tox, nullptr to send directly again
+		// a full queue fails the send like tox would, so batch sends report how many made it in
+		// queued packets count as sent, whoever drains the queue hands them to tox and deals with failures
+		// this makes the private send_*() functions usable from other threads, nothing else is
+		static void setThreadSendQueue(NGCEXTSendQueue* queue);
+
+	private:
+		// tox, or the queue set for this thread
+		bool sendCustomPrivatePacket(uint32_t group_number, uint32_t peer_number, bool lossless, const std::vector<uint8_t>& pkg);
+
 	protected:
 		bool parse_ft1_request(
 			uint32_t group_number, uint32_t peer_number,
@@ -469,18 +797,72 @@ class NGCEXTEventProvider : public ToxEventI, public NGCEXTEventProviderI {
 			bool _private
 		);
 
+		bool parse_ft1_init_ack_wide(
+			uint32_t group_number, uint32_t peer_number,
+			const uint8_t* data, size_t data_size,
+			bool _private
+		);
+
 		bool parse_ft1_data(
 			uint32_t group_number, uint32_t peer_number,
 			const uint8_t* data, size_t data_size,
 			bool _private
 		);
 
+		bool parse_ft1_data_wide(
+			uint32_t group_number, uint32_t peer_number,
+			const uint8_t* data, size_t data_size,
+			bool _private
+		);
+
 		bool parse_ft1_data_ack(
 			uint32_t group_number, uint32_t peer_number,
 			const uint8_t* data, size_t data_size,
 			bool _private
 		);
 
+		bool parse_ft1_data_ack_wide(
+			uint32_t group_number, uint32_t peer_number,
+			const uint8_t* data, size_t data_size,
+			bool _private
+		);
+
+		bool parse_ft1_data_sack(
+			uint32_t group_number, uint32_t peer_number,
+			const uint8_t* data, size_t data_size,
+			bool _private
+		);
+
+		bool parse_ft1_data_sack_wide(
+			uint32_t group_number, uint32_t peer_number,
+			const uint8_t* data, size_t data_size,
+			bool _private
+		);
+
+		bool parse_ft1_data_fec(
+			uint32_t group_number, uint32_t peer_number,
+			const uint8_t* data, size_t data_size,
+			bool _private
+		);
+
+		bool parse_ft1_data_fec_wide(
+			uint32_t group_number, uint32_t peer_number,
+			const uint8_t* data, size_t data_size,
+			bool _private
+		);
+
+		bool parse_ft1_mtu_probe(
+			uint32_t group_number, uint32_t peer_number,
+			const uint8_t* data, size_t data_size,
+			bool _private
+		);
+
+		bool parse_ft1_mtu_probe_ack(
+			uint32_t group_number, uint32_t peer_number,
+			const uint8_t* data, size_t data_size,
+			bool _private
+		);
+
 		bool parse_ft1_message(
 			uint32_t group_number, uint32_t peer_number,
 			const uint8_t* data, size_t data_size,
@@ -511,21 +893,73 @@ class NGCEXTEventProvider : public ToxEventI, public NGCEXTEventProviderI {
 			bool _private
 		);
 
+		bool parse_ft1_init3(
+			uint32_t group_number, uint32_t peer_number,
+			const uint8_t* data, size_t data_size,
+			bool _private
+		);
+
 		bool parse_pc1_announce(
 			uint32_t group_number, uint32_t peer_number,
 			const uint8_t* data, size_t data_size,
 			bool _private
 		);
 
-		bool handlePacket(
+		// shared by the 1 and 2 byte (wide) transfer_id variants
+		bool parse_ft1_init_ack_v3(
+			uint32_t group_number, uint32_t peer_number,
+			const uint8_t* data, size_t data_size,
+			bool _private, bool wide
+		);
+		bool parse_ft1_data(
+			uint32_t group_number, uint32_t peer_number,
+			const uint8_t* data, size_t data_size,
+			bool _private, bool wide
+		);
+		bool parse_ft1_data_ack(
+			uint32_t group_number, uint32_t peer_number,
+			const uint8_t* data, size_t data_size,
+			bool _private, bool wide
+		);
+		bool parse_ft1_data_sack(
+			uint32_t group_number, uint32_t peer_number,
+			const uint8_t* data, size_t data_size,
+			bool _private, bool wide
+		);
+		bool parse_ft1_data_fec(
+			uint32_t group_number, uint32_t peer_number,
+			const uint8_t* data, size_t data_size,
+			bool _private, bool wide
+		);
+		bool parse_ft1_init2(
+			uint32_t group_number, uint32_t peer_number,
+			const uint8_t* data, size_t data_size,
+			bool _private, bool wide
+		);
+
+		using ParseFn = bool (NGCEXTEventProvider::*)(
+			uint32_t group_number, uint32_t peer_number,
+			const uint8_t* data, size_t data_size,
+			bool _private
+		);
+
+		// pkg id -> parse function, nullptr if unhandled
+		static const std::array<ParseFn, 256>& handlerTableOld(void);
+		static const std::array<ParseFn, 256>& handlerTableNew(void);
+
+		// has_fallback: an unhandled packet goes on to another handler, which records it instead
+		bool runHandler(
+			ParseFn fn,
+			PacketTypeStats& stats,
 			const uint32_t group_number,
 			const uint32_t peer_number,
 			const uint8_t* data,
 			const size_t data_size,
-			const bool _private
+			const bool _private,
+			const bool has_fallback = false
 		);
 
-		bool handlePacket_old(
+		bool handlePacket(
 			const uint32_t group_number,
 			const uint32_t peer_number,
 			const uint8_t* data,
@@ -533,7 +967,11 @@ class NGCEXTEventProvider : public ToxEventI, public NGCEXTEventProviderI {
 			const bool _private
 		);
 
+
 	public: // send api
+		// per transfer packets with transfer ids above 0xff use the 2 byte (_WIDE) variants,
+		// only use those with peers that understand them (FT1_FEATURE_WIDE_IDS)
+
 		bool send_ft1_request(
 			uint32_t group_number, uint32_t peer_number,
 			uint32_t file_kind,
@@ -550,22 +988,65 @@ class NGCEXTEventProvider : public ToxEventI, public NGCEXTEventProviderI {
 
 		bool send_ft1_init_ack(
 			uint32_t group_number, uint32_t peer_number,
-			uint8_t transfer_id
+			uint16_t transfer_id,
+			uint8_t feature_flags = 0x00
 		);
 
 		bool send_ft1_data(
 			uint32_t group_number, uint32_t peer_number,
-			uint8_t transfer_id,
+			uint16_t transfer_id,
 			uint16_t sequence_id,
 			const uint8_t* data, size_t data_size
 		);
 
+		struct FT1DataSegment {
+			uint16_t sequence_id;
+			ByteSpan data;
+		};
+
+		// sends the segments in order and stops at the first failure (eg. send queue full)
+		// returns the number of segments sent
+		size_t send_ft1_data_batch(
+			uint32_t group_number, uint32_t peer_number,
+			uint16_t transfer_id,
+			Span<FT1DataSegment> segments
+		);
+
 		bool send_ft1_data_ack(
 			uint32_t group_number, uint32_t peer_number,
-			uint8_t transfer_id,
+			uint16_t transfer_id,
 			const uint16_t* seq_ids, size_t seq_ids_size
 		);
 
+		bool send_ft1_data_sack(
+			uint32_t group_number, uint32_t peer_number,
+			uint16_t transfer_id,
+			uint16_t next_seq_id,
+			const uint8_t* sack_bitset_data, size_t sack_bitset_size // size is bytes
+		);
+
+		bool send_ft1_data_fec(
+			uint32_t group_number, uint32_t peer_number,
+			uint16_t transfer_id,
+			uint16_t first_seq_id,
+			uint8_t count,
+			uint16_t size_xor,
+			const uint8_t* parity, size_t parity_size
+		);
+
+		// packet is as big as a FT1_DATA packet carrying probe_size bytes
+		bool send_ft1_mtu_probe(
+			uint32_t group_number, uint32_t peer_number,
+			uint8_t probe_id,
+			uint16_t probe_size
+		);
+
+		bool send_ft1_mtu_probe_ack(
+			uint32_t group_number, uint32_t peer_number,
+			uint8_t probe_id,
+			uint16_t probe_size
+		);
+
 		// TODO: add private version
 		bool send_all_ft1_message(
 			uint32_t group_number,
@@ -595,11 +1076,12 @@ class NGCEXTEventProvider : public ToxEventI, public NGCEXTEventProviderI {
 			const uint8_t* file_id, size_t file_id_size
 		);
 
+		// sends FT1_INIT3 for transfer ids above 0xff
 		bool send_ft1_init2(
 			uint32_t group_number, uint32_t peer_number,
 			uint32_t file_kind,
 			uint64_t file_size,
-			uint8_t transfer_id,
+			uint16_t transfer_id,
 			uint8_t feature_flags,
 			const uint8_t* file_id, size_t file_id_size
 		);
@@ -0,0 +1,172 @@
+#include "./bbr.hpp"
+
+#include <cmath>
+#include <iostream>
+#include <algorithm>
+
+float BBR::getBDP(void) const {
+	if (_btl_bw <= 0.f || std::isinf(_min_rtt)) {
+		return INITIAL_WINDOW_SEGMENTS * MAXIMUM_SEGMENT_SIZE;
+	}
+
+	return _btl_bw * _min_rtt;
+}
+
+float BBR::getPacingGain(void) const {
+	switch (_mode) {
+		case Mode::STARTUP: return HIGH_GAIN;
+		case Mode::DRAIN: return 1.f / HIGH_GAIN;
+		case Mode::PROBE_BW: return PROBE_BW_GAINS.at(_cycle_idx);
+		case Mode::PROBE_RTT: return 1.f;
+	}
+	return 1.f;
+}
+
+float BBR::getCWnD(void) const {
+	if (_mode == Mode::PROBE_RTT) {
+		return MIN_PIPE_SEGMENTS * MAXIMUM_SEGMENT_SIZE;
+	}
+
+	const float gain = _mode == Mode::STARTUP ? HIGH_GAIN : CWND_GAIN;
+	return std::max<float>(gain * getBDP(), MIN_PIPE_SEGMENTS * MAXIMUM_SEGMENT_SIZE);
+}
+
+void BBR::enterProbeBW(double now) {
+	_mode = Mode::PROBE_BW;
+	// start at a random phase, but not in the draining one
+	_cycle_idx = _rng() % PROBE_BW_GAINS.size();
+	if (_cycle_idx == 1) {
+		_cycle_idx = 0;
+	}
+	_cycle_stamp = now;
+}
+
+void BBR::onRoundEnd(double now) {
+	const double elapsed = now - _round_start_time;
+	if (elapsed <= 0.0) {
+		return;
+	}
+
+	const float rate = (_delivered - _round_start_delivered) / elapsed;
+	_round_start_time = now;
+	_round_start_delivered = _delivered;
+
+	_bw_samples[_bw_sample_idx] = rate;
+	_bw_sample_idx = (_bw_sample_idx + 1) % _bw_samples.size();
+	_btl_bw = *std::max_element(_bw_samples.cbegin(), _bw_samples.cend());
+
+	if (_mode == Mode::STARTUP) {
+		if (_btl_bw >= _full_bw * 1.25f) {
+			// still growing
+			_full_bw = _btl_bw;
+			_full_bw_rounds = 0;
+		} else if (++_full_bw_rounds >= 3) {
+			_filled_pipe = true;
+			_mode = Mode::DRAIN;
+			std::cout << "BBR: startup done, btl_bw:" << _btl_bw/1024.f << "KiB/s min_rtt:" << _min_rtt << "\n";
+		}
+	}
+}
+
+void BBR::updateMode(double now) {
+	if (_mode == Mode::DRAIN && _in_flight_bytes <= getBDP()) {
+		enterProbeBW(now);
+	}
+
+	if (_mode == Mode::PROBE_BW && !std::isinf(_min_rtt) && now - _cycle_stamp >= _min_rtt) {
+		_cycle_idx = (_cycle_idx + 1) % PROBE_BW_GAINS.size();
+		_cycle_stamp = now;
+	}
+
+	if (_mode != Mode::PROBE_RTT && !std::isinf(_min_rtt) && now - _min_rtt_stamp > MIN_RTT_EXPIRY) {
+		_mode = Mode::PROBE_RTT;
+		_probe_rtt_min = std::numeric_limits<float>::infinity();
+		_probe_rtt_done_stamp = now + std::max(PROBE_RTT_DURATION, _min_rtt);
+	}
+
+	if (_mode == Mode::PROBE_RTT && now >= _probe_rtt_done_stamp) {
+		if (!std::isinf(_probe_rtt_min)) {
+			_min_rtt = _probe_rtt_min;
+		}
+		_min_rtt_stamp = now;
+
+		if (_filled_pipe) {
+			enterProbeBW(now);
+		} else {
+			_mode = Mode::STARTUP;
+		}
+	}
+}
+
+void BBR::onCongestion(void) {
+	// the local send queue is full, we are faster than we can send
+	if (_mode == Mode::STARTUP) {
+		_filled_pipe = true;
+		_mode = Mode::DRAIN;
+	}
+	_pacer.reset();
+}
+
+float BBR::getPacingRate(void) const {
+	if (_btl_bw <= 0.f) {
+		return 0.f; // no estimate yet, only window limited
+	}
+	return getPacingGain() * _btl_bw;
+}
+
+float BBR::getWindow(void) const {
+	return std::min<float>(getCWnD(), FlowOnly::getWindow());
+}
+
+int64_t BBR::canSend(float time_delta) {
+	const double now = getTimeNow();
+	updateMode(now);
+
+	// flow window and pacing (to our rate)
+	const int64_t fspace_pkgs = FlowOnly::canSend(time_delta);
+
+	const int64_t window_space = getWindow() - _in_flight_bytes;
+	if (window_space < int64_t(MAXIMUM_SEGMENT_SIZE)) {
+		return 0u;
+	}
+
+	// limit to whole packets
+	return std::min<int64_t>(fspace_pkgs, (window_space / MAXIMUM_SEGMENT_SIZE) * MAXIMUM_SEGMENT_SIZE);
+}
+
+void BBR::onAck(std::vector<SeqIDType> seqs) {
+	if (seqs.empty()) {
+		return;
+	}
+
+	const double now = getTimeNow();
+
+	// needs to happen before flow only removes them
+	for (const auto& seq : seqs) {
+		if (const auto* fb = _in_flight.find(seq); fb != nullptr) {
+			_delivered += fb->bytes;
+		}
+	}
+
+	// only the primary is a clean rtt sample (and only if not resent)
+	if (const auto* fb = _in_flight.find(seqs.front()); fb != nullptr && !fb->ignore) {
+		const float rtt = now - fb->timestamp;
+		if (rtt <= _min_rtt) {
+			_min_rtt = rtt;
+			_min_rtt_stamp = now;
+		}
+		if (_mode == Mode::PROBE_RTT) {
+			_probe_rtt_min = std::min(_probe_rtt_min, rtt);
+		}
+	}
+
+	FlowOnly::onAck(std::move(seqs));
+
+	const float round_duration = std::isinf(_min_rtt) ? getCurrentRTT() : _min_rtt;
+	if (now - _round_start_time >= round_duration) {
+		onRoundEnd(now);
+	}
+
+	updateMode(now);
+}
+
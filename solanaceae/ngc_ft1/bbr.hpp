@@ -0,0 +1,79 @@
+#pragma once
+
+#include "./flow_only.hpp"
+
+#include <array>
+#include <limits>
+
+// model based, loosely follows bbr v1
+// estimates the bottleneck bandwidth and min rtt from the acks
+// and paces sends to that, keeping the queue (and rtt) low
+// loss and reordering are not used as congestion signals
+struct BBR : public FlowOnly {
+	public: // config
+		static constexpr float HIGH_GAIN {2.885f}; // 2/ln(2)
+		static constexpr float CWND_GAIN {2.f};
+		static constexpr size_t BW_FILTER_ROUNDS {10};
+		static constexpr float MIN_RTT_EXPIRY {10.f}; // sec
+		static constexpr float PROBE_RTT_DURATION {0.2f}; // sec
+		static constexpr size_t MIN_PIPE_SEGMENTS {4};
+		static constexpr size_t INITIAL_WINDOW_SEGMENTS {10};
+		static constexpr std::array<float, 8> PROBE_BW_GAINS {1.25f, 0.75f, 1.f, 1.f, 1.f, 1.f, 1.f, 1.f};
+
+	private:
+		enum class Mode {
+			STARTUP, // exponential growth until the bandwidth stops growing
+			DRAIN, // drain the queue created in startup
+			PROBE_BW, // cycle the pacing gain around the estimate
+			PROBE_RTT, // shrink the window to measure the min rtt again
+		} _mode {Mode::STARTUP};
+		bool _filled_pipe {false};
+
+		// windowed max of the delivery rate, one sample per round
+		std::array<float, BW_FILTER_ROUNDS> _bw_samples {};
+		size_t _bw_sample_idx {0};
+		float _btl_bw {0.f}; // bytes/sec
+
+		float _min_rtt {std::numeric_limits<float>::infinity()};
+		double _min_rtt_stamp {0.0};
+		float _probe_rtt_min {std::numeric_limits<float>::infinity()};
+		double _probe_rtt_done_stamp {0.0};
+
+		// delivery rate sampling, a round is ~min rtt
+		int64_t _delivered {0}; // bytes
+		int64_t _round_start_delivered {0};
+		double _round_start_time {getTimeNow()};
+
+		// startup exit
+		float _full_bw {0.f};
+		size_t _full_bw_rounds {0};
+
+		size_t _cycle_idx {0};
+		double _cycle_stamp {0.0};
+
+	private:
+		float getBDP(void) const;
+		float getPacingGain(void) const;
+		float getCWnD(void) const;
+
+		void enterProbeBW(double now);
+		void onRoundEnd(double now);
+		void updateMode(double now);
+
+		void onCongestion(void) override;
+
+		float getPacingRate(void) const override;
+
+	public: // api
+		BBR(size_t maximum_segment_data_size) : FlowOnly(maximum_segment_data_size) {}
+		virtual ~BBR(void) {}
+
+		float getWindow(void) const override;
+
+		// paced to the bandwidth estimate
+		int64_t canSend(float time_delta) override;
+
+	public: // callbacks
+		void onAck(std::vector<SeqIDType> seqs) override;
+};
+
@@ -0,0 +1,152 @@
+// throughput of the per peer send work over the number of peers, serial vs send threads
+// mirrors what NGCFT1::iteratePeerSend() does per segment (cca, send buffer, send_data, packet, queue),
+// tox is replaced by draining the per thread queues on the calling thread
+// usage: bench_send_threads [max_threads]
+
+#include "./worker_pool.hpp"
+#include "./cca.hpp"
+#include "./cca_factory.hpp"
+#include "./snd_buf.hpp"
+
+#include <solanaceae/ngc_ext/ngcext.hpp>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct BenchPeer {
+	std::unique_ptr<CCAI> cca;
+	SendSequenceBuffer ssb;
+	std::vector<uint16_t> sent_last_tick;
+	uint64_t file_pos {0};
+
+	// reused
+	std::vector<uint8_t> pkg;
+	std::vector<CCAI::SeqIDType> acks;
+};
+
+static constexpr size_t segment_size {1000};
+static constexpr size_t segments_per_tick {64};
+static constexpr size_t ticks {200};
+
+// stands in for the file
+static std::vector<uint8_t> g_file(4*1024*1024, 0x42);
+static std::mutex g_send_data_mutex;
+
+static void sendPeer(uint32_t peer_number, BenchPeer& peer, NGCEXTSendQueue& queue) {
+	// everything sent last tick got acked
+	if (!peer.sent_last_tick.empty()) {
+		peer.acks.clear();
+		for (const uint16_t seq_id : peer.sent_last_tick) {
+			peer.acks.push_back({0, seq_id});
+			peer.ssb.erase(seq_id);
+		}
+		peer.cca->onAck(peer.acks);
+		peer.sent_last_tick.clear();
+	}
+
+	peer.cca->canSend(0.005f); // not limiting, the acks are instant
+	peer.cca->getTimeouts();
+
+	for (size_t i = 0; i < segments_per_tick && !peer.ssb.full(); i++) {
+		const uint16_t seq_id = peer.ssb.add(segment_size);
+
+		{ // send_data
+			std::lock_guard lg{g_send_data_mutex};
+			const size_t offset = peer.file_pos % (g_file.size() - segment_size);
+			std::memcpy(peer.ssb.data(seq_id), g_file.data() + offset, segment_size);
+		}
+		peer.file_pos += segment_size;
+
+		const ByteSpan data = peer.ssb.get(seq_id);
+		peer.pkg.clear();
+		peer.pkg.push_back(0x8b); // FT1_DATA
+		peer.pkg.push_back(0); // transfer_id
+		peer.pkg.push_back(seq_id & 0xff);
+		peer.pkg.push_back(seq_id >> 8);
+		peer.pkg.insert(peer.pkg.end(), data.ptr, data.ptr + data.size);
+		if (!queue.push(0, peer_number, false, peer.pkg)) {
+			// full, not sized to happen here
+			peer.ssb.eraseLast(1);
+			peer.file_pos -= segment_size;
+			break;
+		}
+
+		peer.cca->onSent({0, seq_id}, data.size);
+		peer.sent_last_tick.push_back(seq_id);
+	}
+}
+
+// returns MiB/s
+static double runBench(size_t peer_count, size_t threads) {
+	std::vector<BenchPeer> peers(peer_count);
+	for (auto& peer : peers) {
+		peer.cca = createCCA(CCAType::CUBIC, segment_size);
+	}
+
+	std::unique_ptr<WorkerPool> pool;
+	if (threads > 1) {
+		pool = std::make_unique<WorkerPool>(threads);
+	}
+	// big enough for a whole tick each
+	const size_t queue_count = pool ? pool->size() : 1;
+	std::vector<NGCEXTSendQueue> queues;
+	queues.reserve(queue_count);
+	for (size_t i = 0; i < queue_count; i++) {
+		queues.emplace_back(peer_count*segments_per_tick);
+	}
+
+	uint64_t bytes {0};
+	const auto time_start = std::chrono::steady_clock::now();
+	for (size_t tick = 0; tick < ticks; tick++) {
+		if (pool) {
+			pool->parallelFor(peers.size(), [&](size_t worker, size_t i) {
+				sendPeer(i, peers[i], queues[worker]);
+			});
+		} else {
+			for (size_t i = 0; i < peers.size(); i++) {
+				sendPeer(i, peers[i], queues.front());
+			}
+		}
+
+		// "tox"
+		for (auto& queue : queues) {
+			for (size_t i = 0; i < queue.size(); i++) {
+				bytes += queue[i].data.size();
+			}
+			queue.clear();
+		}
+	}
+	const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - time_start;
+
+	return (bytes / (1024.*1024.)) / duration.count();
+}
+
+int main(int argc, char** argv) {
+	size_t max_threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+	if (argc > 1) {
+		max_threads = std::max<size_t>(std::stoul(argv[1]), 1);
+	}
+
+	std::cout << "peers";
+	for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+		std::cout << "\tt" << threads << "(MiB/s)";
+	}
+	std::cout << "\n";
+
+	for (size_t peer_count = 1; peer_count <= 64; peer_count *= 2) {
+		std::cout << peer_count;
+		for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+			std::cout << "\t" << static_cast<int64_t>(runBench(peer_count, threads));
+		}
+		std::cout << "\n";
+	}
+
+	return 0;
+}
+
@@ -0,0 +1,134 @@
+// wakeups per second of NGCFT1::iterate() with N open but idle transfers
+// the transfers are accepted receiving transfers whose data never arrives,
+// the loop sleeps for whatever iterate() returns, like a client would
+// tox is replaced by a stub that drops all packets
+// usage: bench_wakeups [seconds_per_run]
+
+#include "./ngcft1.hpp"
+
+#include <solanaceae/ngc_ext/ngcext.hpp>
+#include <solanaceae/toxcore/tox_default_impl.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct BenchTox : public ToxDefaultImpl {
+	uint64_t packets_sent {0};
+
+	uint32_t toxGroupMaxCustomLossyPacketLength(void) override {
+		return 1373;
+	}
+
+	std::tuple<std::optional<Tox_Connection>, Tox_Err_Group_Peer_Query> toxGroupPeerGetConnectionStatus(uint32_t, uint32_t) override {
+		return {TOX_CONNECTION_UDP, TOX_ERR_GROUP_PEER_QUERY_OK};
+	}
+
+	Tox_Err_Group_Send_Custom_Packet toxGroupSendCustomPacket(uint32_t, bool, const std::vector<uint8_t>&) override {
+		packets_sent++;
+		return TOX_ERR_GROUP_SEND_CUSTOM_PACKET_OK;
+	}
+
+	Tox_Err_Group_Send_Custom_Private_Packet toxGroupSendCustomPrivatePacket(uint32_t, uint32_t, bool, const std::vector<uint8_t>&) override {
+		packets_sent++;
+		return TOX_ERR_GROUP_SEND_CUSTOM_PRIVATE_PACKET_OK;
+	}
+};
+
+// accepts every offered transfer
+struct BenchAcceptor : public NGCFT1EventI {
+	bool onEvent(const Events::NGCFT1_recv_init& e) override {
+		e.accept = true;
+		return true;
+	}
+};
+
+struct BenchResult {
+	double wakeups_per_sec {0.};
+	double packets_per_sec {0.};
+	double iterate_us {0.}; // avg time spent in iterate()
+};
+
+static BenchResult runBench(size_t transfer_count, double seconds) {
+	BenchTox tox;
+	ToxEventProviderI tep;
+	NGCEXTEventProvider neep{tox, tep};
+	NGCFT1 nft{tox, tep, neep};
+
+	BenchAcceptor acceptor;
+	auto acceptor_sr = nft.newSubRef(&acceptor);
+	acceptor_sr.subscribe(NGCFT1_Event::recv_init);
+
+	// one transfer per peer, offered like a FT1_INIT2 from the network would
+	const std::vector<uint8_t> file_id(20, 0x42);
+	for (size_t i = 0; i < transfer_count; i++) {
+		static_cast<NGCEXTEventI&>(nft).onEvent(Events::NGCEXT_ft1_init2{
+			0, static_cast<uint32_t>(i),
+			0, // file_kind
+			1024*1024, // file_size
+			0, // transfer_id
+			0x00, // no features
+			ByteSpan{file_id},
+		});
+	}
+
+	// settle, the init_acks go out on the first iterate
+	float delta = nft.iterate(0.f);
+
+	tox.packets_sent = 0;
+	uint64_t wakeups {0};
+	std::chrono::duration<double> time_in_iterate {0.};
+
+	const auto time_start = std::chrono::steady_clock::now();
+	auto time_last = time_start;
+	while (std::chrono::steady_clock::now() - time_start < std::chrono::duration<double>(seconds)) {
+		std::this_thread::sleep_for(std::chrono::duration<float>(delta));
+
+		const auto time_now = std::chrono::steady_clock::now();
+		const float elapsed = std::chrono::duration<float>(time_now - time_last).count();
+		time_last = time_now;
+
+		delta = nft.iterate(elapsed);
+		wakeups++;
+		time_in_iterate += std::chrono::steady_clock::now() - time_now;
+	}
+	const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - time_start;
+
+	return {
+		wakeups / duration.count(),
+		tox.packets_sent / duration.count(),
+		wakeups > 0 ? time_in_iterate.count() * 1e6 / wakeups : 0.,
+	};
+}
+
+int main(int argc, char** argv) {
+	double seconds {5.};
+	if (argc > 1) {
+		seconds = std::stod(argv[1]);
+	}
+
+	// the per packet logging would drown the table
+	std::cout.setstate(std::ios::failbit);
+	std::cerr.setstate(std::ios::failbit);
+
+	std::vector<std::pair<size_t, BenchResult>> results;
+	for (size_t transfer_count : {0, 1, 10, 100, 1000}) {
+		results.emplace_back(transfer_count, runBench(transfer_count, seconds));
+	}
+
+	std::cout.clear();
+	std::cout << "transfers\twakeups/s\tpackets/s\titerate(us)\n";
+	for (const auto& [transfer_count, res] : results) {
+		std::cout
+			<< transfer_count << "\t"
+			<< res.wakeups_per_sec << "\t"
+			<< res.packets_per_sec << "\t"
+			<< res.iterate_us << "\n"
+		;
+	}
+
+	return 0;
+}
+
@@ -1,13 +1,16 @@
 #pragma once
 
+#include <solanaceae/util/span.hpp>
+
 #include <vector>
 #include <cstdint>
 #include <cstddef>
+#include <limits>
 
 // TODO: refactor, more state tracking in ccai and seperate into flow and congestion algos
 struct CCAI {
 	public: // config
-		using SeqIDType = std::pair<uint8_t, uint16_t>; // tf_id, seq_id
+		using SeqIDType = std::pair<uint16_t, uint16_t>; // tf_id, seq_id
 
 		static constexpr size_t IPV4_HEADER_SIZE {20};
 		static constexpr size_t IPV6_HEADER_SIZE {40}; // bru
@@ -21,11 +24,12 @@ struct CCAI {
 			IPV4_HEADER_SIZE
 		};
 
-		// TODO: make configurable, set with tox ngc lossy packet size
-		//const size_t MAXIMUM_SEGMENT_DATA_SIZE {1000-4};
-		const size_t MAXIMUM_SEGMENT_DATA_SIZE {500-4};
+		// set with the negotiated ngc lossy packet size, changed by segment size probing
+		// use setMaximumSegmentDataSize() to keep both in sync
+		//size_t MAXIMUM_SEGMENT_DATA_SIZE {1000-4};
+		size_t MAXIMUM_SEGMENT_DATA_SIZE {500-4};
 
-		const size_t MAXIMUM_SEGMENT_SIZE {MAXIMUM_SEGMENT_DATA_SIZE + SEGMENT_OVERHEAD}; // tox 500 - 4 from ft
+		size_t MAXIMUM_SEGMENT_SIZE {MAXIMUM_SEGMENT_DATA_SIZE + SEGMENT_OVERHEAD}; // tox 500 - 4 from ft
 		//static_assert(maximum_segment_size == 574); // mesured in wireshark
 
 		// flow control
@@ -42,6 +46,12 @@ struct CCAI {
 		CCAI(size_t maximum_segment_data_size) : MAXIMUM_SEGMENT_DATA_SIZE(maximum_segment_data_size) {}
 		virtual ~CCAI(void) {}
 
+		// segments already in flight keep their size
+		void setMaximumSegmentDataSize(size_t maximum_segment_data_size) {
+			MAXIMUM_SEGMENT_DATA_SIZE = maximum_segment_data_size;
+			MAXIMUM_SEGMENT_SIZE = maximum_segment_data_size + SEGMENT_OVERHEAD;
+		}
+
 		// returns current rtt/delay
 		// inf on error or uninitialized
 		virtual float getCurrentRTT(void) const = 0;
@@ -54,8 +64,17 @@ struct CCAI {
 		// respect max_byterate_allowed
 		virtual int64_t canSend(float time_delta) = 0;
 
-		// get the list of timed out seq_ids
-		virtual std::vector<SeqIDType> getTimeouts(void) = 0;
+		// get the list of timed out seq_ids, oldest first
+		// only valid until the next call
+		virtual Span<SeqIDType> getTimeouts(void) = 0;
+
+		// seconds until the next in flight seq_id times out, 0 if already overdue
+		// +inf if nothing is in flight (or not implemented)
+		virtual float getTimeUntilNextTimeout(void) const { return std::numeric_limits<float>::infinity(); }
+
+		// seconds until canSend() has room for a segment again because of pacing (next release time)
+		// 0 if it has room now (or no pacing), +inf if we are waiting on the window (acks)
+		virtual float getTimeUntilNextSend(void) const { return 0.f; }
 
 		// returns -1 if not implemented, can return 0
 		virtual int64_t inFlightCount(void) const { return -1; }
@@ -63,10 +82,17 @@ struct CCAI {
 		// returns -1 if not implemented, can return 0
 		virtual int64_t inFlightBytes(void) const { return -1; }
 
+		// fraction of sent segments that got lost (timed out), moving average over segments
+		float getLossRate(void) const { return _loss_rate; }
+
 	public: // callbacks
 		// data size is without overhead
 		virtual void onSent(SeqIDType seq, size_t data_size) = 0;
 
+		// sent, but never acked or resent (eg. fec parity), only counts against the send rate
+		// data size is without overhead
+		virtual void onSentUntracked(size_t data_size) { (void)data_size; }
+
 		// TODO: copy???
 		virtual void onAck(std::vector<SeqIDType> seqs) = 0;
 
@@ -76,5 +102,15 @@ struct CCAI {
 
 		// signal congestion externally (eg. send queue is full)
 		virtual void onCongestion(void) {};
+
+	protected:
+		static constexpr float LOSS_RATE_ALPHA {0.02f}; // weight of a single segment
+
+		float _loss_rate {0.f};
+
+		// call per acked (false) and per lost (true) segment
+		void addLossSample(bool lost) {
+			_loss_rate += LOSS_RATE_ALPHA * ((lost ? 1.f : 0.f) - _loss_rate);
+		}
 };
 
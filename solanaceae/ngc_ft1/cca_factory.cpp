@@ -0,0 +1,29 @@
+#include "./cca_factory.hpp"
+
+#include "./flow_only.hpp"
+#include "./cubic.hpp"
+#include "./ledbat.hpp"
+#include "./bbr.hpp"
+
+const char* to_string(CCAType type) {
+	switch (type) {
+		case CCAType::FLOW_ONLY: return "FlowOnly";
+		case CCAType::CUBIC: return "CUBIC";
+		case CCAType::LEDBAT: return "LEDBAT";
+		case CCAType::BBR: return "BBR";
+		case CCAType::AUTO: return "auto";
+	}
+	return "unknown";
+}
+
+std::unique_ptr<CCAI> createCCA(CCAType type, size_t maximum_segment_data_size) {
+	switch (type) {
+		case CCAType::FLOW_ONLY: return std::make_unique<FlowOnly>(maximum_segment_data_size);
+		case CCAType::CUBIC: return std::make_unique<CUBIC>(maximum_segment_data_size);
+		case CCAType::LEDBAT: return std::make_unique<LEDBAT>(maximum_segment_data_size);
+		case CCAType::BBR: return std::make_unique<BBR>(maximum_segment_data_size);
+		case CCAType::AUTO: return std::make_unique<LEDBAT>(maximum_segment_data_size);
+	}
+	return nullptr;
+}
+
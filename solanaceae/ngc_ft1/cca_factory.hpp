@@ -0,0 +1,23 @@
+#pragma once
+
+#include "./cca.hpp"
+
+#include <memory>
+#include <cstdint>
+
+enum class CCAType : uint8_t {
+	FLOW_ONLY,
+	CUBIC,
+	LEDBAT,
+	BBR,
+
+	// not an algorithm of its own, NGCFT1 starts with LEDBAT (background bulk)
+	// and switches to CUBIC when queueing delay is not the bottleneck (and back)
+	AUTO,
+};
+
+const char* to_string(CCAType type);
+
+// AUTO creates the start algorithm (LEDBAT)
+std::unique_ptr<CCAI> createCCA(CCAType type, size_t maximum_segment_data_size);
+
@@ -98,15 +98,7 @@ int64_t CUBIC::canSend(float time_delta) {
 		return 0u;
 	}
 
-	// also limit to max sendrate per tick, which is usually smaller than window
-	// this is mostly to prevent spikes on empty windows
-	const auto rate = window / getCurrentRTT();
-
-	// TODO: time slicing alla flow
-
-	// we dont want this limit to fall below atleast 1 segment
-	const int64_t max_bytes_per_tick = std::max<int64_t>(rate * time_delta + 0.5f, MAXIMUM_SEGMENT_SIZE);
-	cspace_bytes = std::min<int64_t>(cspace_bytes, max_bytes_per_tick);
+	// the flow already paced to window/rtt (with our cwnd)
 
 	// limit to whole packets
 	int64_t cspace_pkgs = (cspace_bytes / MAXIMUM_SEGMENT_SIZE) * MAXIMUM_SEGMENT_SIZE;
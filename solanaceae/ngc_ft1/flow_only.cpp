@@ -43,6 +43,11 @@ float FlowOnly::getWindow(void) const {
 	return _fwnd;
 }
 
+float FlowOnly::getPacingRate(void) const {
+	// uses the most restrictive window of the derived algo
+	return PACING_GAIN * getWindow() / getCurrentRTT();
+}
+
 int64_t FlowOnly::canSend(float time_delta) {
 	// a time slice is ~8rtts
 	_sa_reorders.update(time_delta, getCurrentRTT()*8.f, [this](float avg, float avg2, float dev, float stage_avg, float state_dev, size_t stage_count) -> bool {
@@ -66,22 +71,19 @@ int64_t FlowOnly::canSend(float time_delta) {
 
 	updateWindow();
 
+	// spread the window over the rtt, instead of sending it at once
+	_pacer.update(time_delta, getPacingRate(), 2.f * MAXIMUM_SEGMENT_SIZE);
+
 	int64_t fspace_bytes = _fwnd - _in_flight_bytes;
 	if (fspace_bytes < MAXIMUM_SEGMENT_DATA_SIZE) {
 		return 0u;
 	}
 
-	// TODO: borked somehow, eg 15 limit results in ~12
-	// also limit to max sendrate per tick, which is usually smaller than window
-	// this is mostly to prevent spikes on empty windows
 	fspace_bytes = std::min<int64_t>({
 		fspace_bytes,
-
-		// slice window into time time_delta sized chunks and only allow 1.5 chunks sized per tick
-		int64_t((1.5f * _fwnd) / time_delta + 0.5f),
-
-		// similar, but without current delay in the equation (fallback)
-		int64_t(1.2f * max_byterate_allowed * time_delta + 0.5f),
+		_pacer.available(),
+		// never more than the allowed rate (fallback)
+		int64_t(1.2f * max_byterate_allowed * time_delta + 0.5f) + int64_t(MAXIMUM_SEGMENT_SIZE),
 	});
 
 	// limit to whole packets
@@ -95,26 +97,48 @@ int64_t FlowOnly::canSend(float time_delta) {
 	return fspace_pkgs;
 }
 
-std::vector<FlowOnly::SeqIDType> FlowOnly::getTimeouts(void) {
-	std::vector<SeqIDType> list;
-	list.reserve(_in_flight.size()/3); // we dont know, so we just guess
+Span<FlowOnly::SeqIDType> FlowOnly::getTimeouts(void) {
+	_timeouts.clear();
 
 	// after 6 rtt delay, we trigger timeout
-	const auto now_adjusted = getTimeNow() - getCurrentRTT()*6.f;
-
-	for (auto& [seq, time_stamp, size, acc, _] : _in_flight) {
-		if (now_adjusted > time_stamp) {
-			// make it so timed out packets no longer count as in-flight
-			if (acc) {
-				acc = false;
-				_in_flight_bytes -= size;
-				assert(_in_flight_bytes >= 0);
-			}
-			list.push_back(seq);
+	const auto now_adjusted = getTimeNow() - getCurrentRTT()*TIMEOUT_RTTS;
+
+	// the list is in (re)send order, so timestamps are ascending
+	// and we only need to look at the expired front
+	_in_flight.for_each_while([&](const SeqIDType seq, FlyingBunch& fb) -> bool {
+		if (now_adjusted <= fb.timestamp) {
+			return false;
 		}
+
+		// make it so timed out packets no longer count as in-flight
+		if (fb.accounted) {
+			fb.accounted = false;
+			_in_flight_bytes -= fb.bytes;
+			assert(_in_flight_bytes >= 0);
+		}
+		_timeouts.push_back(seq);
+		return true;
+	});
+
+	return Span<SeqIDType>{_timeouts.data(), _timeouts.size()};
+}
+
+float FlowOnly::getTimeUntilNextTimeout(void) const {
+	// resends are moved to the back, so the front is the oldest
+	const auto* oldest = _in_flight.front();
+	if (oldest == nullptr) {
+		return std::numeric_limits<float>::infinity();
+	}
+
+	return std::max<float>(oldest->timestamp + getCurrentRTT()*TIMEOUT_RTTS - getTimeNow(), 0.f);
+}
+
+float FlowOnly::getTimeUntilNextSend(void) const {
+	if (getWindow() - _in_flight_bytes < MAXIMUM_SEGMENT_SIZE) {
+		return std::numeric_limits<float>::infinity(); // waiting for acks
 	}
 
-	return list;
+	return _pacer.timeUntil(MAXIMUM_SEGMENT_SIZE);
 }
 
 int64_t FlowOnly::inFlightCount(void) const {
@@ -126,20 +150,11 @@ int64_t FlowOnly::inFlightBytes(void) const {
 }
 
 void FlowOnly::onSent(SeqIDType seq, size_t data_size) {
-	if constexpr (true) {
-		size_t sum {0u};
-		for (const auto& it : _in_flight) {
-			assert(it.id != seq);
-			if (it.accounted) {
-				sum += it.bytes;
-			}
-		}
-		assert(_in_flight_bytes == sum);
-	}
+	assert(_in_flight.find(seq) == nullptr);
 
-	const auto& new_entry = _in_flight.emplace_back(
+	const auto& new_entry = _in_flight.push_back(
+		seq,
 		FlyingBunch{
-			seq,
 			static_cast<float>(getTimeNow()),
 			data_size + SEGMENT_OVERHEAD,
 			true,
@@ -147,10 +162,15 @@ void FlowOnly::onSent(SeqIDType seq, size_t data_size) {
 		}
 	);
 	_in_flight_bytes += new_entry.bytes;
+	_pacer.onSent(new_entry.bytes);
 
 	_time_point_last_update = getTimeNow();
 }
 
+void FlowOnly::onSentUntracked(size_t data_size) {
+	_pacer.onSent(data_size + SEGMENT_OVERHEAD);
+}
+
 void FlowOnly::onAck(std::vector<SeqIDType> seqs) {
 	if (seqs.empty()) {
 		assert(false && "got empty list of acks???");
@@ -164,14 +184,12 @@ void FlowOnly::onAck(std::vector<SeqIDType> seqs) {
 	// first seq in seqs is the actual value, all extra are for redundency
 	{ // skip in ack is congestion event
 		// 1. look at primary ack of packet
-		auto it = std::find_if(_in_flight.begin(), _in_flight.end(), [seq = seqs.front()](const auto& v) -> bool {
-			return v.id == seq;
-		});
-		if (it != _in_flight.end() && !it->ignore) {
+		auto* it = _in_flight.find(seqs.front());
+		if (it != nullptr && !it->ignore) {
 			// find first non ignore, it should be the expected
-			auto first_it = std::find_if_not(_in_flight.begin(), _in_flight.end(), [](const auto& v) -> bool { return v.ignore; });
+			auto* first_it = _in_flight.find_first([](const auto& v) -> bool { return !v.ignore; });
 
-			if (first_it != _in_flight.cend() && it != first_it && !first_it->ignore) {
+			if (first_it != nullptr && it != first_it && !first_it->ignore) {
 				// not next expected seq -> skip detected
 
 				_sa_reorders.addValue(1.f);
@@ -196,11 +214,9 @@ void FlowOnly::onAck(std::vector<SeqIDType> seqs) {
 	}
 
 	for (const auto& seq : seqs) {
-		auto it = std::find_if(_in_flight.begin(), _in_flight.end(), [seq](const auto& v) -> bool {
-			return v.id == seq;
-		});
+		auto* it = _in_flight.find(seq);
 
-		if (it == _in_flight.end()) {
+		if (it == nullptr) {
 			continue; // not found, ignore
 		} else {
 			//most_recent = std::max(most_recent, std::get<1>(*it));
@@ -209,19 +225,17 @@ void FlowOnly::onAck(std::vector<SeqIDType> seqs) {
 				assert(_in_flight_bytes >= 0);
 			}
 			//_recently_acked_data += std::get<2>(*it);
-			_in_flight.erase(it); // TODO: bundle using remove
+			_in_flight.erase(seq);
+			addLossSample(false);
 		}
 	}
 }
 
 bool FlowOnly::onLoss(SeqIDType seq, bool discard) {
-	auto it = std::find_if(_in_flight.begin(), _in_flight.end(), [seq](const auto& v) -> bool {
-		assert(!std::isnan(v.timestamp));
-		return v.id == seq;
-	});
+	auto* it = _in_flight.find(seq);
 
 	// we care about it still being there, when we do not discard
-	if (it == _in_flight.end()) {
+	if (it == nullptr) {
 		if (!discard) {
 			std::cerr << "FLOW seq not found!\n";
 		}
@@ -236,14 +250,20 @@ bool FlowOnly::onLoss(SeqIDType seq, bool discard) {
 			_in_flight_bytes -= it->bytes;
 			assert(_in_flight_bytes >= 0);
 		}
-		_in_flight.erase(it);
+		_in_flight.erase(seq);
 		if (_in_flight.empty()) {
 			assert(_in_flight_bytes == 0);
 		}
 		return true;
 	} else {
+		addLossSample(true);
+
 		// and not take into rtt
 		it->timestamp = getTimeNow();
+		// gets resent
+		_pacer.onSent(it->bytes);
+		// keeps the list in (re)send order
+		_in_flight.moveToBack(seq);
 	}
 
 	// usually after data arrived out-of-order/duplicate
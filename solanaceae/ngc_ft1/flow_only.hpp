@@ -3,6 +3,8 @@
 #include "./cca.hpp"
 
 #include "./staged_ema.hpp"
+#include "./in_flight_list.hpp"
+#include "./pacer.hpp"
 
 #include <chrono>
 #include <vector>
@@ -17,6 +19,8 @@ struct FlowOnly : public CCAI {
 		static constexpr float RTT_EMA_ALPHA = 0.0002f; // might need change over time
 		static constexpr float RTT_UP_MAX = 3.0f; // how much larger a delay can be to be taken into account
 		static constexpr float RTT_MAX = 2.f; // maybe larger for tunneled connections
+		static constexpr float TIMEOUT_RTTS = 6.f; // how many rtts until a packet counts as timed out
+		static constexpr float PACING_GAIN = 1.25f; // pace a bit faster than window/rtt, so the window can grow
 
 	protected:
 		// initialize to low value, will get corrected very fast
@@ -28,7 +32,6 @@ struct FlowOnly : public CCAI {
 
 		// list of sequence ids and timestamps of when they where sent (and payload size)
 		struct FlyingBunch {
-			SeqIDType id;
 			float timestamp;
 			size_t bytes;
 
@@ -38,11 +41,16 @@ struct FlowOnly : public CCAI {
 			// set if counted as ce or resent due to timeout
 			bool ignore {false};
 		};
-		std::vector<FlyingBunch> _in_flight;
+		InFlightList<FlyingBunch> _in_flight;
+
+		// reused by getTimeouts()
+		std::vector<SeqIDType> _timeouts;
 		int64_t _in_flight_bytes {0};
 
 		StagedEMA _sa_reorders;
 
+		Pacer _pacer;
+
 		clock::time_point _time_start_offset;
 
 		// used to clamp growth rate in the void
@@ -69,6 +77,9 @@ struct FlowOnly : public CCAI {
 
 		void updateWindow(void);
 
+		// bytes/sec, <= 0 or inf to not pace
+		virtual float getPacingRate(void) const;
+
 	public: // api
 		FlowOnly(size_t maximum_segment_data_size) : CCAI(maximum_segment_data_size) {}
 		virtual ~FlowOnly(void) {}
@@ -79,7 +90,11 @@ struct FlowOnly : public CCAI {
 		int64_t canSend(float time_delta) override;
 
 		// get the list of timed out seq_ids
-		std::vector<SeqIDType> getTimeouts(void) override;
+		Span<SeqIDType> getTimeouts(void) override;
+
+		float getTimeUntilNextTimeout(void) const override;
+
+		float getTimeUntilNextSend(void) const override;
 
 		int64_t inFlightCount(void) const override;
 		int64_t inFlightBytes(void) const override;
@@ -87,6 +102,7 @@ struct FlowOnly : public CCAI {
 	public: // callbacks
 		// data size is without overhead
 		void onSent(SeqIDType seq, size_t data_size) override;
+		void onSentUntracked(size_t data_size) override;
 
 		void onAck(std::vector<SeqIDType> seqs) override;
 
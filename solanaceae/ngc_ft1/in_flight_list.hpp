@@ -0,0 +1,166 @@
+#pragma once
+
+#include "./cca.hpp"
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cassert>
+
+// segments sent but not yet acked, in the order they were (re)sent
+// O(1) lookup by seq_id, append, move to back and erase
+// (doubly linked list on top of a slab, plus an index)
+template<typename T>
+class InFlightList {
+	public:
+		using SeqIDType = CCAI::SeqIDType;
+
+	private:
+		static constexpr uint32_t NIL {0xffffffffu};
+
+		struct Node {
+			SeqIDType id;
+			T value;
+			uint32_t prev {NIL};
+			uint32_t next {NIL}; // also used for the free list
+		};
+		std::vector<Node> _nodes;
+		uint32_t _head {NIL};
+		uint32_t _tail {NIL};
+		uint32_t _free {NIL};
+		size_t _size {0};
+
+		std::unordered_map<uint32_t, uint32_t> _index; // seq key -> node
+
+		static uint32_t key(SeqIDType id) {
+			return (uint32_t(id.first) << 16) | id.second;
+		}
+
+		void unlink(uint32_t node_idx) {
+			auto& node = _nodes[node_idx];
+			if (node.prev != NIL) {
+				_nodes[node.prev].next = node.next;
+			} else {
+				_head = node.next;
+			}
+			if (node.next != NIL) {
+				_nodes[node.next].prev = node.prev;
+			} else {
+				_tail = node.prev;
+			}
+			node.prev = NIL;
+			node.next = NIL;
+		}
+
+		void linkBack(uint32_t node_idx) {
+			auto& node = _nodes[node_idx];
+			node.prev = _tail;
+			node.next = NIL;
+			if (_tail != NIL) {
+				_nodes[_tail].next = node_idx;
+			} else {
+				_head = node_idx;
+			}
+			_tail = node_idx;
+		}
+
+	public:
+		bool empty(void) const { return _size == 0; }
+		size_t size(void) const { return _size; }
+
+		// nullptr if not in flight
+		T* find(SeqIDType id) {
+			const auto it = _index.find(key(id));
+			if (it == _index.end()) {
+				return nullptr;
+			}
+			return &_nodes[it->second].value;
+		}
+
+		// oldest (re)sent, nullptr if empty
+		T* front(void) {
+			return _head == NIL ? nullptr : &_nodes[_head].value;
+		}
+		const T* front(void) const {
+			return _head == NIL ? nullptr : &_nodes[_head].value;
+		}
+
+		// id must not be in flight already
+		T& push_back(SeqIDType id, const T& value) {
+			assert(_index.count(key(id)) == 0);
+
+			uint32_t node_idx = _free;
+			if (node_idx != NIL) {
+				_free = _nodes[node_idx].next;
+				_nodes[node_idx].id = id;
+				_nodes[node_idx].value = value;
+			} else {
+				node_idx = _nodes.size();
+				_nodes.push_back({id, value});
+			}
+
+			linkBack(node_idx);
+			_index[key(id)] = node_idx;
+			_size++;
+
+			return _nodes[node_idx].value;
+		}
+
+		// eg. when resent
+		void moveToBack(SeqIDType id) {
+			const auto it = _index.find(key(id));
+			if (it == _index.end()) {
+				return;
+			}
+			unlink(it->second);
+			linkBack(it->second);
+		}
+
+		// returns false if not found
+		bool erase(SeqIDType id) {
+			const auto it = _index.find(key(id));
+			if (it == _index.end()) {
+				return false;
+			}
+
+			const uint32_t node_idx = it->second;
+			_index.erase(it);
+			unlink(node_idx);
+			_nodes[node_idx].next = _free;
+			_free = node_idx;
+			_size--;
+
+			return true;
+		}
+
+		// in (re)send order
+		// fn is void(SeqIDType, T&)
+		template<typename FN>
+		void for_each(FN&& fn) {
+			for (uint32_t i = _head; i != NIL; i = _nodes[i].next) {
+				fn(_nodes[i].id, _nodes[i].value);
+			}
+		}
+
+		// in (re)send order, until fn returns false
+		// fn is bool(SeqIDType, T&)
+		template<typename FN>
+		void for_each_while(FN&& fn) {
+			for (uint32_t i = _head; i != NIL; i = _nodes[i].next) {
+				if (!fn(_nodes[i].id, _nodes[i].value)) {
+					return;
+				}
+			}
+		}
+
+		// first in (re)send order where pred(T&) is true, nullptr if none
+		template<typename FN>
+		T* find_first(FN&& pred) {
+			for (uint32_t i = _head; i != NIL; i = _nodes[i].next) {
+				if (pred(_nodes[i].value)) {
+					return &_nodes[i].value;
+				}
+			}
+			return nullptr;
+		}
+};
@@ -14,7 +14,7 @@
 
 // https://youtu.be/0HRwNSA-JYM
 
-static bool isSkipSeqID(const std::pair<uint8_t, uint16_t>& a, const std::pair<uint8_t, uint16_t>& b) {
+static bool isSkipSeqID(const LEDBAT::SeqIDType& a, const LEDBAT::SeqIDType& b) {
 	// this is not perfect, would need more ft id based history
 	if (a.first != b.first) {
 		return false; // we dont know
@@ -30,6 +30,9 @@ LEDBAT::LEDBAT(size_t maximum_segment_data_size) : CCAI(maximum_segment_data_siz
 }
 
 int64_t LEDBAT::canSend(float time_delta) {
+	// spread the window over the rtt, instead of sending it at once
+	_pacer.update(time_delta, 1.25f * std::min(_cwnd, _fwnd) / getCurrentRTT(), 2.f * MAXIMUM_SEGMENT_SIZE);
+
 	if (_in_flight.empty()) {
 		return MAXIMUM_SEGMENT_DATA_SIZE;
 	}
@@ -44,22 +47,59 @@ int64_t LEDBAT::canSend(float time_delta) {
 		return 0u;
 	}
 
-	return std::ceil(std::min<float>(cspace, fspace) / MAXIMUM_SEGMENT_DATA_SIZE) * MAXIMUM_SEGMENT_DATA_SIZE;
+	// the pacer counts the overhead too
+	const int64_t pspace = _pacer.available() / int64_t(MAXIMUM_SEGMENT_SIZE) * int64_t(MAXIMUM_SEGMENT_DATA_SIZE);
+
+	const int64_t space = std::min<int64_t>({cspace, fspace, pspace});
+	if (space < MAXIMUM_SEGMENT_DATA_SIZE) {
+		return 0u;
+	}
+
+	// whole segments, rounding up would overdraw the pacer
+	return (space / MAXIMUM_SEGMENT_DATA_SIZE) * MAXIMUM_SEGMENT_DATA_SIZE;
 }
 
-std::vector<LEDBAT::SeqIDType> LEDBAT::getTimeouts(void) {
-	std::vector<LEDBAT::SeqIDType> list;
+float LEDBAT::getTimeUntilNextSend(void) const {
+	if (std::min(_cwnd, _fwnd) - _in_flight_bytes < MAXIMUM_SEGMENT_DATA_SIZE) {
+		return std::numeric_limits<float>::infinity(); // waiting for acks
+	}
 
-	// after 2 delays we trigger timeout
-	const auto now_adjusted = getTimeNow() - getCurrentRTT()*2.f;
+	return _pacer.timeUntil(MAXIMUM_SEGMENT_DATA_SIZE);
+}
+
+Span<LEDBAT::SeqIDType> LEDBAT::getTimeouts(void) {
+	_timeouts.clear();
+
+	const auto now_adjusted = getTimeNow() - getTimeoutDelay();
 
+	// in send order, timestamps are ascending
 	for (const auto& [seq, time_stamp, size] : _in_flight) {
-		if (now_adjusted > time_stamp) {
-			list.push_back(seq);
+		if (now_adjusted <= time_stamp) {
+			break;
 		}
+		_timeouts.push_back(seq);
 	}
 
-	return list;
+	return Span<SeqIDType>{_timeouts.data(), _timeouts.size()};
+}
+
+float LEDBAT::getTimeUntilNextTimeout(void) const {
+	// resends are moved to the back, so the front is the oldest
+	if (_in_flight.empty()) {
+		return std::numeric_limits<float>::infinity();
+	}
+
+	return std::max<float>(std::get<1>(_in_flight.front()) + getTimeoutDelay() - getTimeNow(), 0.f);
+}
+
+float LEDBAT::getTimeoutDelay(void) const {
+	// after 2 delays we trigger timeout
+	const float rtt = getCurrentRTT();
+	if (!std::isfinite(rtt)) {
+		// no sample yet, without this a lost first flight would never time out
+		return TIMEOUT_INITIAL;
+	}
+	return rtt*TIMEOUT_RTTS;
 }
 
 
@@ -73,6 +113,11 @@ void LEDBAT::onSent(SeqIDType seq, size_t data_size) {
 	_in_flight.push_back({seq, getTimeNow(), data_size + SEGMENT_OVERHEAD});
 	_in_flight_bytes += data_size + SEGMENT_OVERHEAD;
 	_recently_sent_bytes += data_size + SEGMENT_OVERHEAD;
+	_pacer.onSent(data_size + SEGMENT_OVERHEAD);
+}
+
+void LEDBAT::onSentUntracked(size_t data_size) {
+	_pacer.onSent(data_size + SEGMENT_OVERHEAD);
 }
 
 void LEDBAT::onAck(std::vector<SeqIDType> seqs) {
@@ -121,6 +166,7 @@ void LEDBAT::onAck(std::vector<SeqIDType> seqs) {
 			_recently_acked_data += std::get<2>(*it);
 			assert(_in_flight_bytes >= 0); // TODO: this triggers
 			_in_flight.erase(it);
+			addLossSample(false);
 		}
 	}
 
@@ -151,8 +197,16 @@ bool LEDBAT::onLoss(SeqIDType seq, bool discard) {
 		_in_flight_bytes -= std::get<2>(*it);
 		assert(_in_flight_bytes >= 0);
 		_in_flight.erase(it);
+	} else {
+		addLossSample(true);
+
+		// gets resent, times out again from now
+		// moved to the back, so _in_flight stays in send order
+		auto entry = *it;
+		std::get<1>(entry) = getTimeNow();
+		_in_flight.erase(it);
+		_in_flight.push_back(entry);
 	}
-	// TODO: reset timestamp?
 
 #if 0 // temporarily disable ce for timeout
 	// at most once per rtt?
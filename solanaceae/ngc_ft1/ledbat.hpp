@@ -1,6 +1,7 @@
 #pragma once
 
 #include "./cca.hpp"
+#include "./pacer.hpp"
 
 #include <chrono>
 #include <deque>
@@ -14,7 +15,7 @@
 struct LEDBAT : public CCAI {
 	public: // config
 #if 0
-		using SeqIDType = std::pair<uint8_t, uint16_t>; // tf_id, seq_id
+		using SeqIDType = std::pair<uint16_t, uint16_t>; // tf_id, seq_id
 
 		static constexpr size_t IPV4_HEADER_SIZE {20};
 		static constexpr size_t IPV6_HEADER_SIZE {40}; // bru
@@ -45,6 +46,9 @@ struct LEDBAT : public CCAI {
 		// TODO: use a factor for multiple of rtt
 		static constexpr size_t current_delay_filter_window {16*4};
 
+		static constexpr float TIMEOUT_RTTS {2.f}; // how many rtts until a packet counts as timed out
+		static constexpr float TIMEOUT_INITIAL {1.f}; // sec, before the first rtt sample (rfc 6298)
+
 		//static constexpr size_t rtt_buffer_size_max {2000};
 
 	public:
@@ -63,11 +67,16 @@ struct LEDBAT : public CCAI {
 		int64_t canSend(float time_delta) override;
 
 		// get the list of timed out seq_ids
-		std::vector<SeqIDType> getTimeouts(void) override;
+		Span<SeqIDType> getTimeouts(void) override;
+
+		float getTimeUntilNextTimeout(void) const override;
+
+		float getTimeUntilNextSend(void) const override;
 
 	public: // callbacks
 		// data size is without overhead
 		void onSent(SeqIDType seq, size_t data_size) override;
+		void onSentUntracked(size_t data_size) override;
 
 		void onAck(std::vector<SeqIDType> seqs) override;
 
@@ -89,6 +98,9 @@ struct LEDBAT : public CCAI {
 
 		void addRTT(float new_delay);
 
+		// after how long in flight a packet counts as timed out
+		float getTimeoutDelay(void) const;
+
 		void updateWindows(void);
 
 	private: // state
@@ -120,9 +132,14 @@ struct LEDBAT : public CCAI {
 		// list of sequence ids and timestamps of when they where sent
 		std::deque<std::tuple<SeqIDType, float, size_t>> _in_flight;
 
+		// reused by getTimeouts()
+		std::vector<SeqIDType> _timeouts;
+
+		Pacer _pacer;
+
 		int64_t _in_flight_bytes {0};
 
-		SeqIDType _last_ack_got {0xff, 0xffff}; // some default
+		SeqIDType _last_ack_got {0xffff, 0xffff}; // some default
 
 	private: // helper
 		clock::time_point _time_start_offset;
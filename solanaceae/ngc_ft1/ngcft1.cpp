@@ -1,8 +1,6 @@
 #include "./ngcft1.hpp"
 
 #include "./flow_only.hpp"
-#include "./cubic.hpp"
-#include "./ledbat.hpp"
 
 #include <solanaceae/util/utils.hpp>
 
@@ -10,17 +8,33 @@
 
 #include <cstdint>
 #include <iostream>
-#include <set>
 #include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <vector>
 #include <limits>
 
-void NGCFT1::updateSendTransferPhase1(float time_delta, uint32_t group_number, uint32_t peer_number, Group::Peer& peer, size_t idx, std::set<CCAI::SeqIDType>& timeouts_set, int64_t& can_packet_size) {
+// features we advertise in init2 and accept in init_ack
+// zstd is only advertised for data that is marked as compressible
+// FT1_FEATURE_ZSTD_DICT depends on the dictionaries set
+static constexpr uint8_t ft1_supported_features {FT1_FEATURE_SACK | FT1_FEATURE_FEC | FT1_FEATURE_ZSTD | FT1_FEATURE_WIDE_IDS};
+
+// FT1_DATA_FEC header is this much bigger than the FT1_DATA header
+static constexpr size_t fec_header_extra {3};
+
+// the _WIDE packets are this much bigger, transfer ids above 0xff
+static constexpr size_t wide_header_extra {1};
+
+// uncompressed data read per send_data, when compressing
+static constexpr size_t zstd_input_chunk_size {16*1024};
+
+bool NGCFT1::Group::Peer::SendTransfer::allDataSegmented(void) const {
+	return file_size_current == file_size && (!zstd || zstd->done());
+}
+
+void NGCFT1::updateSendTransferPhase1(float time_delta, uint32_t group_number, uint32_t peer_number, Group::Peer& peer, size_t idx) {
 	using State = Group::Peer::SendTransfer::State;
-	auto& tf_opt = peer.send_transfers.at(idx);
-	assert(tf_opt.has_value());
-	auto& tf = tf_opt.value();
+	auto& tf = peer.send_transfers.at(idx);
 
 	tf.time_since_activity += time_delta;
 
@@ -33,14 +47,21 @@ void NGCFT1::updateSendTransferPhase1(float time_delta, uint32_t group_number, u
 					NGCFT1_Event::send_done,
 					Events::NGCFT1_send_done{
 						group_number, peer_number,
-						static_cast<uint8_t>(idx),
+						static_cast<uint16_t>(idx),
 					}
 				);
-				tf_opt.reset();
+				eraseSendTransfer(peer, idx);
 			} else {
 				// timed out, resend
 				std::cerr << "NGCFT1 warning: sending ft init timed out, resending\n";
-				if (_neep.send_ft1_init(group_number, peer_number, tf.file_kind, tf.file_size, idx, tf.file_id.data(), tf.file_id.size())) {
+				// alternate with the legacy init, for peers that dont handle init2
+				// (wide ids are only used with peers that do)
+				const bool legacy = idx <= 0xff && ((tf.inits_sent % 2 == 1) != peer.legacy_init);
+				const bool sent = legacy
+					? _neep.send_ft1_init(group_number, peer_number, tf.file_kind, tf.file_size, idx, tf.file_id.data(), tf.file_id.size())
+					: _neep.send_ft1_init2(group_number, peer_number, tf.file_kind, tf.file_size, idx, tf.feature_flags, tf.file_id.data(), tf.file_id.size())
+				;
+				if (sent) {
 					tf.inits_sent++;
 				}
 				tf.time_since_activity = 0.f;
@@ -60,185 +81,662 @@ void NGCFT1::updateSendTransferPhase1(float time_delta, uint32_t group_number, u
 				NGCFT1_Event::send_done,
 				Events::NGCFT1_send_done{
 					group_number, peer_number,
-					static_cast<uint8_t>(idx),
+					static_cast<uint16_t>(idx),
 				}
 			);
 
 			// clean up cca
-			tf.ssb.for_each(time_delta, [&](uint16_t id, const std::vector<uint8_t>& data, float& time_since_activity) {
+			tf.ssb.for_each([&](uint16_t id, ByteSpan) {
 				peer.cca->onLoss({idx, id}, true);
 			});
 
-			tf_opt.reset();
+			eraseSendTransfer(peer, idx);
 			return;
 		}
 	}
+}
 
-	// do send buffer and resending
-	tf.ssb.for_each(time_delta, [&](uint16_t id, const std::vector<uint8_t>& data, float& time_since_activity) {
-		time_since_activity += time_delta;
+void NGCFT1::resendTimedOut(float time_delta, uint32_t group_number, uint32_t peer_number, Group::Peer& peer, Span<CCAI::SeqIDType> timeouts, int64_t& can_packet_size) {
+	bool resent_any {false};
+	for (const auto& [idx, id] : timeouts) {
+		if (can_packet_size <= 0) {
+			break;
+		}
 
-		if (
-			//time_since_activity >= peer.cca->getCurrentDelay() && // TODO: use OR instead?
-			timeouts_set.count({idx, id})
-		) {
-			timeouts_set.erase({idx, id});
+		const auto tf_it = peer.send_transfers.find(idx);
+		if (tf_it == peer.send_transfers.end()) {
+			continue;
+		}
+		auto& tf = tf_it->second;
 
-			if (can_packet_size < int64_t(data.size() /*+ peer.cca->SEGMENT_OVERHEAD*/)) {
-				return;
+		if (!tf.ssb.has(id)) {
+			continue;
+		}
+		const ByteSpan data = tf.ssb.get(id);
+
+		if (can_packet_size < int64_t(data.size /*+ peer.cca->SEGMENT_OVERHEAD*/)) {
+			continue;
 #if 0
-			} else {
-				std::cerr << "NGCFT1 warning: no space to resend timed-out\n";
+		} else {
+			std::cerr << "NGCFT1 warning: no space to resend timed-out\n";
 #endif
+		}
+
+		if (_neep.send_ft1_data(group_number, peer_number, idx, id, data.ptr, data.size)) {
+			// !!! has to be in cca when in timeouts
+			if (!peer.cca->onLoss({idx, id}, false)) { // might not be in cca
+				peer.cca->onSent({idx, id}, data.size);
 			}
 
-			if (_neep.send_ft1_data(group_number, peer_number, idx, id, data.data(), data.size())) {
-				// !!! has to be in cca when in timeouts_set
-				if (!peer.cca->onLoss({idx, id}, false)) { // might not be in cca
-					peer.cca->onSent({idx, id}, data.size());
-				}
+			can_packet_size -= data.size;
+			tf.packets_resent++;
+			peer.packets_resent++;
+			resent_any = true;
+			//std::cout << "!!!! ngcft1 resent timedout " << idx << ":" << id << "\n";
+		} else {
+			std::cerr << "NGCFT1 warning: failed to re-send packet (send queue full?)\n";
 
-				time_since_activity = 0.f;
-				can_packet_size -= data.size();
-				tf.packets_resent++;
-				peer.packets_resent++;
-				//std::cout << "!!!! ngcft1 resent timedout " << idx << ":" << id << "\n";
-			} else {
-				std::cerr << "NGCFT1 warning: failed to re-send packet (send queue full?)\n";
+			// signal ce (we did not call onLoss()
+			peer.cca->onCongestion();
+			can_packet_size = 0;
+		}
+	}
 
-				// signal ce (we did not call onLoss()
-				peer.cca->onCongestion();
-				can_packet_size = 0;
-			}
+	// counted per round, not per segment or tick
+	// the timeouts of a burst loss trickle in over about an rtt, so at most one round per rtt counts
+	peer.mtu.timeout_round_timer += time_delta;
+	if (resent_any) {
+		const float rtt = peer.cca->getCurrentRTT();
+		if (peer.mtu.timeout_round_timer >= (std::isfinite(rtt) ? rtt : 1.f)) {
+			peer.mtu.timeout_round_timer = 0.f;
+			peer.mtu.timeouts_in_row++;
 		}
-	});
+	}
 }
 
-void NGCFT1::updateSendTransferPhase2(float time_delta, uint32_t group_number, uint32_t peer_number, Group::Peer& peer, size_t idx, int64_t& can_packet_size) {
+void NGCFT1::updateSendTransferPhase2(float time_delta, uint32_t group_number, uint32_t peer_number, Group::Peer& peer, size_t idx, SendScratch& scratch, int64_t& can_packet_size, int64_t& deficit) {
 	using State = Group::Peer::SendTransfer::State;
-	auto& tf_opt = peer.send_transfers.at(idx);
-	assert(tf_opt.has_value());
-	auto& tf = tf_opt.value();
+	auto& tf = peer.send_transfers.at(idx);
 
 	if (tf.state != State::SENDING) {
 		return;
 	}
 
+	// collect the new segments first and then send them as one batch
+	auto& send_batch = scratch.send_batch;
+	send_batch.clear();
+
 	// if chunks in flight < window size (2)
-	while (can_packet_size > 0 && tf.file_size > 0) {
-		if (tf.file_size - tf.file_size_current == 0) {
+	while (can_packet_size > 0 && tf.file_size > 0 && !tf.ssb.full()) {
+		if (tf.zstd) {
+			// keep about a segment worth of compressed data ready
+			while (tf.zstd->available() < peer.cca->MAXIMUM_SEGMENT_DATA_SIZE && tf.file_size_current < tf.file_size) {
+				const size_t input_size = std::min<uint64_t>(zstd_input_chunk_size, tf.file_size - tf.file_size_current);
+				scratch.zstd_input.resize(input_size);
+
+				{ // TODO: check return value
+					std::lock_guard lg{_send_data_mutex};
+					dispatch(
+						NGCFT1_Event::send_data,
+						Events::NGCFT1_send_data{
+							group_number, peer_number,
+							static_cast<uint16_t>(idx),
+							tf.file_size_current,
+							scratch.zstd_input.data(), static_cast<uint32_t>(input_size),
+						}
+					);
+				}
+				tf.file_size_current += input_size;
+
+				if (!tf.zstd->feed(ByteSpan{scratch.zstd_input}, tf.file_size_current == tf.file_size)) {
+					// the receiver fails to decompress and drops the transfer, which then times out here
+					std::cerr << "NGCFT1 error: compressing failed for " << idx << "\n";
+					break;
+				}
+			}
+		}
+
+		if (tf.allDataSegmented()) {
 			tf.state = State::FINISHING;
 			break; // we done
 		}
 
-		std::vector<uint8_t> new_data;
-
 		size_t chunk_size = std::min<size_t>({
-			peer.cca->MAXIMUM_SEGMENT_DATA_SIZE, // hmm
+			peer.cca->MAXIMUM_SEGMENT_DATA_SIZE - (tf.fec ? fec_header_extra : 0) - (idx > 0xff ? wide_header_extra : 0), // parity of full segments has to fit too
 			static_cast<size_t>(can_packet_size),
-			static_cast<size_t>(tf.file_size - tf.file_size_current),
+			tf.zstd ? tf.zstd->available() : static_cast<size_t>(tf.file_size - tf.file_size_current),
 		});
 		if (chunk_size == 0) {
 			break; // we done
 		}
 
-		new_data.resize(chunk_size);
+		if (static_cast<int64_t>(chunk_size) > deficit) {
+			break; // used up our share for this round
+		}
 
-		assert(idx <= 0xffu);
-		// TODO: check return value
-		dispatch(
-			NGCFT1_Event::send_data,
-			Events::NGCFT1_send_data{
-				group_number, peer_number,
-				static_cast<uint8_t>(idx),
-				tf.file_size_current,
-				new_data.data(), static_cast<uint32_t>(new_data.size()),
-			}
-		);
+		// reserve the segment in the send buffer and let the data be written directly into it
+		const uint16_t seq_id = tf.ssb.add(chunk_size);
 
-		uint16_t seq_id = tf.ssb.add(std::move(new_data));
-		const bool sent = _neep.send_ft1_data(group_number, peer_number, idx, seq_id, tf.ssb.entries.at(seq_id).data.data(), tf.ssb.entries.at(seq_id).data.size());
-		if (sent) {
-			peer.cca->onSent({idx, seq_id}, chunk_size);
+		if (tf.zstd) {
+			tf.zstd->read(tf.ssb.data(seq_id), chunk_size);
 		} else {
-			std::cerr << "NGCFT1 warn: failed to send packet (send queue full?)\n";
-			peer.cca->onCongestion();
-			can_packet_size = 0;
-			break;
+			{ // TODO: check return value
+				std::lock_guard lg{_send_data_mutex};
+				dispatch(
+					NGCFT1_Event::send_data,
+					Events::NGCFT1_send_data{
+						group_number, peer_number,
+						static_cast<uint16_t>(idx),
+						tf.file_size_current,
+						tf.ssb.data(seq_id), static_cast<uint32_t>(chunk_size),
+					}
+				);
+			}
+			tf.file_size_current += chunk_size;
 		}
 
-		tf.file_size_current += chunk_size;
+		// data spans filled in after, add() can move the slab
+		send_batch.push_back({seq_id, {}});
+
 		can_packet_size -= chunk_size;
+		deficit -= chunk_size;
 	}
-}
 
-bool NGCFT1::iteratePeer(float time_delta, uint32_t group_number, uint32_t peer_number, Group::Peer& peer) {
-	bool recv_activity {false};
-	for (size_t idx = 0; idx < peer.recv_transfers.size(); idx++) {
-		if (!peer.recv_transfers.at(idx).has_value()) {
-			continue;
+	if (send_batch.empty()) {
+		return;
+	}
+
+	for (auto& seg : send_batch) {
+		seg.data = tf.ssb.get(seg.sequence_id);
+	}
+
+	const size_t sent_count = _neep.send_ft1_data_batch(
+		group_number, peer_number,
+		idx,
+		Span<NGCEXTEventProvider::FT1DataSegment>{send_batch.data(), send_batch.size()}
+	);
+
+	for (size_t i = 0; i < sent_count; i++) {
+		peer.cca->onSent({idx, send_batch[i].sequence_id}, send_batch[i].data.size);
+	}
+
+	if (sent_count < send_batch.size()) {
+		std::cerr << "NGCFT1 warn: failed to send packet (send queue full?) " << sent_count << "/" << send_batch.size() << " sent\n";
+		peer.cca->onCongestion();
+		can_packet_size = 0;
+
+		if (tf.zstd) {
+			// compressed data can not be put back, so they count as lost and get resent once they time out
+			for (size_t i = sent_count; i < send_batch.size(); i++) {
+				peer.cca->onSent({idx, send_batch[i].sequence_id}, send_batch[i].data.size);
+			}
+		} else {
+			// roll back the segments that did not make it, they will be read again next time
+			for (size_t i = sent_count; i < send_batch.size(); i++) {
+				tf.file_size_current -= send_batch[i].data.size;
+				deficit += send_batch[i].data.size;
+			}
+			tf.ssb.eraseLast(send_batch.size() - sent_count);
+
+			if (tf.state == State::FINISHING) {
+				tf.state = State::SENDING;
+			}
 		}
+	}
+
+	if (tf.fec) {
+		// blocks have to be consecutive, so with zstd the unsent are part of it
+		const size_t segment_count = tf.zstd ? send_batch.size() : sent_count;
+		const size_t fec_block_size = getFECBlockSize(peer);
+		for (size_t i = 0; i < segment_count && fec_block_size > 0; i++) {
+			const auto& seg = send_batch[i];
+			if (tf.fec_count == 0) {
+				tf.fec_first_seq_id = seg.sequence_id;
+				tf.fec_size_xor = 0;
+				tf.fec_parity.clear();
+			}
+
+			if (tf.fec_parity.size() < seg.data.size) {
+				tf.fec_parity.resize(seg.data.size, 0u);
+			}
+			for (size_t j = 0; j < seg.data.size; j++) {
+				tf.fec_parity[j] ^= seg.data.ptr[j];
+			}
+			tf.fec_size_xor ^= seg.data.size;
+			tf.fec_count++;
+
+			if (tf.fec_count >= fec_block_size) {
+				flushFECBlock(group_number, peer_number, peer, idx, tf, can_packet_size);
+			}
+		}
+
+		// dont hold back the tail, small transfers gain the most
+		if (fec_block_size == 0 || tf.allDataSegmented()) {
+			flushFECBlock(group_number, peer_number, peer, idx, tf, can_packet_size);
+		}
+	}
+}
+
+size_t NGCFT1::getFECBlockSize(const Group::Peer& peer) const {
+	const float loss = peer.cca->getLossRate();
+	if (loss < fec_min_loss) {
+		return 0;
+	}
+
+	// a block can rebuild one segment, so aim for about half a lost segment per block
+	return std::clamp<size_t>(static_cast<size_t>(0.5f / loss), fec_block_min, fec_block_max);
+}
+
+void NGCFT1::flushFECBlock(uint32_t group_number, uint32_t peer_number, Group::Peer& peer, size_t idx, Group::Peer::SendTransfer& tf, int64_t& can_packet_size) {
+	if (tf.fec_count == 0) {
+		return;
+	}
+
+	// not in flight for the cca, a lost parity is not resent, but it still counts against the send rate
+	if (_neep.send_ft1_data_fec(
+		group_number, peer_number,
+		idx,
+		tf.fec_first_seq_id,
+		tf.fec_count,
+		tf.fec_size_xor,
+		tf.fec_parity.data(), tf.fec_parity.size()
+	)) {
+		can_packet_size -= tf.fec_parity.size();
+		peer.cca->onSentUntracked(tf.fec_parity.size());
+	}
+
+	tf.fec_count = 0;
+}
 
-		auto& transfer = peer.recv_transfers.at(idx).value();
+float NGCFT1::iteratePeer(float time_delta, uint32_t group_number, uint32_t peer_number, Group::Peer& peer, int64_t& send_budget) {
+	float next_deadline = updatePeerTimers(time_delta, group_number, peer_number, peer);
+
+	const int64_t send_budget_before = send_budget;
+	next_deadline = std::min(next_deadline, iteratePeerSend(time_delta, group_number, peer_number, peer, _send_scratch, send_budget));
+	_uplink.consume(send_budget_before - send_budget);
+
+	return next_deadline;
+}
+
+float NGCFT1::updatePeerTimers(float time_delta, uint32_t group_number, uint32_t peer_number, Group::Peer& peer) {
+	float next_deadline = std::numeric_limits<float>::infinity();
+	for (auto it = peer.recv_transfers.begin(); it != peer.recv_transfers.end();) {
+		const uint16_t idx = it->first;
+		auto& transfer = it->second;
+
+		if (transfer.acks_pending > 0) {
+			transfer.ack_timer += time_delta;
+			if (transfer.ack_timer >= sack_max_delay) {
+				sendSACK(group_number, peer_number, idx, transfer);
+			} else {
+				next_deadline = std::min(next_deadline, sack_max_delay - transfer.ack_timer);
+			}
+		}
 
 		// proper switch case?
 		if (transfer.state == Group::Peer::RecvTransfer::State::FINISHING) {
 			transfer.timer -= time_delta;
 			if (transfer.timer <= 0.f) {
-				peer.recv_transfers.at(idx).reset();
+				it = peer.recv_transfers.erase(it);
+				continue;
+			} else {
+				next_deadline = std::min(next_deadline, transfer.timer);
 			}
-			recv_activity = true; // count as activity, not sure we need this
 		} else {
+			// data arrives as events, nothing to wait for
 			transfer.timer += time_delta;
-			if (transfer.timer < 2.f) {
-				// back off when no activity
-				recv_activity = true;
-			}
 		}
+
+		it++;
 	}
 
 	if (peer.cca) {
-		auto timeouts = peer.cca->getTimeouts();
-		std::set<CCAI::SeqIDType> timeouts_set{timeouts.cbegin(), timeouts.cend()};
+		// resend inits and get number current running transfers
+		peer.active_send_transfers = peer.active_send_list.size();
+		// phase1 can remove transfers (and send_done handlers add new ones)
+		_active_send_scratch = peer.active_send_list;
+		for (const uint16_t idx : _active_send_scratch) {
+			if (!peer.send_transfers.count(idx)) {
+				continue;
+			}
+			updateSendTransferPhase1(time_delta, group_number, peer_number, peer, idx);
+		}
+	}
 
-		int64_t can_packet_size {peer.cca->canSend(time_delta)}; // might get more space while iterating (time)
-		peer.last_can_send = can_packet_size;
+	return next_deadline;
+}
 
-		// resend and get number current running transfers
-		peer.active_send_transfers = 0;
-		for (size_t idx = 0; idx < peer.send_transfers.size(); idx++) {
-			if (!peer.send_transfers.at(idx).has_value()) {
-				continue;
+float NGCFT1::iteratePeerSend(float time_delta, uint32_t group_number, uint32_t peer_number, Group::Peer& peer, SendScratch& scratch, int64_t& send_budget) {
+	if (!peer.cca) {
+		return std::numeric_limits<float>::infinity();
+	}
+
+	if (peer.send_queue_rejected) {
+		peer.send_queue_rejected = false;
+		peer.cca->onCongestion();
+	}
+
+	float next_deadline = std::numeric_limits<float>::infinity();
+
+	int64_t can_packet_size {std::min<int64_t>(peer.cca->canSend(time_delta), send_budget)}; // might get more space while iterating (time)
+	peer.last_can_send = can_packet_size;
+	const int64_t can_packet_size_before = can_packet_size;
+
+	resendTimedOut(time_delta, group_number, peer_number, peer, peer.cca->getTimeouts(), can_packet_size);
+
+	next_deadline = std::min(next_deadline, updateSegmentSizeProbe(time_delta, group_number, peer_number, peer, can_packet_size));
+
+	if (can_packet_size > 0) {
+		scheduleSendTransfers(time_delta, group_number, peer_number, peer, scratch, can_packet_size);
+	}
+
+	// congestion zeros can_packet_size, so this might overcount a bit
+	const int64_t sent = std::max<int64_t>(can_packet_size_before - std::max<int64_t>(can_packet_size, 0), 0);
+	send_budget -= sent;
+
+	using State = Group::Peer::SendTransfer::State;
+	for (const uint16_t idx : peer.active_send_list) {
+		const auto& tf = peer.send_transfers.at(idx);
+		if (tf.state == State::INIT_SENT) {
+			next_deadline = std::min(next_deadline, init_retry_timeout_after * std::min(peer.cca->getCurrentRTT(), 2.f) - tf.time_since_activity);
+		} else {
+			next_deadline = std::min(next_deadline, sending_give_up_after * peer.active_send_list.size() - tf.time_since_activity);
+			if (tf.state == State::SENDING && !tf.allDataSegmented()) {
+				// more to send, at the next pacing release time
+				// or poll for the window to open up (acks are not a wakeup)
+				const float next_send = peer.cca->getTimeUntilNextSend();
+				next_deadline = std::min(next_deadline, std::isinf(next_send) ? send_tick_interval : next_send);
 			}
-			peer.active_send_transfers++;
-			updateSendTransferPhase1(time_delta, group_number, peer_number, peer, idx, timeouts_set, can_packet_size);
 		}
+	}
 
-		if (can_packet_size > 0) {
-			// change iterate start position to not starve transfers in the back
-			size_t iterated_count = 0;
-			bool last_send_found = false;
-			for (size_t idx = peer.next_send_transfer_send_idx; iterated_count < peer.send_transfers.size(); idx++, iterated_count++) {
-				idx = idx % peer.send_transfers.size();
+	// resends, if they did not fit they are overdue and we retry at the send rate
+	next_deadline = std::min(next_deadline, std::max(peer.cca->getTimeUntilNextTimeout(), send_tick_interval));
 
-				// perfect round robin causes ft handshakes to align somewhat
-				// add some skips to unalign
-				if ((idx % 2) == 0 && (_rng() % 15) == 0) {
-					continue;
-				}
+	return next_deadline;
+}
 
-				if (peer.send_transfers.at(idx).has_value()) {
-					if (!last_send_found && can_packet_size <= 0) {
-						peer.next_send_transfer_send_idx = idx;
-						last_send_found = true; // only set once
-					}
-					updateSendTransferPhase2(time_delta, group_number, peer_number, peer, idx, can_packet_size);
-				}
+void NGCFT1::flushSendQueue(void) {
+	size_t rejected {0};
+	for (auto& queue : _send_queues) {
+		for (size_t i = 0; i < queue.size(); i++) {
+			const auto& pkg = queue[i];
+			if (_t.toxGroupSendCustomPrivatePacket(pkg.group_number, pkg.peer_number, pkg.lossless, pkg.data) == TOX_ERR_GROUP_SEND_CUSTOM_PRIVATE_PACKET_OK) {
+				continue;
+			}
+			rejected++;
+
+			auto group_it = groups.find(pkg.group_number);
+			if (group_it == groups.end()) {
+				continue;
+			}
+			auto peer_it = group_it->second.peers.find(pkg.peer_number);
+			if (peer_it == group_it->second.peers.end()) {
+				continue;
 			}
+			peer_it->second.send_queue_rejected = true;
+		}
+		queue.clear();
+	}
+
+	if (rejected > 0) {
+		std::cerr << "NGCFT1 warn: failed to send " << rejected << " queued packets (send queue full?)\n";
+	}
+}
+
+void NGCFT1::scheduleSendTransfers(float time_delta, uint32_t group_number, uint32_t peer_number, Group::Peer& peer, SendScratch& scratch, int64_t& can_packet_size) {
+	using State = Group::Peer::SendTransfer::State;
+	auto& list = peer.active_send_list;
+
+	// stop after a full round without progress
+	size_t idle_visits = 0;
+	while (can_packet_size > 0 && !list.empty() && idle_visits < list.size()) {
+		peer.send_sched_cursor %= list.size();
+		const uint16_t idx = list[peer.send_sched_cursor];
+		auto& tf = peer.send_transfers.at(idx);
+
+		if (!peer.send_sched_resume) {
+			tf.deficit += int64_t(peer.cca->MAXIMUM_SEGMENT_DATA_SIZE) * static_cast<int64_t>(tf.priority);
+		}
+		peer.send_sched_resume = false;
+
+		const uint16_t next_seq_id_before = tf.ssb.next_seq_id;
+		updateSendTransferPhase2(time_delta, group_number, peer_number, peer, idx, scratch, can_packet_size, tf.deficit);
+		const bool sent = tf.ssb.next_seq_id != next_seq_id_before;
+
+		if (tf.state != State::SENDING || !sent) {
+			// nothing (more) to send, like an empty queue in drr
+			tf.deficit = 0;
+		} else if (can_packet_size <= 0 && tf.deficit >= int64_t(peer.cca->MAXIMUM_SEGMENT_DATA_SIZE)) {
+			// ran out of window mid quantum, continue with this transfer next time
+			peer.send_sched_resume = true;
+			break;
+		}
+
+		idle_visits = sent ? 0 : idle_visits + 1;
+		peer.send_sched_cursor++;
+	}
+}
+
+void NGCFT1::eraseSendTransfer(Group::Peer& peer, size_t idx) {
+	peer.send_transfers.erase(idx);
+
+	auto& list = peer.active_send_list;
+	auto it = std::find(list.begin(), list.end(), static_cast<uint16_t>(idx));
+	if (it == list.end()) {
+		return;
+	}
+
+	// keep the cursor pointing at the same transfer
+	const size_t pos = it - list.begin();
+	if (pos < peer.send_sched_cursor) {
+		peer.send_sched_cursor--;
+	} else if (pos == peer.send_sched_cursor) {
+		peer.send_sched_resume = false;
+	}
+	list.erase(it);
+}
+
+void NGCFT1::switchPeerCCA(uint32_t group_number, uint32_t peer_number, Group::Peer& peer, CCAType type, const char* reason) {
+	assert(type != CCAType::AUTO);
+	assert(peer.cca);
+
+	const float rtt = peer.cca->getCurrentRTT();
+	const float queue_delay = std::isfinite(rtt) && std::isfinite(peer.cca_auto_min_rtt) ? rtt - peer.cca_auto_min_rtt : 0.f;
+	std::cout << "NGCFT1: switching cca of " << group_number << ":" << peer_number << " from " << to_string(peer.cca_active) << " to " << to_string(type) << " (" << reason << ") rtt:" << rtt << "\n";
+
+	peer.cca_switch_events.push_back({peer.cca_active, type, reason, rtt, queue_delay});
+	while (peer.cca_switch_events.size() > 8) {
+		peer.cca_switch_events.pop_front();
+	}
+	peer.cca_switch_count++;
+	peer.cca_auto_timer = 0.f;
+	peer.cca_active = type;
+
+	auto new_cca = createCCA(type, peer.max_packet_data_size);
+	new_cca->max_byterate_allowed = peer.cca->max_byterate_allowed;
+
+	// the old cca forgets about what is in flight, so the new one needs to know
+	// to time them out (timestamps restart, so the first rtt samples are a bit low)
+	for (const uint16_t idx : peer.active_send_list) {
+		peer.send_transfers.at(idx).ssb.for_each([&](uint16_t id, ByteSpan data) {
+			new_cca->onSent({idx, id}, data.size);
+		});
+	}
+
+	peer.cca = std::move(new_cca);
+}
+
+float NGCFT1::updateSegmentSizeProbe(float time_delta, uint32_t group_number, uint32_t peer_number, Group::Peer& peer, int64_t& can_packet_size) {
+	auto& mtu = peer.mtu;
+
+	// nothing gets through anymore, likely our segments got too big for the path
+	// (only new segments get smaller, what is in flight keeps its size)
+	if (mtu.timeouts_in_row >= mtu_black_hole_timeouts) {
+		mtu.timeouts_in_row = 0;
+		const uint32_t base_size = std::min(mtu_base_size, mtu.negotiated_max);
+		if (mtu.confirmed > base_size) {
+			std::cerr << "NGCFT1 warning: segment size black hole suspected for " << group_number << ":" << peer_number << ", dropping from " << mtu.confirmed << " to " << base_size << "\n";
+			mtu.search_high = mtu.confirmed - 1;
+			mtu.probe_size = 0;
+			mtu.probe_fails = 0;
+			mtu.timer = 0.f;
+			mtu.black_holes++;
+			setPeerSegmentSize(peer, base_size);
+		}
+	}
+
+	if (!mtu_probing) {
+		return std::numeric_limits<float>::infinity();
+	}
+
+	mtu.timer += time_delta;
+
+	if (mtu.probe_size != 0) {
+		const float probe_timeout = std::max(3.f * std::min(peer.cca->getCurrentRTT(), FlowOnly::RTT_MAX), 0.2f);
+		if (mtu.timer < probe_timeout) {
+			return probe_timeout - mtu.timer;
+		}
+
+		// lost, but single probes can be lost for other reasons
+		mtu.probe_fails++;
+		if (mtu.probe_fails >= mtu_probe_max_fails) {
+			mtu.search_high = mtu.probe_size - 1;
+			mtu.probe_fails = 0;
+		}
+		mtu.probe_size = 0;
+		mtu.timer = 0.f;
+	}
+
+	// only probe while sending, we need a rtt and an idle peer should stay idle
+	if (peer.active_send_list.empty()) {
+		return std::numeric_limits<float>::infinity();
+	}
+
+	if (mtu.search_high < mtu.confirmed + mtu_probe_min_step) {
+		if (mtu.timer < mtu_research_after || mtu.negotiated_max < mtu.confirmed + mtu_probe_min_step) {
+			return std::numeric_limits<float>::infinity();
+		}
+		mtu.search_high = mtu.negotiated_max;
+		mtu.timer = 0.f;
+	}
+
+	if (mtu.timer < mtu_probe_interval) {
+		return mtu_probe_interval - mtu.timer;
+	}
+
+	// binary search
+	const uint32_t probe_size = mtu.confirmed + (mtu.search_high - mtu.confirmed + 1) / 2;
+	if (can_packet_size < int64_t(probe_size)) {
+		return std::numeric_limits<float>::infinity(); // next time
+	}
+
+	if (!_neep.send_ft1_mtu_probe(group_number, peer_number, mtu.probe_id+1, static_cast<uint16_t>(probe_size))) {
+		return std::numeric_limits<float>::infinity(); // next time
+	}
+	can_packet_size -= probe_size;
+
+	mtu.probe_id++;
+	mtu.probe_size = probe_size;
+	mtu.timer = 0.f;
+
+	return std::max(3.f * std::min(peer.cca->getCurrentRTT(), FlowOnly::RTT_MAX), 0.2f);
+}
+
+void NGCFT1::setPeerSegmentSize(Group::Peer& peer, uint32_t size) {
+	peer.mtu.confirmed = size;
+	peer.max_packet_data_size = size;
+	if (peer.cca) {
+		peer.cca->setMaximumSegmentDataSize(size);
+	}
+}
+
+CCAType NGCFT1::resolveCCAType(const Group& group, const Group::Peer& peer) const {
+	return peer.cca_type.value_or(group.cca_type.value_or(_cca_default));
+}
+
+void NGCFT1::applyCCAConfig(uint32_t group_number, uint32_t peer_number, Group& group, Group::Peer& peer) {
+	if (!peer.cca) {
+		return; // created with the right type on init_ack
+	}
+
+	CCAType target = resolveCCAType(group, peer);
+	if (target == CCAType::AUTO) {
+		if (peer.cca_active == CCAType::LEDBAT || peer.cca_active == CCAType::CUBIC) {
+			return; // already one auto would pick
 		}
+		target = CCAType::LEDBAT;
 	}
 
-	return peer.active_send_transfers > 0 || recv_activity;
+	if (target != peer.cca_active) {
+		switchPeerCCA(group_number, peer_number, peer, target, "config");
+	}
+}
+
+void NGCFT1::updateAutoCCA(float time_delta, uint32_t group_number, uint32_t peer_number, Group::Peer& peer) {
+	const float rtt = peer.cca->getCurrentRTT();
+	if (!std::isfinite(rtt)) {
+		// no sample yet, nothing to judge
+		peer.cca_auto_timer = 0.f;
+		return;
+	}
+
+	peer.cca_auto_section_min_rtt = std::min(peer.cca_auto_section_min_rtt, rtt);
+	peer.cca_auto_section_timer += time_delta;
+	if (peer.cca_auto_section_timer >= cca_auto_min_rtt_section) {
+		peer.cca_auto_min_rtt_history.push_back(peer.cca_auto_section_min_rtt);
+		while (peer.cca_auto_min_rtt_history.size() > cca_auto_min_rtt_sections) {
+			peer.cca_auto_min_rtt_history.pop_front();
+		}
+		peer.cca_auto_section_min_rtt = rtt;
+		peer.cca_auto_section_timer = 0.f;
+	}
+
+	peer.cca_auto_min_rtt = peer.cca_auto_section_min_rtt;
+	for (const float it : peer.cca_auto_min_rtt_history) {
+		peer.cca_auto_min_rtt = std::min(peer.cca_auto_min_rtt, it);
+	}
+	const float queue_delay = rtt - peer.cca_auto_min_rtt;
+
+	// only judge while actually sending
+	if (peer.cca->inFlightBytes() <= 0) {
+		peer.cca_auto_timer = 0.f;
+		return;
+	}
+
+	CCAType target;
+	const char* reason;
+	if (peer.cca_active == CCAType::CUBIC) {
+		if (queue_delay <= cca_auto_high_queue_delay) {
+			peer.cca_auto_timer = 0.f;
+			return;
+		}
+		target = CCAType::LEDBAT;
+		reason = "auto, queueing delay high";
+	} else {
+		if (queue_delay >= cca_auto_low_queue_delay) {
+			peer.cca_auto_timer = 0.f;
+			return;
+		}
+		target = CCAType::CUBIC;
+		reason = "auto, queueing delay low";
+	}
+
+	peer.cca_auto_timer += time_delta;
+	if (peer.cca_auto_timer >= cca_auto_switch_after) {
+		switchPeerCCA(group_number, peer_number, peer, target, reason);
+	}
+}
+
+void NGCFT1::sendSACK(uint32_t group_number, uint32_t peer_number, uint16_t transfer_id, Group::Peer::RecvTransfer& transfer) {
+	std::array<uint8_t, 32> sack_bitset; // 256 seq_ids
+	const size_t sack_bitset_size = transfer.rsb.sackBitset(sack_bitset.data(), sack_bitset.size());
+
+	// TODO: check return value
+	_neep.send_ft1_data_sack(group_number, peer_number, transfer_id, transfer.rsb.next_seq_id, sack_bitset.data(), sack_bitset_size);
+
+	transfer.acks_pending = 0;
+	transfer.ack_timer = 0.f;
 }
 
 const CCAI* NGCFT1::getPeerCCA(
@@ -276,32 +774,98 @@ NGCFT1::NGCFT1(
 		.subscribe(NGCEXT_Event::FT1_INIT_ACK)
 		.subscribe(NGCEXT_Event::FT1_DATA)
 		.subscribe(NGCEXT_Event::FT1_DATA_ACK)
+		.subscribe(NGCEXT_Event::FT1_DATA_SACK)
+		.subscribe(NGCEXT_Event::FT1_DATA_FEC)
+		.subscribe(NGCEXT_Event::FT1_MTU_PROBE)
+		.subscribe(NGCEXT_Event::FT1_MTU_PROBE_ACK)
 		.subscribe(NGCEXT_Event::FT1_MESSAGE)
+		.subscribe(NGCEXT_Event::FT1_INIT2)
 	;
 
 	_tep_sr.subscribe(Tox_Event_Type::TOX_EVENT_GROUP_PEER_EXIT);
 }
 
 float NGCFT1::iterate(float time_delta) {
-	_time_since_activity += time_delta;
-	bool transfer_activity {false};
+
+	_uplink.update(time_delta);
+	_downlink.update(time_delta);
+
+	// split the uplink between the peers that want to send
+	size_t sending_peers {0};
+	if (!_uplink.unlimited()) {
+		for (const auto& [group_number, group] : groups) {
+			for (const auto& [peer_number, peer] : group.peers) {
+				if (peer.cca && !peer.active_send_list.empty()) {
+					sending_peers++;
+				}
+			}
+		}
+	}
+	int64_t uplink_left = _uplink.available();
+
+	float next_deadline = max_tick_interval;
+
+	if (_send_pool) {
+		// timers and events on this thread, then the peers are sent in parallel
+		// the budgets are fixed up front, so unused shares are not passed on
+		const int64_t send_share = _uplink.unlimited() ? uplink_left : uplink_left / int64_t(std::max<size_t>(sending_peers, 1));
+
+		_send_work.clear();
+		for (auto& [group_number, group] : groups) {
+			for (auto& [peer_number, peer] : group.peers) {
+				if (peer.cca && resolveCCAType(group, peer) == CCAType::AUTO) {
+					updateAutoCCA(time_delta, group_number, peer_number, peer);
+				}
+
+				next_deadline = std::min(next_deadline, updatePeerTimers(time_delta, group_number, peer_number, peer));
+
+				if (peer.cca) {
+					_send_work.push_back({group_number, peer_number, &peer, send_share, std::numeric_limits<float>::infinity()});
+				}
+			}
+		}
+
+		_send_pool->parallelFor(_send_work.size(), [this, time_delta](size_t worker, size_t i) {
+			auto& work = _send_work[i];
+			NGCEXTEventProvider::setThreadSendQueue(&_send_queues.at(worker));
+			work.next_deadline = iteratePeerSend(time_delta, work.group_number, work.peer_number, *work.peer, _send_pool_scratch.at(worker), work.send_budget);
+			NGCEXTEventProvider::setThreadSendQueue(nullptr);
+		});
+
+		for (const auto& work : _send_work) {
+			_uplink.consume(send_share - work.send_budget);
+			next_deadline = std::min(next_deadline, work.next_deadline);
+		}
+
+		flushSendQueue();
+
+		return std::max(next_deadline, 0.001f);
+	}
+
 	for (auto& [group_number, group] : groups) {
 		for (auto& [peer_number, peer] : group.peers) {
-			transfer_activity = iteratePeer(time_delta, group_number, peer_number, peer) || transfer_activity;
+			int64_t send_budget = uplink_left;
+			const bool sending = peer.cca && !peer.active_send_list.empty();
+			if (!_uplink.unlimited() && sending) {
+				// even share of what is left, so unused budget goes to the next peers
+				send_budget = uplink_left / int64_t(std::max<size_t>(sending_peers, 1));
+				sending_peers--;
+			}
+
+			if (peer.cca && resolveCCAType(group, peer) == CCAType::AUTO) {
+				updateAutoCCA(time_delta, group_number, peer_number, peer);
+			}
+
+			const int64_t send_budget_before = send_budget;
+			next_deadline = std::min(next_deadline, iteratePeer(time_delta, group_number, peer_number, peer, send_budget));
+			if (!_uplink.unlimited()) {
+				uplink_left -= send_budget_before - send_budget;
+			}
 		}
 	}
 
-	if (transfer_activity) {
-		_time_since_activity = 0.f;
-		// ~15ms for up to 1mb/s
-		// ~5ms for up to 4mb/s
-		return 0.005f; // 5ms
-	} else if (_time_since_activity < 1.0f) {
-		// bc of temporality
-		return 0.02f;
-	} else {
-		return 1.f; // once a sec might be too little
-	}
+	// timers that are already due get handled next tick
+	return std::max(next_deadline, 0.001f);
 }
 
 bool NGCFT1::NGC_FT1_send_request_private(
@@ -317,8 +881,9 @@ bool NGCFT1::NGC_FT1_send_init_private(
 	uint32_t file_kind,
 	const uint8_t* file_id, uint32_t file_id_size,
 	uint64_t file_size,
-	uint8_t* transfer_id,
-	bool can_compress
+	uint16_t* transfer_id,
+	bool can_compress,
+	NGCFT1_Priority priority
 ) {
 	if (std::get<0>(_t.toxGroupPeerGetConnectionStatus(group_number, peer_number)).value_or(TOX_CONNECTION_NONE) == TOX_CONNECTION_NONE) {
 		std::cerr << "NGCFT1 error: cant init ft, peer offline\n";
@@ -328,34 +893,34 @@ bool NGCFT1::NGC_FT1_send_init_private(
 	auto& peer = groups[group_number].peers[peer_number];
 
 	// allocate transfer_id
-	size_t idx = peer.next_send_transfer_idx;
-	peer.next_send_transfer_idx = (peer.next_send_transfer_idx + 1) % 256;
-	{ // TODO: extract
-		size_t i = idx;
-		bool found = false;
-		do {
-			if (!peer.send_transfers[i].has_value()) {
-				// free slot
-				idx = i;
-				found = true;
-				break;
-			}
-
-			i = (i + 1) % 256;
-		} while (i != idx);
-
-		if (!found) {
-			std::cerr << "NGCFT1 error: cant init ft, no free transfer slot\n";
-			return false;
-		}
+	// ids go round, so late packets of an old transfer are unlikely to hit a new one
+	// peers that dont understand wide ids only get ids up to 0xff
+	const size_t id_space = peer.wide_transfer_ids ? 0x10000 : 0x100;
+	if (peer.send_transfers.size() >= id_space) {
+		std::cerr << "NGCFT1 error: cant init ft, no free transfer id\n";
+		return false;
+	}
+	uint16_t idx = peer.next_send_transfer_idx % id_space;
+	while (peer.send_transfers.count(idx)) {
+		idx = (idx + 1) % id_space;
+	}
+	peer.next_send_transfer_idx = (idx + 1) % id_space;
 
-		idx = i;
+	uint8_t feature_flags = ft1_supported_features;
+	if (!can_compress) {
+		feature_flags &= ~FT1_FEATURE_ZSTD;
+	} else if (_zstd_dicts.count(file_kind)) {
+		feature_flags |= FT1_FEATURE_ZSTD_DICT;
 	}
 
 	// TODO: check return value
-	_neep.send_ft1_init(group_number, peer_number, file_kind, file_size, idx, file_id, file_id_size);
+	if (peer.legacy_init && idx <= 0xff) {
+		_neep.send_ft1_init(group_number, peer_number, file_kind, file_size, idx, file_id, file_id_size);
+	} else {
+		_neep.send_ft1_init2(group_number, peer_number, file_kind, file_size, idx, feature_flags, file_id, file_id_size);
+	}
 
-	peer.send_transfers[idx] = Group::Peer::SendTransfer{
+	auto& transfer = peer.send_transfers[idx] = Group::Peer::SendTransfer{
 		file_kind,
 		std::vector(file_id, file_id+file_id_size),
 		Group::Peer::SendTransfer::State::INIT_SENT,
@@ -365,6 +930,10 @@ bool NGCFT1::NGC_FT1_send_init_private(
 		0,
 		{}, // ssb
 	};
+	transfer.priority = priority;
+	transfer.feature_flags = feature_flags;
+	// new transfers go last in the current round
+	peer.active_send_list.push_back(idx);
 
 	if (transfer_id != nullptr) {
 		*transfer_id = idx;
@@ -386,6 +955,72 @@ bool NGCFT1::NGC_FT1_send_message_public(
 	return _neep.send_all_ft1_message(group_number, message_id, file_kind, file_id, file_id_size);
 }
 
+void NGCFT1::setSendThreads(size_t threads) {
+	_send_pool_scratch.clear();
+	_send_queues.clear();
+	if (threads <= 1) {
+		_send_pool.reset();
+		return;
+	}
+
+	_send_pool = std::make_unique<WorkerPool>(threads);
+	_send_pool_scratch.resize(_send_pool->size());
+	_send_queues.reserve(_send_pool->size());
+	for (size_t i = 0; i < _send_pool->size(); i++) {
+		_send_queues.emplace_back();
+	}
+}
+
+void NGCFT1::setZstdDictionary(uint32_t file_kind, std::vector<uint8_t> dict) {
+	if (dict.empty()) {
+		_zstd_dicts.erase(file_kind);
+	} else {
+		_zstd_dicts[file_kind] = std::move(dict);
+	}
+}
+
+void NGCFT1::setUplinkLimit(float bytes_per_sec) {
+	_uplink.setRate(bytes_per_sec);
+}
+
+void NGCFT1::setDownlinkLimit(float bytes_per_sec) {
+	_downlink.setRate(bytes_per_sec);
+}
+
+NGCFT1::BandwidthStats NGCFT1::getBandwidthStats(void) const {
+	return {
+		_uplink.rate,
+		_downlink.rate,
+		_uplink.bytes_total,
+		_downlink.bytes_total,
+		_downlink.bytes_denied,
+	};
+}
+
+void NGCFT1::setDefaultCCA(CCAType type) {
+	_cca_default = type;
+	for (auto& [group_number, group] : groups) {
+		for (auto& [peer_number, peer] : group.peers) {
+			applyCCAConfig(group_number, peer_number, group, peer);
+		}
+	}
+}
+
+void NGCFT1::setGroupCCA(uint32_t group_number, std::optional<CCAType> type) {
+	auto& group = groups[group_number];
+	group.cca_type = type;
+	for (auto& [peer_number, peer] : group.peers) {
+		applyCCAConfig(group_number, peer_number, group, peer);
+	}
+}
+
+void NGCFT1::setPeerCCA(uint32_t group_number, uint32_t peer_number, std::optional<CCAType> type) {
+	auto& group = groups[group_number];
+	auto& peer = group.peers[peer_number];
+	peer.cca_type = type;
+	applyCCAConfig(group_number, peer_number, group, peer);
+}
+
 float NGCFT1::getPeerRTT(uint32_t group_number, uint32_t peer_number) const {
 	auto* cca_ptr = getPeerCCA(group_number, peer_number);
 
@@ -434,7 +1069,7 @@ int64_t NGCFT1::getPeerInFlightBytes(
 
 bool NGCFT1::onEvent(const Events::NGCEXT_ft1_request& e) {
 //#if !NDEBUG
-	std::cout << "NGCFT1: got FT1_REQUEST fk:" << e.file_kind << " [" << bin2hex(e.file_id) << "]\n";
+	std::cout << "NGCFT1: got FT1_REQUEST fk:" << e.file_kind << " [" << bin2hex(std::vector<uint8_t>(e.file_id.ptr, e.file_id.ptr+e.file_id.size)) << "]\n";
 //#endif
 
 	// .... just rethrow??
@@ -444,14 +1079,14 @@ bool NGCFT1::onEvent(const Events::NGCEXT_ft1_request& e) {
 		Events::NGCFT1_recv_request{
 			e.group_number, e.peer_number,
 			e.file_kind,
-			e.file_id.data(), static_cast<uint32_t>(e.file_id.size())
+			e.file_id.ptr, static_cast<uint32_t>(e.file_id.size)
 		}
 	);
 }
 
 bool NGCFT1::onEvent(const Events::NGCEXT_ft1_init& e) {
 //#if !NDEBUG
-	std::cout << "NGCFT1: got FT1_INIT fk:" << e.file_kind << " fs:" << e.file_size << " tid:" << int(e.transfer_id) << " [" << bin2hex(e.file_id) << "]\n";
+	std::cout << "NGCFT1: got FT1_INIT fk:" << e.file_kind << " fs:" << e.file_size << " tid:" << int(e.transfer_id) << " [" << bin2hex(std::vector<uint8_t>(e.file_id.ptr, e.file_id.ptr+e.file_id.size)) << "]\n";
 //#endif
 	// HACK: simply forward to init2 hanlder
 	return onEvent(Events::NGCEXT_ft1_init2{
@@ -461,7 +1096,7 @@ bool NGCFT1::onEvent(const Events::NGCEXT_ft1_init& e) {
 		e.file_size,
 		e.transfer_id,
 		0x00, // non set
-		e.file_id, // sadly a copy, wont matter in the future
+		e.file_id,
 	});
 }
 
@@ -478,12 +1113,13 @@ bool NGCFT1::onEvent(const Events::NGCEXT_ft1_init_ack& e) {
 	}
 
 	Group::Peer& peer = groups[e.group_number].peers[e.peer_number];
-	if (!peer.send_transfers[e.transfer_id].has_value()) {
+	const auto transfer_it = peer.send_transfers.find(e.transfer_id);
+	if (transfer_it == peer.send_transfers.end()) {
 		std::cerr << "NGCFT1 warning: init_ack for unknown transfer\n";
 		return true;
 	}
 
-	Group::Peer::SendTransfer& transfer = peer.send_transfers[e.transfer_id].value();
+	Group::Peer::SendTransfer& transfer = transfer_it->second;
 
 	using State = Group::Peer::SendTransfer::State;
 	if (transfer.state != State::INIT_SENT) {
@@ -505,17 +1141,39 @@ bool NGCFT1::onEvent(const Events::NGCEXT_ft1_init_ack& e) {
 		const uint32_t randomized_negotiated_packet_data_size = std::min(negotiated_packet_data_size, random_max_data_size);
 
 		peer.max_packet_data_size = randomized_negotiated_packet_data_size;
+		peer.mtu.negotiated_max = negotiated_packet_data_size;
+		peer.mtu.search_high = negotiated_packet_data_size;
+		peer.mtu.confirmed = randomized_negotiated_packet_data_size;
 
 		std::cerr << "NGCFT1: creating cca with max:" << peer.max_packet_data_size << "\n";
 
-		peer.cca = std::make_unique<CUBIC>(peer.max_packet_data_size);
-		//peer.cca = std::make_unique<LEDBAT>(peer.max_packet_data_size);
-		//peer.cca = std::make_unique<FlowOnly>(peer.max_packet_data_size);
+		const auto cca_type = resolveCCAType(groups[e.group_number], peer);
+		peer.cca_active = cca_type == CCAType::AUTO ? CCAType::LEDBAT : cca_type;
+		peer.cca = createCCA(peer.cca_active, peer.max_packet_data_size);
 		//peer.cca->max_byterate_allowed = 1.f *1024*1024;
 	} else {
 		std::cerr << "NGCFT1: reusing cca. rtt:" << peer.cca->getCurrentRTT() << " w:" << peer.cca->getWindow() << " ifc:" << peer.cca->inFlightCount() << "\n";
 	}
 
+	// an ack without features is what old peers send, also for the legacy init
+	peer.legacy_init = e.feature_flags == 0x00;
+
+	// only what we advertised
+	const uint8_t feature_flags = e.feature_flags & transfer.feature_flags;
+	if (feature_flags & FT1_FEATURE_WIDE_IDS) {
+		peer.wide_transfer_ids = true;
+	}
+	transfer.fec = feature_flags & FT1_FEATURE_FEC;
+	if (feature_flags & FT1_FEATURE_ZSTD) {
+		ByteSpan dict;
+		if (feature_flags & FT1_FEATURE_ZSTD_DICT) {
+			if (const auto it = _zstd_dicts.find(transfer.file_kind); it != _zstd_dicts.cend()) {
+				dict = ByteSpan{it->second};
+			}
+		}
+		transfer.zstd = std::make_unique<ZstdStreamCompressor>(zstd_level, dict);
+	}
+
 	// iterate will now call NGC_FT1_send_data_cb
 	transfer.state = State::SENDING;
 	transfer.time_since_activity = 0.f;
@@ -528,7 +1186,7 @@ bool NGCFT1::onEvent(const Events::NGCEXT_ft1_data& e) {
 	//std::cout << "NGCFT1: got FT1_DATA " << e.sequence_id << "\n";
 #endif
 
-	if (e.data.empty()) {
+	if (e.data.size == 0) {
 		std::cerr << "NGCFT1 error: data of size 0!\n";
 		return true;
 	}
@@ -539,49 +1197,148 @@ bool NGCFT1::onEvent(const Events::NGCEXT_ft1_data& e) {
 	}
 
 	Group::Peer& peer = groups[e.group_number].peers[e.peer_number];
-	if (!peer.recv_transfers[e.transfer_id].has_value()) {
+	const auto transfer_it = peer.recv_transfers.find(e.transfer_id);
+	if (transfer_it == peer.recv_transfers.end()) {
 		std::cerr << "NGCFT1 warning: data for unknown transfer\n";
 		return true;
 	}
 
-	auto& transfer = peer.recv_transfers[e.transfer_id].value();
+	if (!_downlink.tryConsume(e.data.size)) {
+		// over the global downlink limit, drop without acking so the sender backs off
+		return true;
+	}
+
+	auto& transfer = transfer_it->second;
 	transfer.timer = 0.f;
 	if (transfer.state == Group::Peer::RecvTransfer::State::INITED) {
 		transfer.state = Group::Peer::RecvTransfer::State::RECV;
 	}
 
-	// do reassembly, ignore dups
-	transfer.rsb.add(e.sequence_id, std::vector<uint8_t>(e.data)); // TODO: ugly explicit copy for what should just be a move
+	const size_t rsb_size_before = transfer.rsb.size();
 
-	// loop for chunks without holes
-	while (transfer.rsb.canPop()) {
-		auto data = transfer.rsb.pop();
+	// in order, directly hand out the packet data
+	if (transfer.rsb.addInOrder(e.sequence_id)) {
+		if (!recvTransferData(e.group_number, e.peer_number, e.transfer_id, transfer, e.data)) {
+			peer.recv_transfers.erase(transfer_it);
+			return true;
+		}
 
-		// TODO: check return value
-		dispatch(
-			NGCFT1_Event::recv_data,
-			Events::NGCFT1_recv_data{
-				e.group_number, e.peer_number,
-				e.transfer_id,
-				transfer.file_size_current,
-				data.data(), static_cast<uint32_t>(data.size())
-			}
-		);
+		if (transfer.fec) {
+			// parity of its block might still need it
+			transfer.rsb.keep(e.sequence_id, e.data);
+		}
+	} else {
+		// do reassembly, ignore dups
+		// out of order, only now we need to keep a copy
+		transfer.rsb.add(e.sequence_id, e.data);
+	}
 
-		transfer.file_size_current += data.size();
+	if (!updateRecvTransfer(e.group_number, e.peer_number, e.transfer_id, transfer, rsb_size_before)) {
+		peer.recv_transfers.erase(transfer_it);
+	}
+
+	return true;
+}
+
+bool NGCFT1::onEvent(const Events::NGCEXT_ft1_data_fec& e) {
+	if (!groups.count(e.group_number)) {
+		std::cerr << "NGCFT1 warning: data_fec for unknown group\n";
+		return true;
+	}
+
+	Group::Peer& peer = groups[e.group_number].peers[e.peer_number];
+	const auto transfer_it = peer.recv_transfers.find(e.transfer_id);
+	if (transfer_it == peer.recv_transfers.end()) {
+		return true; // likely done already
+	}
+
+	auto& transfer = transfer_it->second;
+	if (!transfer.fec) {
+		std::cerr << "NGCFT1 warning: data_fec for transfer without fec\n";
+		return true;
+	}
+
+	if (!_downlink.tryConsume(e.parity.size)) {
+		return true;
+	}
+
+	const size_t rsb_size_before = transfer.rsb.size();
+
+	if (transfer.rsb.addParity(e.first_sequence_id, e.count, e.size_xor, e.parity) > 0) {
+		transfer.timer = 0.f;
+		if (!updateRecvTransfer(e.group_number, e.peer_number, e.transfer_id, transfer, rsb_size_before)) {
+			peer.recv_transfers.erase(transfer_it);
+		}
+	}
+
+	return true;
+}
+
+bool NGCFT1::recvTransferData(uint32_t group_number, uint32_t peer_number, uint16_t transfer_id, Group::Peer::RecvTransfer& transfer, ByteSpan data) {
+	if (transfer.zstd) {
+		// never more than what is left of the file, stops a small segment from expanding into a huge buffer
+		if (!transfer.zstd->feed(data, transfer.file_size - transfer.file_size_current)) {
+			std::cerr << "NGCFT1 error: decompressing failed (corrupt or larger than the file) for " << int(transfer_id) << ", dropping transfer\n";
+			return false;
+		}
+		data = transfer.zstd->output();
+
+		if (data.empty()) {
+			return true;
+		}
+	}
+
+	// TODO: check return value
+	dispatch(
+		NGCFT1_Event::recv_data,
+		Events::NGCFT1_recv_data{
+			group_number, peer_number,
+			transfer_id,
+			transfer.file_size_current,
+			data.ptr, static_cast<uint32_t>(data.size)
+		}
+	);
+
+	transfer.file_size_current += data.size;
+
+	return true;
+}
+
+bool NGCFT1::updateRecvTransfer(uint32_t group_number, uint32_t peer_number, uint16_t transfer_id, Group::Peer::RecvTransfer& transfer, size_t rsb_size_before) {
+	// loop for chunks without holes
+	while (transfer.rsb.canPop()) {
+		if (!recvTransferData(group_number, peer_number, transfer_id, transfer, transfer.rsb.pop())) {
+			return false;
+		}
 	}
 
 	// send acks
-	// reverse, last seq is most recent
-	std::vector<uint16_t> ack_seq_ids(transfer.rsb.ack_seq_ids.crbegin(), transfer.rsb.ack_seq_ids.crend());
-	// TODO: check if this caps at max acks
-	if (!ack_seq_ids.empty()) {
-		// TODO: check return value
-		_neep.send_ft1_data_ack(e.group_number, e.peer_number, e.transfer_id, ack_seq_ids.data(), ack_seq_ids.size());
+	if (transfer.sack) {
+		transfer.acks_pending++;
+
+		// coalesce, but send right away if a hole opened or closed (faster loss detection) or we are done
+		const bool hole_changed = (rsb_size_before == 0) != (transfer.rsb.size() == 0);
+		if (
+			transfer.acks_pending >= sack_every_n_packets ||
+			hole_changed ||
+			transfer.file_size_current == transfer.file_size
+		) {
+			sendSACK(group_number, peer_number, transfer_id, transfer);
+		}
+	} else {
+		// reverse, last seq is most recent
+		std::vector<uint16_t> ack_seq_ids(transfer.rsb.ack_seq_ids.crbegin(), transfer.rsb.ack_seq_ids.crend());
+		// TODO: check if this caps at max acks
+		if (!ack_seq_ids.empty()) {
+			// TODO: check return value
+			_neep.send_ft1_data_ack(group_number, peer_number, transfer_id, ack_seq_ids.data(), ack_seq_ids.size());
+		}
 	}
 
 
-	if (transfer.file_size_current == transfer.file_size) {
+	// with compression the frame epilogue (checksum) can still be outstanding after the last decompressed byte,
+	// only a fully verified frame counts as received
+	if (transfer.file_size_current == transfer.file_size && (!transfer.zstd || transfer.zstd->done())) {
 		// all data received
 		transfer.state = Group::Peer::RecvTransfer::State::FINISHING;
 
@@ -593,8 +1350,8 @@ bool NGCFT1::onEvent(const Events::NGCEXT_ft1_data& e) {
 		dispatch(
 			NGCFT1_Event::recv_done,
 			Events::NGCFT1_recv_done{
-				e.group_number, e.peer_number,
-				e.transfer_id
+				group_number, peer_number,
+				transfer_id
 			}
 		);
 	}
@@ -613,14 +1370,15 @@ bool NGCFT1::onEvent(const Events::NGCEXT_ft1_data_ack& e) {
 	}
 
 	Group::Peer& peer = groups[e.group_number].peers[e.peer_number];
-	if (!peer.send_transfers[e.transfer_id].has_value()) {
+	const auto transfer_it = peer.send_transfers.find(e.transfer_id);
+	if (transfer_it == peer.send_transfers.end()) {
 		// we delete directly, packets might still be in flight (in practice they are when ce)
 		// update: we no longer delete directly, but its kinda hacky
 		std::cerr << "NGCFT1 warning: data_ack for unknown transfer\n";
 		return true;
 	}
 
-	Group::Peer::SendTransfer& transfer = peer.send_transfers[e.transfer_id].value();
+	Group::Peer::SendTransfer& transfer = transfer_it->second;
 
 	using State = Group::Peer::SendTransfer::State;
 	if (transfer.state != State::SENDING && transfer.state != State::FINISHING) {
@@ -633,17 +1391,19 @@ bool NGCFT1::onEvent(const Events::NGCEXT_ft1_data_ack& e) {
 	{
 		std::vector<CCAI::SeqIDType> seqs;
 		seqs.reserve(e.sequence_ids.size());
-		for (const auto it : e.sequence_ids) {
+		for (size_t i = 0; i < e.sequence_ids.size(); i++) {
 			// TODO: improve this o.o
-			seqs.push_back({e.transfer_id, it});
-			transfer.ssb.erase(it);
+			const uint16_t seq_id = e.sequence_ids[i];
+			seqs.push_back({e.transfer_id, seq_id});
+			transfer.ssb.erase(seq_id);
 		}
 		peer.cca->onAck(std::move(seqs));
+		peer.mtu.timeouts_in_row = 0;
 	}
 
 	// delete if all packets acked
 	// TODO: check for FINISHING state?
-	if (transfer.file_size == transfer.file_size_current && transfer.ssb.size() == 0) {
+	if (transfer.allDataSegmented() && transfer.ssb.size() == 0) {
 		std::cout << "NGCFT1: " << int(e.transfer_id) << " done. wnd:" << peer.cca->getWindow() << "\n";
 		dispatch(
 			NGCFT1_Event::send_done,
@@ -652,14 +1412,124 @@ bool NGCFT1::onEvent(const Events::NGCEXT_ft1_data_ack& e) {
 				e.transfer_id,
 			}
 		);
-		peer.send_transfers[e.transfer_id].reset();
+		eraseSendTransfer(peer, e.transfer_id);
 	}
 
 	return true;
 }
 
+bool NGCFT1::onEvent(const Events::NGCEXT_ft1_data_sack& e) {
+	if (!groups.count(e.group_number)) {
+		std::cerr << "NGCFT1 warning: data_sack for unknown group\n";
+		return true;
+	}
+
+	Group::Peer& peer = groups[e.group_number].peers[e.peer_number];
+	const auto transfer_it = peer.send_transfers.find(e.transfer_id);
+	if (transfer_it == peer.send_transfers.end()) {
+		std::cerr << "NGCFT1 warning: data_sack for unknown transfer\n";
+		return true;
+	}
+
+	Group::Peer::SendTransfer& transfer = transfer_it->second;
+
+	using State = Group::Peer::SendTransfer::State;
+	if (transfer.state != State::SENDING && transfer.state != State::FINISHING) {
+		std::cerr << "NGCFT1 error: data_sack but not in SENDING or FINISHING state (" << int(transfer.state) << ")\n";
+		return true;
+	}
+
+	transfer.time_since_activity = 0.f;
+
+	{
+		auto& ssb = transfer.ssb;
+
+		// in seq order, so the first is the oldest newly acked (what the cca expects first)
+		std::vector<CCAI::SeqIDType> seqs;
+
+		// cumulative, everything still in flight before next_sequence_id
+		// ignored if older than our window
+		if (uint16_t(e.next_sequence_id - ssb.first_seq_id) <= uint16_t(ssb.next_seq_id - ssb.first_seq_id)) {
+			for (uint16_t seq = ssb.first_seq_id; seq != e.next_sequence_id; seq++) {
+				if (ssb.has(seq)) {
+					seqs.push_back({e.transfer_id, seq});
+				}
+			}
+		}
+
+		// selective
+		for (size_t i = 0; i < e.sack_bitset.size*8; i++) {
+			if (e.sack_bitset.ptr[i/8] & (1u << (i%8))) {
+				const uint16_t seq = e.next_sequence_id + 1 + i;
+				if (ssb.has(seq)) {
+					seqs.push_back({e.transfer_id, seq});
+				}
+			}
+		}
+
+		for (const auto& it : seqs) {
+			ssb.erase(it.second);
+		}
+
+		if (!seqs.empty()) {
+			peer.cca->onAck(std::move(seqs));
+			peer.mtu.timeouts_in_row = 0;
+		}
+	}
+
+	// delete if all packets acked
+	if (transfer.allDataSegmented() && transfer.ssb.size() == 0) {
+		std::cout << "NGCFT1: " << int(e.transfer_id) << " done. wnd:" << peer.cca->getWindow() << "\n";
+		dispatch(
+			NGCFT1_Event::send_done,
+			Events::NGCFT1_send_done{
+				e.group_number, e.peer_number,
+				e.transfer_id,
+			}
+		);
+		eraseSendTransfer(peer, e.transfer_id);
+	}
+
+	return true;
+}
+
+bool NGCFT1::onEvent(const Events::NGCEXT_ft1_mtu_probe& e) {
+	if (e.padding.size != e.probe_size) {
+		std::cerr << "NGCFT1 warning: mtu_probe with wrong padding size " << e.padding.size << "/" << e.probe_size << "\n";
+		return true;
+	}
+
+	// we only echo, the sender keeps the state
+	_neep.send_ft1_mtu_probe_ack(e.group_number, e.peer_number, e.probe_id, e.probe_size);
+
+	return true;
+}
+
+bool NGCFT1::onEvent(const Events::NGCEXT_ft1_mtu_probe_ack& e) {
+	if (!groups.count(e.group_number) || !groups[e.group_number].peers.count(e.peer_number)) {
+		std::cerr << "NGCFT1 warning: mtu_probe_ack for unknown peer\n";
+		return true;
+	}
+
+	Group::Peer& peer = groups[e.group_number].peers[e.peer_number];
+	auto& mtu = peer.mtu;
+
+	if (mtu.probe_size == 0 || e.probe_id != mtu.probe_id || e.probe_size != mtu.probe_size) {
+		return true; // late, the probe already counted as lost
+	}
+
+	std::cout << "NGCFT1: segment size " << mtu.probe_size << " confirmed for " << e.group_number << ":" << e.peer_number << " (max " << mtu.negotiated_max << ")\n";
+
+	setPeerSegmentSize(peer, mtu.probe_size);
+	mtu.probe_size = 0;
+	mtu.probe_fails = 0;
+	mtu.timer = 0.f;
+
+	return true;
+}
+
 bool NGCFT1::onEvent(const Events::NGCEXT_ft1_message& e) {
-	std::cout << "NGCFT1: got FT1_MESSAGE mid:" << e.message_id << " fk:" << e.file_kind << " [" << bin2hex(e.file_id) << "]\n";
+	std::cout << "NGCFT1: got FT1_MESSAGE mid:" << e.message_id << " fk:" << e.file_kind << " [" << bin2hex(std::vector<uint8_t>(e.file_id.ptr, e.file_id.ptr+e.file_id.size)) << "]\n";
 
 	// .... just rethrow??
 	// TODO: dont
@@ -669,23 +1539,43 @@ bool NGCFT1::onEvent(const Events::NGCEXT_ft1_message& e) {
 			e.group_number, e.peer_number,
 			e.message_id,
 			e.file_kind,
-			e.file_id.data(), static_cast<uint32_t>(e.file_id.size())
+			e.file_id.ptr, static_cast<uint32_t>(e.file_id.size)
 		}
 	);
 }
 
 bool NGCFT1::onEvent(const Events::NGCEXT_ft1_init2& e) {
 //#if !NDEBUG
-	std::cout << "NGCFT1: got FT1_INIT2 fk:" << e.file_kind << " fs:" << e.file_size << " tid:" << int(e.transfer_id) << " ff:" << int(e.feature_flags) << " [" << bin2hex(e.file_id) << "]\n";
+	std::cout << "NGCFT1: got FT1_INIT2 fk:" << e.file_kind << " fs:" << e.file_size << " tid:" << int(e.transfer_id) << " ff:" << int(e.feature_flags) << " [" << bin2hex(std::vector<uint8_t>(e.file_id.ptr, e.file_id.ptr+e.file_id.size)) << "]\n";
 //#endif
 
+	auto& peer = groups[e.group_number].peers[e.peer_number];
+
+	// they understand wide ids, so they can get them too
+	if ((e.feature_flags & FT1_FEATURE_WIDE_IDS) || e.transfer_id > 0xff) {
+		peer.legacy_init = false;
+		peer.wide_transfer_ids = true;
+	}
+
+	// a retried init (eg. the init_ack got lost), answer the same again
+	if (const auto existing = peer.recv_transfers.find(e.transfer_id); existing != peer.recv_transfers.end()) {
+		if (
+			existing->second.state == Group::Peer::RecvTransfer::State::INITED &&
+			existing->second.file_kind == e.file_kind &&
+			existing->second.file_id == static_cast<std::vector<uint8_t>>(e.file_id)
+		) {
+			_neep.send_ft1_init_ack(e.group_number, e.peer_number, e.transfer_id, existing->second.feature_flags);
+			return true;
+		}
+	}
+
 	bool accept = false;
 	dispatch(
 		NGCFT1_Event::recv_init,
 		Events::NGCFT1_recv_init{
 			e.group_number, e.peer_number,
 			e.file_kind,
-			e.file_id.data(), static_cast<uint32_t>(e.file_id.size()),
+			e.file_id.ptr, static_cast<uint32_t>(e.file_id.size),
 			e.transfer_id,
 			e.file_size,
 			accept
@@ -697,23 +1587,38 @@ bool NGCFT1::onEvent(const Events::NGCEXT_ft1_init2& e) {
 		return true; // return true?
 	}
 
-	_neep.send_ft1_init_ack(e.group_number, e.peer_number, e.transfer_id);
+	// only what both sides support
+	uint8_t feature_flags = e.feature_flags & ft1_supported_features;
+	if ((feature_flags & FT1_FEATURE_ZSTD) && (e.feature_flags & FT1_FEATURE_ZSTD_DICT) && _zstd_dicts.count(e.file_kind)) {
+		feature_flags |= FT1_FEATURE_ZSTD_DICT;
+	}
+
+	_neep.send_ft1_init_ack(e.group_number, e.peer_number, e.transfer_id, feature_flags);
 
 	std::cout << "NGCFT1: accepted init2\n";
 
-	auto& peer = groups[e.group_number].peers[e.peer_number];
-	if (peer.recv_transfers[e.transfer_id].has_value()) {
+	if (peer.recv_transfers.count(e.transfer_id)) {
 		std::cerr << "NGCFT1 warning: overwriting existing recv_transfer " << int(e.transfer_id) << ", other peer started new transfer on preexising\n";
 	}
 
-	peer.recv_transfers[e.transfer_id] = Group::Peer::RecvTransfer{
+	auto& transfer = peer.recv_transfers[e.transfer_id] = Group::Peer::RecvTransfer{
 		e.file_kind,
-		e.file_id,
+		std::vector<uint8_t>(e.file_id.ptr, e.file_id.ptr+e.file_id.size), // we keep it, so copy
 		Group::Peer::RecvTransfer::State::INITED,
 		e.file_size,
 		0u,
 		{} // rsb
 	};
+	transfer.sack = feature_flags & FT1_FEATURE_SACK;
+	transfer.fec = feature_flags & FT1_FEATURE_FEC;
+	transfer.feature_flags = feature_flags;
+	if (feature_flags & FT1_FEATURE_ZSTD) {
+		ByteSpan dict;
+		if (feature_flags & FT1_FEATURE_ZSTD_DICT) {
+			dict = ByteSpan{_zstd_dicts.at(e.file_kind)};
+		}
+		transfer.zstd = std::make_unique<ZstdStreamDecompressor>(dict);
+	}
 
 	return true;
 }
@@ -737,41 +1642,29 @@ bool NGCFT1::onToxEvent(const Tox_Event_Group_Peer_Exit* e) {
 	{
 		auto& peer = group.peers.at(peer_number);
 
-		for (size_t i = 0; i < peer.send_transfers.size(); i++) {
-			auto& it_opt = peer.send_transfers.at(i);
-			if (!it_opt.has_value()) {
-				continue;
-			}
-
-			std::cout << "NGCFT1: sending " << int(i) << " canceled bc peer offline\n";
+		for (const auto& [idx, transfer] : peer.send_transfers) {
+			std::cout << "NGCFT1: sending " << int(idx) << " canceled bc peer offline\n";
 			dispatch(
 				NGCFT1_Event::send_done,
 				Events::NGCFT1_send_done{
 					group_number, peer_number,
-					static_cast<uint8_t>(i),
+					idx,
 				}
 			);
-
-			it_opt.reset();
 		}
+		peer.send_transfers.clear();
 
-		for (size_t i = 0; i < peer.recv_transfers.size(); i++) {
-			auto& it_opt = peer.recv_transfers.at(i);
-			if (!it_opt.has_value()) {
-				continue;
-			}
-
-			std::cout << "NGCFT1: receiving " << int(i) << " canceled bc peer offline\n";
+		for (const auto& [idx, transfer] : peer.recv_transfers) {
+			std::cout << "NGCFT1: receiving " << int(idx) << " canceled bc peer offline\n";
 			dispatch(
 				NGCFT1_Event::recv_done,
 				Events::NGCFT1_recv_done{
 					group_number, peer_number,
-					static_cast<uint8_t>(i),
+					idx,
 				}
 			);
-
-			it_opt.reset();
 		}
+		peer.recv_transfers.clear();
 
 		// reset cca
 		peer.cca.reset(); // dont actually reallocate
@@ -8,16 +8,23 @@
 #include <solanaceae/ngc_ext/ngcext.hpp>
 
 #include "./cca.hpp"
+#include "./cca_factory.hpp"
 
 #include "./rcv_buf.hpp"
 #include "./snd_buf.hpp"
+#include "./token_bucket.hpp"
+#include "./zstd_stream.hpp"
+#include "./worker_pool.hpp"
 
 #include "./ngcft1_file_kind.hpp"
 
 #include <cstdint>
 #include <map>
-#include <set>
+#include <deque>
+#include <optional>
+#include <limits>
 #include <memory>
+#include <mutex>
 #include <random>
 
 namespace Events {
@@ -43,7 +50,7 @@ namespace Events {
 		const uint8_t* file_id;
 		uint32_t file_id_size;
 
-		const uint8_t transfer_id;
+		const uint16_t transfer_id;
 		const uint64_t file_size;
 
 		// return true to accept, false to deny
@@ -54,7 +61,7 @@ namespace Events {
 		uint32_t group_number;
 		uint32_t peer_number;
 
-		uint8_t transfer_id;
+		uint16_t transfer_id;
 
 		uint64_t data_offset;
 		const uint8_t* data;
@@ -66,7 +73,7 @@ namespace Events {
 		uint32_t group_number;
 		uint32_t peer_number;
 
-		uint8_t transfer_id;
+		uint16_t transfer_id;
 
 		uint64_t data_offset;
 		uint8_t* data;
@@ -77,7 +84,7 @@ namespace Events {
 		uint32_t group_number;
 		uint32_t peer_number;
 
-		uint8_t transfer_id;
+		uint16_t transfer_id;
 		// TODO: reason
 	};
 
@@ -85,7 +92,7 @@ namespace Events {
 		uint32_t group_number;
 		uint32_t peer_number;
 
-		uint8_t transfer_id;
+		uint16_t transfer_id;
 		// TODO: reason
 	};
 
@@ -119,6 +126,15 @@ enum class NGCFT1_Event : uint8_t {
 	MAX
 };
 
+// weight of a sending transfer in the per peer send scheduler (deficit round robin)
+// a transfer gets a share of the peers bandwidth proportional to it,
+// so small latency sensitive transfers (info, hs2) should use HIGH
+enum class NGCFT1_Priority : uint8_t {
+	BULK = 1,
+	NORMAL = 4,
+	HIGH = 16,
+};
+
 struct NGCFT1EventI {
 	using enumType = NGCFT1_Event;
 	virtual bool onEvent(const Events::NGCFT1_recv_request&) { return false; }
@@ -142,18 +158,101 @@ class NGCFT1 : public ToxEventI, public NGCEXTEventI, public NGCFT1EventProvider
 
 	std::default_random_engine _rng{std::random_device{}()};
 
-	float _time_since_activity {10.f};
-
 	// TODO: config
 	size_t acks_per_packet {3u}; // 3
+	size_t sack_every_n_packets {8u}; // coalesce sacks
+	float sack_max_delay {0.005f}; // sec, send pending sacks at the latest after this
 	float init_retry_timeout_after {16.f}; // rtt
 	float sending_give_up_after {30.f}; // sec (per active transfer)
+	float send_tick_interval {0.005f}; // sec, while there is new data waiting to be sent
+	float max_tick_interval {1.f}; // sec, when nothing is going on
+
+	// cca used, unless overwritten per group or peer
+	CCAType _cca_default {CCAType::CUBIC};
+	// AUTO mode, queueing delay is rtt above the lowest rtt seen recently
+	float cca_auto_low_queue_delay {0.015f}; // sec, below -> CUBIC
+	float cca_auto_high_queue_delay {0.1f}; // sec, above -> LEDBAT
+	float cca_auto_switch_after {10.f}; // sec the condition has to hold
+	// like ledbat's base delay, the lowest rtt is kept per section and old sections expire,
+	// so a route change does not leave a wrong baseline forever
+	float cca_auto_min_rtt_section {60.f}; // sec
+	size_t cca_auto_min_rtt_sections {10u};
+
+	// segment size probing, per peer
+	bool mtu_probing {true};
+	float mtu_probe_interval {1.f}; // sec between probes
+	size_t mtu_probe_max_fails {3u}; // lost probes until the size is considered too big
+	uint32_t mtu_probe_min_step {16u}; // bytes, the search is done when the range is smaller
+	float mtu_research_after {600.f}; // sec, restart a finished search (the path might have changed)
+	size_t mtu_black_hole_timeouts {16u}; // timeout rounds (at most one per rtt) without an ack in between, drops to the base size
+	static constexpr uint32_t mtu_base_size {500-4}; // assumed to always get through
+
+	// fec, if negotiated, one xor parity per block, block size follows the loss rate
+	float fec_min_loss {0.01f}; // no parity below
+	size_t fec_block_min {4u}; // segments per parity, at high loss
+	size_t fec_block_max {32u};
+
+	// zstd, if negotiated and the sender says the data can be compressed
+	int zstd_level {3};
+	// per file_kind, both sides need the same
+	std::map<uint32_t, std::vector<uint8_t>> _zstd_dicts;
+
+	// global limits over all groups and peers
+	TokenBucket _uplink;
+	TokenBucket _downlink; // enforced by dropping data, which the senders cca sees as loss
 
 	struct Group {
 		struct Peer {
 			uint32_t max_packet_data_size {500-4};
+
+			// segment size probing (like PLPMTUD rfc8899), using padding only probe packets
+			// max_packet_data_size follows confirmed
+			struct SegmentSizeProbe {
+				uint32_t confirmed {mtu_base_size}; // largest size known to get through
+				uint32_t search_high {mtu_base_size}; // largest size not known to fail
+				uint32_t negotiated_max {mtu_base_size};
+
+				uint32_t probe_size {0}; // of the probe in flight, 0 if none
+				uint8_t probe_id {0};
+				size_t probe_fails {0}; // at the current probe size
+
+				// since the probe was sent, or since the last one finished
+				float timer {0.f};
+
+				// black hole detection
+				size_t timeouts_in_row {0}; // rounds, see mtu_black_hole_timeouts
+				float timeout_round_timer {std::numeric_limits<float>::infinity()}; // since the last counted round
+				size_t black_holes {0};
+			} mtu;
 			//std::unique_ptr<CCAI> cca = std::make_unique<CUBIC>(max_packet_data_size); // TODO: replace with tox_group_max_custom_lossy_packet_length()-4
 			std::unique_ptr<CCAI> cca;
+			CCAType cca_active {CCAType::CUBIC}; // type of cca
+			std::optional<CCAType> cca_type; // overrides the group and default
+
+			// AUTO mode
+			float cca_auto_min_rtt {std::numeric_limits<float>::infinity()}; // over the kept sections and the current one
+			float cca_auto_section_min_rtt {std::numeric_limits<float>::infinity()};
+			float cca_auto_section_timer {0.f};
+			std::deque<float> cca_auto_min_rtt_history; // per finished section, oldest first
+			float cca_auto_timer {0.f}; // how long the switch condition held
+
+			struct CCASwitchEvent {
+				CCAType from;
+				CCAType to;
+				const char* reason;
+				float rtt;
+				float queue_delay;
+			};
+			std::deque<CCASwitchEvent> cca_switch_events; // the last few, for the ui
+			size_t cca_switch_count {0};
+
+			// FT1_FEATURE_WIDE_IDS, learned from init2 and init_ack
+			// without it, only 256 transfers per direction and only ids up to 0xff
+			bool wide_transfer_ids {false};
+
+			// acked an init without any feature flags, so likely does not know init2.
+			// new transfers then start with the legacy init instead of waiting out a retry
+			bool legacy_init {false};
 
 			struct RecvTransfer {
 				uint32_t file_kind;
@@ -174,9 +273,22 @@ class NGCFT1 : public ToxEventI, public NGCEXTEventI, public NGCFT1EventProvider
 
 				// sequence id based reassembly
 				RecvSequenceBuffer rsb;
+
+				// negotiated, ack with FT1_DATA_SACK instead of FT1_DATA_ACK
+				bool sack {false};
+				size_t acks_pending {0};
+				float ack_timer {0.f};
+
+				// negotiated, the sender adds FT1_DATA_FEC parity
+				bool fec {false};
+
+				// negotiated, decompressed before handing out
+				// file_size and file_size_current are uncompressed
+				uint8_t feature_flags {0};
+				std::unique_ptr<ZstdStreamDecompressor> zstd;
 			};
-			std::array<std::optional<RecvTransfer>, 256> recv_transfers;
-			size_t next_recv_transfer_idx {0}; // next id will be 0
+			// sparse, only active transfers
+			std::map<uint16_t, RecvTransfer> recv_transfers;
 
 			struct SendTransfer {
 				uint32_t file_kind;
@@ -203,27 +315,132 @@ class NGCFT1 : public ToxEventI, public NGCEXTEventI, public NGCFT1EventProvider
 				SendSequenceBuffer ssb;
 
 				uint64_t packets_resent {0};
+
+				// send scheduler
+				NGCFT1_Priority priority {NGCFT1_Priority::NORMAL};
+				int64_t deficit {0}; // bytes
+
+				// negotiated, xor parity over the current block of new segments
+				bool fec {false};
+				uint16_t fec_first_seq_id {0};
+				uint8_t fec_count {0};
+				uint16_t fec_size_xor {0};
+				std::vector<uint8_t> fec_parity;
+
+				// advertised in init2
+				uint8_t feature_flags {0};
+
+				// negotiated, segments are cut from the compressed stream
+				// file_size and file_size_current are uncompressed
+				std::unique_ptr<ZstdStreamCompressor> zstd;
+
+				// all data is in segments (sent, not necessarily acked)
+				bool allDataSegmented(void) const;
 			};
-			std::array<std::optional<SendTransfer>, 256> send_transfers;
-			size_t next_send_transfer_idx {0}; // next id will be 0
-			size_t next_send_transfer_send_idx {0};
+			// sparse, only active transfers
+			std::map<uint16_t, SendTransfer> send_transfers;
+			uint16_t next_send_transfer_idx {0}; // next id will be 0
+
+			// ids of all send_transfers, in round robin order
+			std::vector<uint16_t> active_send_list;
+			size_t send_sched_cursor {0}; // into active_send_list
+			bool send_sched_resume {false}; // cursor transfer already got its quantum this round
 
 			size_t active_send_transfers {0};
 
 			uint64_t packets_resent {0};
 			int64_t last_can_send {0};
+
+			// with send threads, tox rejected a queued packet (send queue full?)
+			// (a full worker queue fails the send right away, like tox does without threads)
+			// signaled to the cca on the next tick, the data gets resent on timeout
+			bool send_queue_rejected {false};
 		};
 		std::map<uint32_t, Peer> peers;
+
+		std::optional<CCAType> cca_type; // overrides the default
 	};
 	std::map<uint32_t, Group> groups;
 
-	protected:
-		// general update with timeouts and resending
-		void updateSendTransferPhase1(float time_delta, uint32_t group_number, uint32_t peer_number, Group::Peer& peer, size_t idx, std::set<CCAI::SeqIDType>& timeouts_set, int64_t& can_packet_size);
-		// does sending new data
-		void updateSendTransferPhase2(float time_delta, uint32_t group_number, uint32_t peer_number, Group::Peer& peer, size_t idx, int64_t& can_packet_size);
+	// reused by updateSendTransferPhase2(), to not allocate every time
+	// one per send thread
+	struct SendScratch {
+		std::vector<NGCEXTEventProvider::FT1DataSegment> send_batch;
+		// uncompressed data for zstd
+		std::vector<uint8_t> zstd_input;
+	};
+	SendScratch _send_scratch;
+	// reused by updatePeerTimers(), transfers can be removed while iterating
+	std::vector<uint16_t> _active_send_scratch;
+
+	// multi threaded sending, see setSendThreads()
+	std::unique_ptr<WorkerPool> _send_pool;
+	std::vector<SendScratch> _send_pool_scratch; // per worker
+	// packets built on the workers, sent after they are done
+	std::vector<NGCEXTSendQueue> _send_queues; // per worker
+	// send_data subscribers are not thread safe, so they get called one at a time
+	std::mutex _send_data_mutex;
+
+	struct SendWork {
+		uint32_t group_number;
+		uint32_t peer_number;
+		Group::Peer* peer;
+		int64_t send_budget;
+		float next_deadline;
+	};
+	std::vector<SendWork> _send_work; // reused by iterate()
 
-		bool iteratePeer(float time_delta, uint32_t group_number, uint32_t peer_number, Group::Peer& peer);
+	protected:
+		// general update of timers and state
+		void updateSendTransferPhase1(float time_delta, uint32_t group_number, uint32_t peer_number, Group::Peer& peer, size_t idx);
+		// resend what the cca reported as timed out
+		void resendTimedOut(float time_delta, uint32_t group_number, uint32_t peer_number, Group::Peer& peer, Span<CCAI::SeqIDType> timeouts, int64_t& can_packet_size);
+		// does sending new data, up to deficit bytes
+		void updateSendTransferPhase2(float time_delta, uint32_t group_number, uint32_t peer_number, Group::Peer& peer, size_t idx, SendScratch& scratch, int64_t& can_packet_size, int64_t& deficit);
+		// segments per parity for the current loss rate, 0 if off
+		size_t getFECBlockSize(const Group::Peer& peer) const;
+		// sends the parity of the current block, if any
+		void flushFECBlock(uint32_t group_number, uint32_t peer_number, Group::Peer& peer, size_t idx, Group::Peer::SendTransfer& tf, int64_t& can_packet_size);
+
+		// deficit round robin over the active transfers, weighted by priority
+		void scheduleSendTransfers(float time_delta, uint32_t group_number, uint32_t peer_number, Group::Peer& peer, SendScratch& scratch, int64_t& can_packet_size);
+
+		// resets the transfer and removes it from the scheduler
+		void eraseSendTransfer(Group::Peer& peer, size_t idx);
+
+		// send_budget is the peers share of the global uplink, reduced by what was sent
+		// returns the time until the peer needs to be iterated again (+inf if never)
+		float iteratePeer(float time_delta, uint32_t group_number, uint32_t peer_number, Group::Peer& peer, int64_t& send_budget);
+		// the part of iteratePeer() that dispatches events other than send_data, always on the tox thread
+		float updatePeerTimers(float time_delta, uint32_t group_number, uint32_t peer_number, Group::Peer& peer);
+		// the rest, resends and new data. only touches the peer, so peers can be done in parallel
+		// does not consume from _uplink
+		float iteratePeerSend(float time_delta, uint32_t group_number, uint32_t peer_number, Group::Peer& peer, SendScratch& scratch, int64_t& send_budget);
+
+		// hands the packets the workers queued to tox
+		void flushSendQueue(void);
+
+		// replaces the cca, in flight segments are handed over to the new one
+		// type can not be AUTO
+		void switchPeerCCA(uint32_t group_number, uint32_t peer_number, Group::Peer& peer, CCAType type, const char* reason);
+		// peer, then group, then default
+		CCAType resolveCCAType(const Group& group, const Group::Peer& peer) const;
+		// switch to the configured cca, if the peer has one
+		void applyCCAConfig(uint32_t group_number, uint32_t peer_number, Group& group, Group::Peer& peer);
+		void updateAutoCCA(float time_delta, uint32_t group_number, uint32_t peer_number, Group::Peer& peer);
+
+		// sends a probe when due, handles lost probes and black holes
+		// returns the time until the next probe deadline
+		float updateSegmentSizeProbe(float time_delta, uint32_t group_number, uint32_t peer_number, Group::Peer& peer, int64_t& can_packet_size);
+		void setPeerSegmentSize(Group::Peer& peer, uint32_t size);
+
+		void sendSACK(uint32_t group_number, uint32_t peer_number, uint16_t transfer_id, Group::Peer::RecvTransfer& transfer);
+		// hands out data in stream order, decompressing if negotiated
+		// returns false if the transfer has to be dropped
+		bool recvTransferData(uint32_t group_number, uint32_t peer_number, uint16_t transfer_id, Group::Peer::RecvTransfer& transfer, ByteSpan data);
+		// hands out what can be popped, acks and finishes the transfer
+		// returns false if the transfer has to be dropped
+		bool updateRecvTransfer(uint32_t group_number, uint32_t peer_number, uint16_t transfer_id, Group::Peer::RecvTransfer& transfer, size_t rsb_size_before);
 
 		const CCAI* getPeerCCA(uint32_t group_number, uint32_t peer_number) const;
 
@@ -234,6 +451,7 @@ class NGCFT1 : public ToxEventI, public NGCEXTEventI, public NGCFT1EventProvider
 			NGCEXTEventProvider& neep
 		);
 
+		// returns the time until the next deadline (timeouts, resends, acks or data waiting to be sent)
 		float iterate(float delta);
 
 	public: // ft1 api
@@ -249,8 +467,9 @@ class NGCFT1 : public ToxEventI, public NGCEXTEventI, public NGCFT1EventProvider
 			uint32_t file_kind,
 			const uint8_t* file_id, uint32_t file_id_size,
 			uint64_t file_size,
-			uint8_t* transfer_id,
-			bool can_compress = false // set this if you know the data is compressable (eg text)
+			uint16_t* transfer_id,
+			bool can_compress = false, // set this if you know the data is compressable (eg text)
+			NGCFT1_Priority priority = NGCFT1_Priority::NORMAL
 		);
 
 		// sends the message and fills in message_id
@@ -261,7 +480,42 @@ class NGCFT1 : public ToxEventI, public NGCEXTEventI, public NGCFT1EventProvider
 			const uint8_t* file_id, uint32_t file_id_size
 		);
 
+	public: // threading
+		// spread the sending work of the peers over threads, 0 or 1 sends on the calling thread (default)
+		// each peer is handled by one thread per tick, events other than send_data stay on the calling thread
+		// send_data is dispatched from the worker threads, but never concurrently
+		// with threads, the uplink limit is split evenly, budget a peer leaves unused is not passed on that tick
+		// each thread queues a bounded number of packets per tick, sends past that fail like a full tox send queue
+		void setSendThreads(size_t threads);
+
+	public: // compression
+		// used for transfers of file_kind, if both sides have one (eg. trained on chat logs)
+		// empty to remove
+		void setZstdDictionary(uint32_t file_kind, std::vector<uint8_t> dict);
+
+	public: // global bandwidth limits
+		// bytes/sec over all groups and peers, 0 for unlimited (default)
+		// the uplink budget is split evenly between the peers that are sending
+		void setUplinkLimit(float bytes_per_sec);
+		void setDownlinkLimit(float bytes_per_sec);
+
+		struct BandwidthStats {
+			float uplink_limit {0.f}; // bytes/sec, 0 is unlimited
+			float downlink_limit {0.f};
+
+			uint64_t bytes_sent {0}; // data, including resends
+			uint64_t bytes_received {0}; // data, accepted by the downlink limit
+			uint64_t bytes_dropped {0}; // data, dropped by the downlink limit
+		};
+		BandwidthStats getBandwidthStats(void) const;
+
 	public: // cca stuff
+		// takes effect right away, or when the cca gets created
+		// nullopt to fall back to the group/default again
+		void setDefaultCCA(CCAType type);
+		void setGroupCCA(uint32_t group_number, std::optional<CCAType> type);
+		void setPeerCCA(uint32_t group_number, uint32_t peer_number, std::optional<CCAType> type);
+
 		// rtt/delay
 		// +inf on error or no cca
 		float getPeerRTT(uint32_t group_number, uint32_t peer_number) const;
@@ -284,6 +538,10 @@ class NGCFT1 : public ToxEventI, public NGCEXTEventI, public NGCFT1EventProvider
 		bool onEvent(const Events::NGCEXT_ft1_init_ack&) override;
 		bool onEvent(const Events::NGCEXT_ft1_data&) override;
 		bool onEvent(const Events::NGCEXT_ft1_data_ack&) override;
+		bool onEvent(const Events::NGCEXT_ft1_data_sack&) override;
+		bool onEvent(const Events::NGCEXT_ft1_data_fec&) override;
+		bool onEvent(const Events::NGCEXT_ft1_mtu_probe&) override;
+		bool onEvent(const Events::NGCEXT_ft1_mtu_probe_ack&) override;
 		bool onEvent(const Events::NGCEXT_ft1_message&) override;
 		bool onEvent(const Events::NGCEXT_ft1_init2&) override;
 
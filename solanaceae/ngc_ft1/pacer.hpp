@@ -0,0 +1,59 @@
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+
+// spreads sends evenly at a rate, instead of sending what the window allows at once
+// credit accumulates with time and is used up by sending
+struct Pacer {
+	float rate {0.f}; // bytes/sec, 0 (or inf) is unpaced
+	float credit {0.f}; // bytes
+
+	bool paced(void) const {
+		return rate > 0.f && !std::isinf(rate);
+	}
+
+	// what the rate gives over this much time is always allowed as a burst, about a send tick,
+	// so at high rates a tick still fits its share
+	static constexpr float burst_time {0.005f};
+
+	// credit is capped to burst_bytes (or burst_time at the rate, if larger),
+	// so neither idle time nor a long tick turns into a burst
+	void update(float time_delta, float new_rate, float burst_bytes) {
+		rate = new_rate;
+		if (!paced()) {
+			credit = 0.f;
+			return;
+		}
+
+		credit = std::min(credit + rate * time_delta, std::max(burst_bytes, rate * burst_time));
+	}
+
+	int64_t available(void) const {
+		if (!paced()) {
+			return std::numeric_limits<int64_t>::max();
+		}
+		return static_cast<int64_t>(std::max(credit, 0.f));
+	}
+
+	void onSent(size_t bytes) {
+		if (paced()) {
+			credit -= bytes;
+		}
+	}
+
+	void reset(void) {
+		credit = 0.f;
+	}
+
+	// seconds until bytes are available, the next release time
+	float timeUntil(float bytes) const {
+		if (!paced() || credit >= bytes) {
+			return 0.f;
+		}
+		return (bytes - credit) / rate;
+	}
+};
@@ -1,18 +1,250 @@
 #include "./rcv_buf.hpp"
 
+#include <algorithm>
+#include <cstring>
 #include <cassert>
 
+bool RecvSequenceBuffer::isPresent(uint16_t seq) const {
+	if (entry_sizes.empty()) {
+		return false;
+	}
+	const size_t slot = seq & (entry_sizes.size() - 1);
+	return entry_present[slot / 64] & (uint64_t(1) << (slot % 64));
+}
+
+void RecvSequenceBuffer::setPresent(uint16_t seq, bool value) {
+	const size_t slot = seq & (entry_sizes.size() - 1);
+	if (value) {
+		entry_present[slot / 64] |= uint64_t(1) << (slot % 64);
+	} else {
+		entry_present[slot / 64] &= ~(uint64_t(1) << (slot % 64));
+	}
+}
+
+void RecvSequenceBuffer::grow(size_t new_capacity, size_t new_stride) {
+	size_t capacity = std::max<size_t>(entry_sizes.size(), 64);
+	while (capacity < new_capacity) {
+		capacity *= 2;
+	}
+	new_stride = std::max(new_stride, stride);
+
+	std::vector<uint16_t> new_sizes(capacity);
+	std::vector<uint64_t> new_present((capacity + 63) / 64);
+	std::vector<uint32_t> new_seq(capacity, NO_SEQ);
+	std::vector<uint8_t> new_slab(capacity * new_stride);
+
+	// slots are indexed by seq, so every slot holding data moves to a distinct new one
+	const size_t new_mask = capacity - 1;
+	for (size_t slot = 0; slot < entry_sizes.size(); slot++) {
+		if (entry_seq[slot] == NO_SEQ) {
+			continue;
+		}
+		const uint16_t seq = entry_seq[slot];
+		const size_t new_slot = seq & new_mask;
+		new_sizes[new_slot] = entry_sizes[slot];
+		if (entry_present[slot / 64] & (uint64_t(1) << (slot % 64))) {
+			new_present[new_slot / 64] |= uint64_t(1) << (new_slot % 64);
+		}
+		new_seq[new_slot] = seq;
+		std::memcpy(new_slab.data() + new_slot * new_stride, slab.data() + slot * stride, entry_sizes[slot]);
+	}
+
+	entry_sizes = std::move(new_sizes);
+	entry_present = std::move(new_present);
+	entry_seq = std::move(new_seq);
+	slab = std::move(new_slab);
+	stride = new_stride;
+}
+
 void RecvSequenceBuffer::erase(uint16_t seq) {
-	entries.erase(seq);
+	if (!isPresent(seq)) {
+		return;
+	}
+	setPresent(seq, false);
+	present_count--;
 }
 
 // inflight chunks
 size_t RecvSequenceBuffer::size(void) const {
-	return entries.size();
+	return present_count;
+}
+
+void RecvSequenceBuffer::add(uint16_t seq_id, ByteSpan data) {
+	const size_t ahead = uint16_t(seq_id - next_seq_id);
+	if (ahead >= MAX_WINDOW) {
+		// old dup, ack again, the ack might have been lost
+		addAck(seq_id);
+		return;
+	}
+
+	if (ahead >= ACCEPT_WINDOW) {
+		// too far ahead, would make the ring huge
+		return;
+	}
+
+	// always ack, the ack might have been lost
+	addAck(seq_id);
+
+	if (ahead >= entry_sizes.size() || data.size > stride) {
+		grow(ahead + 1, data.size);
+	}
+
+	if (isPresent(seq_id)) {
+		return; // dup
+	}
+
+	insert(seq_id, data);
+
+	if (!_pending_parity.empty()) {
+		retryPendingParity();
+	}
+}
+
+void RecvSequenceBuffer::insert(uint16_t seq_id, ByteSpan data) {
+	const size_t slot = seq_id & (entry_sizes.size() - 1);
+	entry_sizes[slot] = data.size;
+	entry_seq[slot] = seq_id;
+	std::memcpy(slab.data() + slot * stride, data.ptr, data.size);
+	setPresent(seq_id, true);
+	present_count++;
+}
+
+void RecvSequenceBuffer::keep(uint16_t seq_id, ByteSpan data) {
+	if (entry_sizes.empty() || data.size > stride) {
+		grow(0, data.size);
+	}
+
+	if (isPresent(seq_id)) {
+		return; // slot is used by a buffered segment
+	}
+
+	const size_t slot = seq_id & (entry_sizes.size() - 1);
+	entry_sizes[slot] = data.size;
+	entry_seq[slot] = seq_id;
+	std::memcpy(slab.data() + slot * stride, data.ptr, data.size);
+
+	if (!_pending_parity.empty()) {
+		retryPendingParity();
+	}
+}
+
+bool RecvSequenceBuffer::hasData(uint16_t seq_id) const {
+	if (entry_sizes.empty()) {
+		return false;
+	}
+	return entry_seq[seq_id & (entry_sizes.size() - 1)] == seq_id;
+}
+
+RecvSequenceBuffer::ParityResult RecvSequenceBuffer::tryParity(const Parity& parity) {
+	size_t missing_count {0};
+	uint16_t missing_seq {0};
+	for (size_t i = 0; i < parity.count; i++) {
+		const uint16_t seq = parity.first_seq_id + i;
+		if (uint16_t(seq - next_seq_id) < MAX_WINDOW) {
+			// not handed out yet
+			if (uint16_t(seq - next_seq_id) >= entry_sizes.size() || !isPresent(seq)) {
+				missing_count++;
+				missing_seq = seq;
+			}
+		} else if (!hasData(seq)) {
+			return ParityResult::DONE; // handed out, but no longer kept
+		}
+	}
+
+	if (missing_count == 0) {
+		return ParityResult::DONE;
+	} else if (missing_count > 1) {
+		return ParityResult::PENDING;
+	}
+
+	_rebuild_scratch.assign(parity.data.cbegin(), parity.data.cend());
+	uint16_t size = parity.size_xor;
+	for (size_t i = 0; i < parity.count; i++) {
+		const uint16_t seq = parity.first_seq_id + i;
+		if (seq == missing_seq) {
+			continue;
+		}
+
+		const size_t slot = seq & (entry_sizes.size() - 1);
+		const uint8_t* data = slab.data() + slot * stride;
+		const size_t data_size = std::min<size_t>(entry_sizes[slot], _rebuild_scratch.size());
+		for (size_t j = 0; j < data_size; j++) {
+			_rebuild_scratch[j] ^= data[j];
+		}
+		size ^= entry_sizes[slot];
+	}
+
+	if (size == 0 || size > _rebuild_scratch.size()) {
+		return ParityResult::DONE; // does not add up
+	}
+
+	// same as add(), minus the retry
+	const size_t ahead = uint16_t(missing_seq - next_seq_id);
+	if (ahead >= ACCEPT_WINDOW) {
+		return ParityResult::DONE; // too far ahead, like in add()
+	}
+	if (ahead >= entry_sizes.size() || size > stride) {
+		grow(ahead + 1, size);
+	}
+	addAck(missing_seq);
+	insert(missing_seq, ByteSpan{_rebuild_scratch.data(), size});
+	rebuilt_count++;
+
+	return ParityResult::REBUILT;
+}
+
+size_t RecvSequenceBuffer::retryPendingParity(void) {
+	size_t rebuilt {0};
+
+	// a rebuilt segment can complete another block
+	bool progress {true};
+	while (progress) {
+		progress = false;
+		for (auto it = _pending_parity.begin(); it != _pending_parity.end();) {
+			const auto res = tryParity(*it);
+			if (res == ParityResult::PENDING) {
+				it++;
+				continue;
+			}
+
+			if (res == ParityResult::REBUILT) {
+				rebuilt++;
+				progress = true;
+			}
+			it = _pending_parity.erase(it);
+		}
+	}
+
+	return rebuilt;
+}
+
+size_t RecvSequenceBuffer::addParity(uint16_t first_seq_id, uint8_t count, uint16_t size_xor, ByteSpan parity) {
+	if (count == 0 || parity.size == 0) {
+		return 0;
+	}
+
+	_pending_parity.push_back({first_seq_id, count, size_xor, std::vector<uint8_t>(parity.begin(), parity.end())});
+	if (_pending_parity.size() > MAX_PENDING_PARITY) {
+		_pending_parity.erase(_pending_parity.begin());
+	}
+
+	return retryPendingParity();
 }
 
-void RecvSequenceBuffer::add(uint16_t seq_id, std::vector<uint8_t>&& data) {
-	entries[seq_id] = {data};
+bool RecvSequenceBuffer::addInOrder(uint16_t seq_id) {
+	if (seq_id != next_seq_id) {
+		return false;
+	}
+
+	// the entry cant be buffered, since we always pop until there is a hole
+	assert(!isPresent(seq_id));
+
+	next_seq_id++;
+	addAck(seq_id);
+	return true;
+}
+
+void RecvSequenceBuffer::addAck(uint16_t seq_id) {
 	ack_seq_ids.push_back(seq_id);
 	if (ack_seq_ids.size() > 3) { // TODO: magic
 		ack_seq_ids.pop_front();
@@ -20,25 +252,48 @@ void RecvSequenceBuffer::add(uint16_t seq_id, std::vector<uint8_t>&& data) {
 }
 
 bool RecvSequenceBuffer::canPop(void) const {
-	return entries.count(next_seq_id);
+	return isPresent(next_seq_id);
 }
 
-std::vector<uint8_t> RecvSequenceBuffer::pop(void) {
+ByteSpan RecvSequenceBuffer::pop(void) {
 	assert(canPop());
-	auto tmp_data = std::move(entries.at(next_seq_id).data);
+	const size_t slot = next_seq_id & (entry_sizes.size() - 1);
 	erase(next_seq_id);
 	next_seq_id++;
-	return tmp_data;
+	// still valid, only overwritten by add()
+	return ByteSpan{slab.data() + slot * stride, entry_sizes[slot]};
 }
 
 // for acking, might be bad since its front
 std::vector<uint16_t> RecvSequenceBuffer::frontSeqIDs(size_t count) const {
 	std::vector<uint16_t> seq_ids;
-	auto it = entries.cbegin();
-	for (size_t i = 0; i < count && it != entries.cend(); i++, it++) {
-		seq_ids.push_back(it->first);
+	uint16_t seq = next_seq_id;
+	for (size_t i = 0; i < entry_sizes.size() && seq_ids.size() < count; i++, seq++) {
+		if (isPresent(seq)) {
+			seq_ids.push_back(seq);
+		}
 	}
 
 	return seq_ids;
 }
 
+size_t RecvSequenceBuffer::sackBitset(uint8_t* out, size_t out_size) const {
+	size_t used {0};
+	uint16_t seq = next_seq_id + 1;
+	for (size_t i = 0; i < out_size; i++) {
+		uint8_t byte {0};
+		for (size_t bit = 0; bit < 8; bit++, seq++) {
+			// the ring only holds capacity entries ahead, everything else would alias
+			if (uint16_t(seq - next_seq_id) < entry_sizes.size() && isPresent(seq)) {
+				byte |= uint8_t(1u << bit);
+			}
+		}
+		out[i] = byte;
+		if (byte != 0) {
+			used = i + 1;
+		}
+	}
+
+	return used;
+}
+
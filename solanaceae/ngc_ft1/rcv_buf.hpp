@@ -1,18 +1,39 @@
 #pragma once
 
+#include <solanaceae/util/span.hpp>
+
+#include "./seq_window.hpp"
+
 #include <vector>
-#include <map>
 #include <deque>
 #include <cstdint>
 #include <cstddef>
 
+// reorder buffer for out-of-order segments
+// in order segments should be consumed directly (see addInOrder())
+// the rest is kept in a ring indexed by seq_id % capacity, with the data
+// in a single slab (fixed stride) and a bitmap of present entries
+// with fec, handed out data stays in the ring until the slot is reused,
+// so xor parity can rebuild a single missing segment of a block
 struct RecvSequenceBuffer {
-	struct RSBEntry {
-		std::vector<uint8_t> data;
-	};
+	// distance ahead of next_seq_id that still counts as ahead, half the seq_id space
+	// (everything else is behind, an old dup)
+	static constexpr size_t MAX_WINDOW {0x8000};
+	// max distance ahead of next_seq_id we buffer, the ring grows up to this
+	// the same as the senders window, beyond is dropped and not acked, so the sender resends it later
+	static constexpr size_t ACCEPT_WINDOW {ft1_seq_window};
+	static constexpr size_t MAX_PENDING_PARITY {8};
+	static constexpr uint32_t NO_SEQ {0xffffffff};
 
-	// sequence_id -> entry
-	std::map<uint16_t, RSBEntry> entries;
+	// size is always a power of 2 (or 0)
+	std::vector<uint16_t> entry_sizes;
+	std::vector<uint64_t> entry_present; // bitmap
+	std::vector<uint32_t> entry_seq; // seq_id the slot data belongs to, NO_SEQ if none
+	std::vector<uint8_t> slab;
+	size_t stride {0}; // largest segment seen
+
+	size_t present_count {0};
+	size_t rebuilt_count {0}; // segments rebuilt from parity
 
 	uint16_t next_seq_id {0};
 
@@ -24,13 +45,68 @@ struct RecvSequenceBuffer {
 	// inflight chunks
 	size_t size(void) const;
 
-	void add(uint16_t seq_id, std::vector<uint8_t>&& data);
+	// copies the data into the buffer
+	// dups are ignored (but still acked), seq_ids ACCEPT_WINDOW or more ahead are dropped (not acked)
+	void add(uint16_t seq_id, ByteSpan data);
+
+	// if seq_id is the next expected one, it is not buffered and returns true.
+	// the caller then has to consume the data directly (no copy)
+	bool addInOrder(uint16_t seq_id);
+
+	// fec, keep a copy of data handed out directly (see addInOrder())
+	// so it can be used to rebuild other segments of its parity block
+	void keep(uint16_t seq_id, ByteSpan data);
+
+	// xor parity over count seq_ids starting at first_seq_id
+	// a single missing segment is rebuilt and added like a received one (and acked)
+	// with more missing, the parity is kept and tried again on add() and keep()
+	// returns the number of rebuilt segments
+	size_t addParity(uint16_t first_seq_id, uint8_t count, uint16_t size_xor, ByteSpan parity);
 
 	bool canPop(void) const;
 
-	std::vector<uint8_t> pop(void);
+	// the returned span points into the buffer, valid until the next add()
+	ByteSpan pop(void);
 
 	// for acking, might be bad since its front
 	std::vector<uint16_t> frontSeqIDs(size_t count = 5) const;
+
+	// fills out with the selective ack bitset of buffered seq_ids after next_seq_id
+	// (bit i is next_seq_id+1+i, low to high)
+	// returns number of bytes used, trailing zero bytes are omitted
+	size_t sackBitset(uint8_t* out, size_t out_size) const;
+
+	private:
+		struct Parity {
+			uint16_t first_seq_id;
+			uint8_t count;
+			uint16_t size_xor;
+			std::vector<uint8_t> data;
+		};
+		std::vector<Parity> _pending_parity; // oldest first
+		std::vector<uint8_t> _rebuild_scratch;
+
+		enum class ParityResult {
+			DONE, // nothing (more) to gain from it
+			REBUILT,
+			PENDING, // more than one missing
+		};
+		ParityResult tryParity(const Parity& parity);
+		// returns the number of rebuilt segments
+		size_t retryPendingParity(void);
+
+		// data of seq_id, if its slot still holds it (buffered or kept)
+		bool hasData(uint16_t seq_id) const;
+
+		// copies the data into the ring, no checks
+		void insert(uint16_t seq_id, ByteSpan data);
+
+		void addAck(uint16_t seq_id);
+
+		bool isPresent(uint16_t seq) const;
+		void setPresent(uint16_t seq, bool value);
+
+		// rebuilds the ring with at least capacity entries and stride
+		void grow(size_t new_capacity, size_t new_stride);
 };
 
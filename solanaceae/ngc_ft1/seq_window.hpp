@@ -0,0 +1,8 @@
+#pragma once
+
+#include <cstddef>
+
+// max seq_ids from the oldest unacked to the newest sent segment of a transfer
+// the sender never opens more (SendSequenceBuffer::max_window) and the receiver buffers and acks
+// all of it (RecvSequenceBuffer::ACCEPT_WINDOW), so a loss at the head never gets the rest of the window dropped
+static constexpr size_t ft1_seq_window {4096};
@@ -1,16 +1,141 @@
 #include "./snd_buf.hpp"
 
+#include <algorithm>
+#include <cstring>
+#include <cassert>
+
+bool SendSequenceBuffer::inWindow(uint16_t seq) const {
+	return uint16_t(seq - first_seq_id) < uint16_t(next_seq_id - first_seq_id);
+}
+
+static constexpr size_t min_capacity {64};
+
+void SendSequenceBuffer::grow(size_t new_capacity, size_t new_stride) {
+	size_t capacity = std::max<size_t>(entries.size(), min_capacity);
+	while (capacity < new_capacity) {
+		capacity *= 2;
+	}
+
+	rebuild(capacity, std::max(new_stride, stride));
+}
+
+void SendSequenceBuffer::maybeShrink(void) {
+	// halve while the span only uses a quarter, so it does not flip flop
+	const size_t span = uint16_t(next_seq_id - first_seq_id);
+	size_t capacity = entries.size();
+	while (capacity > min_capacity && span*4 <= capacity) {
+		capacity /= 2;
+	}
+
+	if (capacity != entries.size()) {
+		rebuild(capacity, stride);
+	}
+}
+
+void SendSequenceBuffer::rebuild(size_t capacity, size_t new_stride) {
+	std::vector<SSBEntry> new_entries(capacity);
+	std::vector<uint8_t> new_slab(capacity * new_stride);
+
+	if (!entries.empty()) {
+		const size_t old_mask = entries.size() - 1;
+		const size_t new_mask = capacity - 1;
+		for (uint16_t seq = first_seq_id; seq != next_seq_id; seq++) {
+			const auto& entry = entries[seq & old_mask];
+			if (!entry.used) {
+				continue;
+			}
+			new_entries[seq & new_mask] = entry;
+			std::memcpy(new_slab.data() + (seq & new_mask) * new_stride, slab.data() + (seq & old_mask) * stride, entry.data_size);
+		}
+	}
+
+	entries = std::move(new_entries);
+	slab = std::move(new_slab);
+	stride = new_stride;
+}
+
 void SendSequenceBuffer::erase(uint16_t seq) {
-	entries.erase(seq);
+	if (!inWindow(seq)) {
+		return; // old or unknown
+	}
+
+	auto& entry = entries[seq & (entries.size() - 1)];
+	if (!entry.used) {
+		return;
+	}
+
+	entry.used = false;
+	used_count--;
+
+	// move the window start past acked entries
+	if (seq == first_seq_id) {
+		while (first_seq_id != next_seq_id && !entries[first_seq_id & (entries.size() - 1)].used) {
+			first_seq_id++;
+		}
+
+		maybeShrink();
+	}
 }
 
 // inflight chunks
 size_t SendSequenceBuffer::size(void) const {
-	return entries.size();
+	return used_count;
+}
+
+bool SendSequenceBuffer::full(void) const {
+	return uint16_t(next_seq_id - first_seq_id) >= max_window;
 }
 
-uint16_t SendSequenceBuffer::add(std::vector<uint8_t>&& data) {
-	entries[next_seq_id] = {data, 0.f};
+uint16_t SendSequenceBuffer::add(size_t data_size) {
+	assert(!full());
+	assert(data_size <= 0xffff);
+
+	const size_t window = uint16_t(next_seq_id - first_seq_id) + 1u;
+	if (window > entries.size() || data_size > stride) {
+		grow(window, data_size);
+	}
+
+	auto& entry = entries[next_seq_id & (entries.size() - 1)];
+	assert(!entry.used);
+	entry.data_size = data_size;
+	entry.used = true;
+	used_count++;
+
 	return next_seq_id++;
 }
 
+void SendSequenceBuffer::eraseLast(size_t count) {
+	for (; count > 0; count--) {
+		assert(next_seq_id != first_seq_id);
+		next_seq_id--;
+
+		auto& entry = entries[next_seq_id & (entries.size() - 1)];
+		if (entry.used) {
+			entry.used = false;
+			used_count--;
+		}
+	}
+
+	// the remaining might all be acked already
+	while (first_seq_id != next_seq_id && !entries[first_seq_id & (entries.size() - 1)].used) {
+		first_seq_id++;
+	}
+
+	maybeShrink();
+}
+
+bool SendSequenceBuffer::has(uint16_t seq) const {
+	return inWindow(seq) && entries[seq & (entries.size() - 1)].used;
+}
+
+uint8_t* SendSequenceBuffer::data(uint16_t seq) {
+	assert(has(seq));
+	return slab.data() + (seq & (entries.size() - 1)) * stride;
+}
+
+ByteSpan SendSequenceBuffer::get(uint16_t seq) const {
+	assert(has(seq));
+	const size_t slot = seq & (entries.size() - 1);
+	return ByteSpan{slab.data() + slot * stride, entries[slot].data_size};
+}
+
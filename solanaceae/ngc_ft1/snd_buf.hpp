@@ -1,19 +1,30 @@
 #pragma once
 
+#include <solanaceae/util/span.hpp>
+
+#include "./seq_window.hpp"
+
 #include <vector>
-#include <map>
 #include <cstdint>
 #include <cstddef>
 
+// ring of in-flight segments, indexed by seq_id % capacity
+// the data lives in a single slab with a fixed stride per entry
 struct SendSequenceBuffer {
 	struct SSBEntry {
-		std::vector<uint8_t> data; // the data (variable size, but smaller than 500)
-		float time_since_activity {0.f};
+		uint16_t data_size {0};
+		bool used {false};
 	};
 
-	// sequence_id -> entry
-	std::map<uint16_t, SSBEntry> entries;
+	// size is always a power of 2 (or 0)
+	std::vector<SSBEntry> entries;
+	std::vector<uint8_t> slab;
+	size_t stride {0}; // largest segment seen
 
+	size_t used_count {0};
+
+	// oldest seq_id still in the ring (might be unused if empty)
+	uint16_t first_seq_id {0};
 	uint16_t next_seq_id {0};
 
 	void erase(uint16_t seq);
@@ -21,13 +32,53 @@ struct SendSequenceBuffer {
 	// inflight chunks
 	size_t size(void) const;
 
-	uint16_t add(std::vector<uint8_t>&& data);
+	// the ring covers first_seq_id (oldest unacked) to next_seq_id, not just the used entries,
+	// so a single lost segment would make it grow with everything sent after it.
+	// this caps that span, and with it the memory, per transfer
+	// never more than the receiver accepts
+	static constexpr size_t max_window {ft1_seq_window};
+
+	// no more seq_ids available, until the oldest gets acked
+	bool full(void) const;
+
+	// allocates a new entry with data_size bytes, fill using data()
+	// invalidates pointers into the slab
+	uint16_t add(size_t data_size);
+
+	// undo the last count add()s
+	void eraseLast(size_t count);
+
+	bool has(uint16_t seq) const;
 
+	uint8_t* data(uint16_t seq);
+	ByteSpan get(uint16_t seq) const;
+
+	// fn is void(uint16_t seq, ByteSpan data)
 	template<typename FN>
-	void for_each(float time_delta, FN&& fn) {
-		for (auto& [id, entry] : entries) {
-			fn(id, entry.data, entry.time_since_activity);
+	void for_each(FN&& fn) {
+		if (entries.empty()) {
+			return;
+		}
+
+		const size_t mask = entries.size() - 1;
+		for (uint16_t seq = first_seq_id; seq != next_seq_id; seq++) {
+			auto& entry = entries[seq & mask];
+			if (!entry.used) {
+				continue;
+			}
+			fn(seq, ByteSpan{slab.data() + (seq & mask) * stride, entry.data_size});
 		}
 	}
+
+	private:
+		bool inWindow(uint16_t seq) const;
+
+		// rebuilds the ring with at least capacity entries and stride
+		void grow(size_t new_capacity, size_t new_stride);
+
+		// gives back memory once the span collapsed again
+		void maybeShrink(void);
+
+		void rebuild(size_t capacity, size_t new_stride);
 };
 
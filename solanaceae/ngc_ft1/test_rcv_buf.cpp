@@ -0,0 +1,224 @@
+// reordering and acking of RecvSequenceBuffer, against what a SendSequenceBuffer can have in flight,
+// and the xor parity (fec) rebuild
+
+#include "./rcv_buf.hpp"
+#include "./snd_buf.hpp"
+
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static void fillSegment(uint8_t* data, size_t size, uint16_t seq_id) {
+	for (size_t i = 0; i < size; i++) {
+		data[i] = uint8_t(seq_id * 7 + i);
+	}
+}
+
+static bool checkSegment(ByteSpan data, size_t size, uint16_t seq_id) {
+	if (data.size != size) {
+		return false;
+	}
+	for (size_t i = 0; i < size; i++) {
+		if (data[i] != uint8_t(seq_id * 7 + i)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// what NGCFT1 sends as FT1_DATA_FEC for a block
+struct TestParity {
+	uint16_t first_seq_id {0};
+	uint8_t count {0};
+	uint16_t size_xor {0};
+	std::vector<uint8_t> data;
+};
+
+static TestParity makeParity(const std::vector<std::vector<uint8_t>>& segments, uint16_t first_seq_id, size_t count) {
+	TestParity parity;
+	parity.first_seq_id = first_seq_id;
+	parity.count = count;
+	for (size_t i = 0; i < count; i++) {
+		const auto& seg = segments.at(uint16_t(first_seq_id + i));
+		if (parity.data.size() < seg.size()) {
+			parity.data.resize(seg.size(), 0u);
+		}
+		for (size_t j = 0; j < seg.size(); j++) {
+			parity.data[j] ^= seg[j];
+		}
+		parity.size_xor ^= seg.size();
+	}
+	return parity;
+}
+
+// the receive side of NGCFT1 with fec, hands out in order data into delivered
+static void receive(RecvSequenceBuffer& rsb, uint16_t seq_id, const std::vector<uint8_t>& data, std::vector<std::vector<uint8_t>>& delivered) {
+	if (rsb.addInOrder(seq_id)) {
+		delivered.push_back(data);
+		rsb.keep(seq_id, ByteSpan{data});
+	} else {
+		rsb.add(seq_id, ByteSpan{data});
+	}
+
+	while (rsb.canPop()) {
+		const ByteSpan pkg = rsb.pop();
+		delivered.emplace_back(pkg.ptr, pkg.ptr + pkg.size);
+	}
+}
+
+static void receiveParity(RecvSequenceBuffer& rsb, const TestParity& parity, std::vector<std::vector<uint8_t>>& delivered) {
+	rsb.addParity(parity.first_seq_id, parity.count, parity.size_xor, ByteSpan{parity.data});
+
+	while (rsb.canPop()) {
+		const ByteSpan pkg = rsb.pop();
+		delivered.emplace_back(pkg.ptr, pkg.ptr + pkg.size);
+	}
+}
+
+int main(void) {
+	size_t failed {0};
+	const auto check = [&failed](bool ok, const std::string& what) {
+		if (!ok) {
+			std::cerr << "FAIL " << what << "\n";
+			failed++;
+		}
+	};
+
+	static_assert(SendSequenceBuffer::max_window <= RecvSequenceBuffer::ACCEPT_WINDOW);
+
+	{ // loss at the head of a full window
+		constexpr size_t segment_size {100};
+
+		SendSequenceBuffer ssb;
+		RecvSequenceBuffer rsb;
+
+		// start close to the wrap around
+		ssb.first_seq_id = ssb.next_seq_id = 0xff00;
+		rsb.next_seq_id = 0xff00;
+
+		std::vector<uint16_t> sent;
+		while (!ssb.full()) {
+			const uint16_t seq_id = ssb.add(segment_size);
+			fillSegment(ssb.data(seq_id), segment_size, seq_id);
+			sent.push_back(seq_id);
+		}
+		check(sent.size() == SendSequenceBuffer::max_window, "sender window is full");
+
+		// the first one is lost, everything else arrives
+		for (size_t i = 1; i < sent.size(); i++) {
+			check(!rsb.addInOrder(sent[i]), "out of order");
+			rsb.add(sent[i], ssb.get(sent[i]));
+		}
+		check(rsb.size() == sent.size() - 1, "whole window buffered");
+		check(!rsb.canPop(), "hole at the head");
+		check(rsb.ack_seq_ids.back() == sent.back(), "last one acked");
+
+		{ // everything after the hole shows up in the sack
+			std::vector<uint8_t> bitset(ft1_seq_window/8);
+			const size_t used = rsb.sackBitset(bitset.data(), bitset.size());
+			size_t acked {0};
+			for (size_t i = 0; i < used*8; i++) {
+				if (bitset[i/8] & (1u << (i%8))) {
+					acked++;
+				}
+			}
+			check(acked == sent.size() - 1, "sack covers the window");
+		}
+
+		// the resend of the head
+		check(rsb.addInOrder(sent.front()), "head in order");
+		check(checkSegment(ssb.get(sent.front()), segment_size, sent.front()), "head data");
+
+		size_t popped {0};
+		while (rsb.canPop()) {
+			const uint16_t seq_id = rsb.next_seq_id;
+			check(checkSegment(rsb.pop(), segment_size, seq_id), "popped data " + std::to_string(seq_id));
+			popped++;
+		}
+		check(popped == sent.size() - 1, "popped the rest");
+		check(rsb.size() == 0, "empty after");
+		check(rsb.next_seq_id == ssb.next_seq_id, "caught up with the sender");
+	}
+
+	{ // beyond the window is dropped and not acked
+		RecvSequenceBuffer rsb;
+		const uint8_t data[10] {};
+		rsb.add(uint16_t(RecvSequenceBuffer::ACCEPT_WINDOW), ByteSpan{data, sizeof(data)});
+		check(rsb.size() == 0, "dropped");
+		check(rsb.ack_seq_ids.empty(), "not acked");
+	}
+
+	// segments of different sizes, the last of every block is shorter
+	constexpr size_t fec_block_size {4};
+	std::vector<std::vector<uint8_t>> segments;
+	for (size_t i = 0; i < 8*fec_block_size; i++) {
+		segments.emplace_back((i % fec_block_size == fec_block_size-1) ? 37 + i : 100);
+		fillSegment(segments.back().data(), segments.back().size(), i);
+	}
+
+	{ // one lost per block, at every position in the block
+		RecvSequenceBuffer rsb;
+		std::vector<std::vector<uint8_t>> delivered;
+
+		for (size_t block = 0; block < segments.size()/fec_block_size; block++) {
+			const size_t first = block*fec_block_size;
+			const size_t lost = first + block % fec_block_size;
+			for (size_t i = first; i < first + fec_block_size; i++) {
+				if (i != lost) {
+					receive(rsb, i, segments[i], delivered);
+				}
+			}
+
+			receiveParity(rsb, makeParity(segments, first, fec_block_size), delivered);
+			check(rsb.rebuilt_count == block + 1, "rebuilt block " + std::to_string(block));
+		}
+
+		check(delivered == segments, "rebuilt data");
+		check(rsb.size() == 0, "nothing left buffered");
+	}
+
+	{ // parity before the data
+		RecvSequenceBuffer rsb;
+		std::vector<std::vector<uint8_t>> delivered;
+
+		receiveParity(rsb, makeParity(segments, 0, fec_block_size), delivered);
+		check(rsb.rebuilt_count == 0, "nothing to rebuild yet");
+
+		// 2 is lost
+		receive(rsb, 0, segments[0], delivered);
+		receive(rsb, 1, segments[1], delivered);
+		check(rsb.rebuilt_count == 0, "still 2 missing");
+		receive(rsb, 3, segments[3], delivered);
+		check(rsb.rebuilt_count == 1, "rebuilt once the rest arrived");
+
+		check(delivered == std::vector<std::vector<uint8_t>>(segments.begin(), segments.begin() + fec_block_size), "rebuilt data, parity first");
+
+		// the actual segment arriving late is a dup
+		receive(rsb, 2, segments[2], delivered);
+		check(delivered.size() == fec_block_size, "late original ignored");
+	}
+
+	{ // two lost in a block can not be rebuilt
+		RecvSequenceBuffer rsb;
+		std::vector<std::vector<uint8_t>> delivered;
+
+		receive(rsb, 0, segments[0], delivered);
+		receive(rsb, 3, segments[3], delivered);
+		receiveParity(rsb, makeParity(segments, 0, fec_block_size), delivered);
+		check(rsb.rebuilt_count == 0, "two missing, no rebuild");
+
+		// a resend of one of them completes the block
+		receive(rsb, 1, segments[1], delivered);
+		check(rsb.rebuilt_count == 1, "rebuilt after the resend");
+		check(delivered == std::vector<std::vector<uint8_t>>(segments.begin(), segments.begin() + fec_block_size), "rebuilt data, after resend");
+	}
+
+	if (failed != 0) {
+		std::cerr << failed << " checks failed\n";
+		return 1;
+	}
+
+	std::cout << "all good\n";
+	return 0;
+}
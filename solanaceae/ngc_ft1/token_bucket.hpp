@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <algorithm>
+#include <limits>
+
+// byte based token bucket, used to cap the bandwidth over all peers
+struct TokenBucket {
+	float rate {0.f}; // bytes/sec, 0 means unlimited
+	float burst {0.1f}; // sec, how many seconds worth of tokens can be saved up
+	float tokens {0.f};
+
+	uint64_t bytes_total {0}; // everything that went through
+	uint64_t bytes_denied {0}; // tryConsume() failed
+
+	bool unlimited(void) const {
+		return rate <= 0.f;
+	}
+
+	void setRate(float new_rate) {
+		rate = std::max(new_rate, 0.f);
+		tokens = rate * burst; // start full
+	}
+
+	void update(float time_delta) {
+		if (unlimited()) {
+			return;
+		}
+
+		tokens = std::min(tokens + rate * time_delta, rate * burst);
+	}
+
+	int64_t available(void) const {
+		if (unlimited()) {
+			return std::numeric_limits<int64_t>::max();
+		}
+
+		return static_cast<int64_t>(std::max(tokens, 0.f));
+	}
+
+	void consume(int64_t bytes) {
+		bytes_total += bytes;
+		if (!unlimited()) {
+			tokens -= bytes;
+		}
+	}
+
+	bool tryConsume(int64_t bytes) {
+		if (!unlimited() && tokens < bytes) {
+			bytes_denied += bytes;
+			return false;
+		}
+
+		consume(bytes);
+		return true;
+	}
+};
@@ -73,6 +73,12 @@ void NGCFT1UI::renderTabGroup(ContactHandle4 c) {
 
 	ImGui::Text("active peers: %zu", ft_group.peers.size());
 
+	{
+		const auto bw_stats = _ft.getBandwidthStats();
+		ImGui::Text("global up: %.1fKiB/s down: %.1fKiB/s (0 is unlimited)", bw_stats.uplink_limit/1024.f, bw_stats.downlink_limit/1024.f);
+		ImGui::Text("sent: %luKiB received: %luKiB dropped: %luKiB", bw_stats.bytes_sent/1024, bw_stats.bytes_received/1024, bw_stats.bytes_dropped/1024);
+	}
+
 	{ // ui here
 		ImGui::SeparatorText("receiving");
 		for (const auto& [peer_number, peer] : ft_group.peers) {
@@ -85,13 +91,8 @@ void NGCFT1UI::renderTabGroup(ContactHandle4 c) {
 			ImGui::Text("peer %u (%s)", peer_number, peer_name);
 			ImGui::Indent();
 
-			for (size_t i = 0; i < peer.recv_transfers.size(); i++) {
-				const auto& transfer_opt = peer.recv_transfers.at(i);
-				if (!transfer_opt.has_value()) {
-					continue;
-				}
-
-				const auto& transfer = transfer_opt.value();
+			for (const auto& [transfer_id, transfer] : peer.recv_transfers) {
+				const size_t i = transfer_id;
 
 				const bool color_red = transfer.timer > 1.5f && transfer.state != NGCFT1::Group::Peer::RecvTransfer::State::FINISHING;
 				const bool color_yellow = transfer.state == NGCFT1::Group::Peer::RecvTransfer::State::FINISHING;
@@ -110,7 +111,10 @@ void NGCFT1UI::renderTabGroup(ContactHandle4 c) {
 					transfer.timer
 				);
 
-				//transfer.rsb.
+				if (transfer.fec) {
+					ImGui::SameLine();
+					ImGui::Text("fec rebuilt: %zu", transfer.rsb.rebuilt_count);
+				}
 
 				if (color_red || color_yellow) {
 					ImGui::PopStyleColor();
@@ -133,6 +137,23 @@ void NGCFT1UI::renderTabGroup(ContactHandle4 c) {
 
 			const auto* cca = peer.cca.get();
 			if (cca) {
+				const bool cca_auto = _ft.resolveCCAType(ft_group, peer) == CCAType::AUTO;
+				ImGui::Text("cca: %s%s switches: %zu", to_string(peer.cca_active), cca_auto ? " (auto)" : "", peer.cca_switch_count);
+				if (!peer.cca_switch_events.empty() && ImGui::TreeNode("cca switches")) {
+					for (const auto& it : peer.cca_switch_events) {
+						ImGui::Text("%s -> %s (%s) rtt: %.3f qd: %.3f", to_string(it.from), to_string(it.to), it.reason, it.rtt, it.queue_delay);
+					}
+					ImGui::TreePop();
+				}
+
+				ImGui::Text("loss: %.3f", cca->getLossRate());
+				ImGui::Text("segment size: %u (max %u) probing: %u black holes: %zu",
+					peer.mtu.confirmed,
+					peer.mtu.negotiated_max,
+					peer.mtu.probe_size,
+					peer.mtu.black_holes
+				);
+
 				// TODO: human readable bytes
 				// TODO: graphs
 				ImGui::Text("cca: iFB: %ld iFC: %ld rtt: %.3f window: %.1f w/d: %.3fKiB/s",
@@ -149,12 +170,8 @@ void NGCFT1UI::renderTabGroup(ContactHandle4 c) {
 
 			ImGui::Text("transfers:");
 			ImGui::Indent();
-			for (size_t i = 0; i < peer.send_transfers.size(); i++) {
-				const auto& transfer_opt = peer.send_transfers.at(i);
-				if (!transfer_opt.has_value()) {
-					continue;
-				}
-				const auto& transfer = transfer_opt.value();
+			for (const auto& [transfer_id, transfer] : peer.send_transfers) {
+				const size_t i = transfer_id;
 
 				const bool color_red = transfer.time_since_activity > 1.5f && transfer.state != NGCFT1::Group::Peer::SendTransfer::State::FINISHING;
 				const bool color_yellow = transfer.state == NGCFT1::Group::Peer::SendTransfer::State::FINISHING;
@@ -0,0 +1,79 @@
+#include "./worker_pool.hpp"
+
+WorkerPool::WorkerPool(size_t size) {
+	for (size_t i = 1; i < size; i++) {
+		_threads.emplace_back(&WorkerPool::workerMain, this, i);
+	}
+}
+
+WorkerPool::~WorkerPool(void) {
+	{
+		std::lock_guard lg{_mutex};
+		_quit = true;
+	}
+	_cv_work.notify_all();
+
+	for (auto& t : _threads) {
+		t.join();
+	}
+}
+
+void WorkerPool::parallelFor(size_t count, const FN& fn) {
+	if (count == 0) {
+		return;
+	}
+
+	// not worth waking anyone
+	if (_threads.empty() || count == 1) {
+		for (size_t i = 0; i < count; i++) {
+			fn(0, i);
+		}
+		return;
+	}
+
+	{
+		std::lock_guard lg{_mutex};
+		_fn = &fn;
+		_count = count;
+		_next.store(0, std::memory_order_relaxed);
+		_threads_busy = _threads.size();
+		_generation++;
+	}
+	_cv_work.notify_all();
+
+	work(0);
+
+	// everything the workers wrote is visible after this
+	std::unique_lock lk{_mutex};
+	_cv_done.wait(lk, [this]() { return _threads_busy == 0; });
+	_fn = nullptr;
+}
+
+void WorkerPool::workerMain(size_t worker) {
+	uint64_t generation {0};
+
+	std::unique_lock lk{_mutex};
+	while (true) {
+		_cv_work.wait(lk, [&]() { return _quit || _generation != generation; });
+		if (_quit) {
+			return;
+		}
+		generation = _generation;
+
+		lk.unlock();
+		work(worker);
+		lk.lock();
+
+		_threads_busy--;
+		if (_threads_busy == 0) {
+			_cv_done.notify_one();
+		}
+	}
+}
+
+void WorkerPool::work(size_t worker) {
+	for (size_t i = _next.fetch_add(1, std::memory_order_relaxed); i < _count; i = _next.fetch_add(1, std::memory_order_relaxed)) {
+		(*_fn)(worker, i);
+	}
+}
+
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// fixed set of threads for fork-join style loops
+// the calling thread does its share too, so a pool of size 1 has no extra threads
+struct WorkerPool {
+	using FN = std::function<void(size_t worker, size_t i)>;
+
+	std::vector<std::thread> _threads;
+
+	std::mutex _mutex;
+	std::condition_variable _cv_work;
+	std::condition_variable _cv_done;
+
+	// current loop, set while parallelFor() runs
+	const FN* _fn {nullptr};
+	size_t _count {0};
+	std::atomic_size_t _next {0}; // next i to hand out
+	size_t _threads_busy {0};
+	uint64_t _generation {0}; // bumped for every loop
+	bool _quit {false};
+
+	explicit WorkerPool(size_t size);
+	~WorkerPool(void);
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	// including the calling thread
+	size_t size(void) const { return _threads.size() + 1; }
+
+	// calls fn(worker, i) for every i in [0, count), each i exactly once
+	// the i are handed out one by one, so uneven work balances out
+	// worker is in [0, size()), 0 is the calling thread, use it to index per worker scratch space
+	// blocks until all are done
+	void parallelFor(size_t count, const FN& fn);
+
+	void workerMain(size_t worker);
+	void work(size_t worker);
+};
+
@@ -0,0 +1,137 @@
+#include "./zstd_stream.hpp"
+
+#include <zstd.h>
+
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <cassert>
+
+ZstdStreamCompressor::ZstdStreamCompressor(int level, ByteSpan dict) {
+	_cctx = ZSTD_createCCtx();
+	assert(_cctx != nullptr);
+
+	ZSTD_CCtx_setParameter(_cctx, ZSTD_c_compressionLevel, level);
+	ZSTD_CCtx_setParameter(_cctx, ZSTD_c_windowLog, ZstdStreamCompressor::WINDOW_LOG);
+	// cheap, and catches a mismatching dict on the other side
+	ZSTD_CCtx_setParameter(_cctx, ZSTD_c_checksumFlag, 1);
+
+	if (dict.size > 0) {
+		ZSTD_CCtx_loadDictionary(_cctx, dict.ptr, dict.size);
+	}
+}
+
+ZstdStreamCompressor::~ZstdStreamCompressor(void) {
+	ZSTD_freeCCtx(_cctx);
+}
+
+bool ZstdStreamCompressor::feed(ByteSpan data, bool last) {
+	assert(!_ended);
+
+	// drop what was read already
+	if (_out_pos > 0) {
+		_out.erase(_out.begin(), _out.begin() + _out_pos);
+		_out_pos = 0;
+	}
+
+	ZSTD_inBuffer in{data.ptr, data.size, 0};
+	const ZSTD_EndDirective mode = last ? ZSTD_e_end : ZSTD_e_continue;
+	const size_t out_chunk_size = ZSTD_CStreamOutSize();
+	while (true) {
+		const size_t offset = _out.size();
+		_out.resize(offset + out_chunk_size);
+		ZSTD_outBuffer out{_out.data() + offset, out_chunk_size, 0};
+
+		const size_t remaining = ZSTD_compressStream2(_cctx, &out, &in, mode);
+		_out.resize(offset + out.pos);
+
+		if (ZSTD_isError(remaining)) {
+			std::cerr << "ZSTD error: compress: " << ZSTD_getErrorName(remaining) << "\n";
+			return false;
+		}
+
+		// end has to be fully flushed, continue only needs the input consumed
+		if (last ? remaining == 0 : in.pos == in.size) {
+			break;
+		}
+	}
+
+	_ended = last;
+	return true;
+}
+
+size_t ZstdStreamCompressor::read(uint8_t* dst, size_t size) {
+	size = std::min(size, available());
+	std::memcpy(dst, _out.data() + _out_pos, size);
+	_out_pos += size;
+	return size;
+}
+
+ZstdStreamDecompressor::ZstdStreamDecompressor(ByteSpan dict) {
+	_dctx = ZSTD_createDCtx();
+	assert(_dctx != nullptr);
+
+	// refuse frames that would need more memory
+	ZSTD_DCtx_setParameter(_dctx, ZSTD_d_windowLogMax, ZstdStreamCompressor::WINDOW_LOG);
+
+	if (dict.size > 0) {
+		ZSTD_DCtx_loadDictionary(_dctx, dict.ptr, dict.size);
+	}
+}
+
+ZstdStreamDecompressor::~ZstdStreamDecompressor(void) {
+	ZSTD_freeDCtx(_dctx);
+}
+
+bool ZstdStreamDecompressor::feed(ByteSpan data, size_t max_output) {
+	_out.clear();
+
+	if (_ended) {
+		if (data.size > 0) {
+			std::cerr << "ZSTD error: data after the end of the frame\n";
+			return false;
+		}
+		return true;
+	}
+
+	ZSTD_inBuffer in{data.ptr, data.size, 0};
+	const size_t out_chunk_size = ZSTD_DStreamOutSize();
+	while (true) {
+		const size_t offset = _out.size();
+		// room for one byte past the limit, to tell reaching it from going over it
+		const size_t room = max_output - offset;
+		const size_t chunk_size = room < out_chunk_size ? room + 1 : out_chunk_size;
+		_out.resize(offset + chunk_size);
+		ZSTD_outBuffer out{_out.data() + offset, chunk_size, 0};
+
+		const size_t ret = ZSTD_decompressStream(_dctx, &out, &in);
+		_out.resize(offset + out.pos);
+
+		if (ZSTD_isError(ret)) {
+			std::cerr << "ZSTD error: decompress: " << ZSTD_getErrorName(ret) << "\n";
+			return false;
+		}
+
+		if (_out.size() > max_output) {
+			std::cerr << "ZSTD error: decompressed more than the max of " << max_output << " bytes\n";
+			return false;
+		}
+
+		if (ret == 0) {
+			_ended = true;
+			if (in.pos != in.size) {
+				std::cerr << "ZSTD error: data after the end of the frame\n";
+				return false;
+			}
+			break;
+		}
+
+		// a full output buffer might mean there is more to flush
+		if (in.pos == in.size && out.pos < out.size) {
+			break;
+		}
+	}
+
+	return true;
+}
+
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <solanaceae/util/span.hpp>
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// keep zstd.h out of the headers
+struct ZSTD_CCtx_s;
+struct ZSTD_DCtx_s;
+
+// streaming zstd over a single transfer, one frame for the whole file
+// the window is bounded, so is the memory on both sides
+struct ZstdStreamCompressor {
+	static constexpr int WINDOW_LOG {17}; // 128KiB, the decompressor refuses more
+
+	ZSTD_CCtx_s* _cctx {nullptr};
+
+	std::vector<uint8_t> _out; // compressed, not yet read
+	size_t _out_pos {0};
+	bool _ended {false};
+
+	// dict can be empty, it is copied
+	ZstdStreamCompressor(int level, ByteSpan dict = {});
+	~ZstdStreamCompressor(void);
+	ZstdStreamCompressor(const ZstdStreamCompressor&) = delete;
+	ZstdStreamCompressor& operator=(const ZstdStreamCompressor&) = delete;
+
+	// compresses data, last ends the frame
+	bool feed(ByteSpan data, bool last);
+
+	// compressed bytes ready to be read
+	size_t available(void) const { return _out.size() - _out_pos; }
+
+	// copies up to size compressed bytes, returns how many
+	// read data can not be put back
+	size_t read(uint8_t* dst, size_t size);
+
+	// input ended and everything read
+	bool done(void) const { return _ended && available() == 0; }
+};
+
+struct ZstdStreamDecompressor {
+	ZSTD_DCtx_s* _dctx {nullptr};
+
+	std::vector<uint8_t> _out; // decompressed by the last feed()
+	bool _ended {false};
+
+	// needs the same dict as the compressor
+	ZstdStreamDecompressor(ByteSpan dict = {});
+	~ZstdStreamDecompressor(void);
+	ZstdStreamDecompressor(const ZstdStreamDecompressor&) = delete;
+	ZstdStreamDecompressor& operator=(const ZstdStreamDecompressor&) = delete;
+
+	// feed compressed data in stream order
+	// false on corrupt data, a too big window, data after the end of the frame
+	// or if it decompresses to more than max_output bytes (stops there, a tiny segment can expand a lot)
+	bool feed(ByteSpan data, size_t max_output);
+
+	// what the last feed() decompressed, valid until the next feed()
+	ByteSpan output(void) const { return ByteSpan{_out.data(), _out.size()}; }
+
+	// the frame ended
+	bool done(void) const { return _ended; }
+};
+
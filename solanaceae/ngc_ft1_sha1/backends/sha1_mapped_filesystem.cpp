@@ -6,11 +6,14 @@
 #include "../file_constructor.hpp"
 #include "../ft1_sha1_info.hpp"
 #include "../hash_utils.hpp"
+#include "../file_hash_cache.hpp"
 #include "../components.hpp"
 
 #include <solanaceae/util/utils.hpp>
+#include <solanaceae/ngc_ft1/worker_pool.hpp>
 
 #include <atomic>
+#include <algorithm>
 #include <mutex>
 #include <list>
 #include <thread>
@@ -24,6 +27,15 @@ struct SHA1MappedFilesystem_InfoBuilderState {
 	std::mutex info_builder_queue_mutex;
 	using InfoBuilderEntry = std::function<void(float)>;
 	std::list<InfoBuilderEntry> info_builder_queue;
+
+	// chunk hashing, files take turns using all of it
+	std::mutex hash_pool_mutex;
+	size_t hash_threads {0}; // 0 is one per core
+	std::unique_ptr<WorkerPool> hash_pool; // created on first use
+
+	// chunk hashes of files shared before
+	std::mutex hash_cache_mutex;
+	std::unique_ptr<FileHashCache> hash_cache; // disabled if null
 };
 
 SHA1MappedFilesystem::SHA1MappedFilesystem(
@@ -34,6 +46,21 @@ SHA1MappedFilesystem::SHA1MappedFilesystem(
 SHA1MappedFilesystem::~SHA1MappedFilesystem(void) {
 }
 
+void SHA1MappedFilesystem::setHashThreads(size_t threads) {
+	std::lock_guard l{_ibs->hash_pool_mutex};
+	_ibs->hash_threads = threads;
+	_ibs->hash_pool.reset();
+}
+
+void SHA1MappedFilesystem::setHashCachePath(std::string_view path, size_t max_bytes) {
+	std::lock_guard l{_ibs->hash_cache_mutex};
+	if (path.empty()) {
+		_ibs->hash_cache.reset();
+	} else {
+		_ibs->hash_cache = std::make_unique<FileHashCache>(path, max_bytes);
+	}
+}
+
 void SHA1MappedFilesystem::tick(float current_time) {
 	if (_ibs->info_builder_dirty) {
 		std::lock_guard l{_ibs->info_builder_queue_mutex};
@@ -97,17 +124,47 @@ void SHA1MappedFilesystem::newFromFile(std::string_view file_name, std::string_v
 			assert(sha1_info.chunk_size <= cs_high);
 		}
 
-		{ // build chunks
-			// HACK: load file fully
-			// ... its only a hack if its not memory mapped, but reading in chunk_sized chunks is probably a good idea anyway
-			const auto file_data = file_impl->read(file_impl->_file_size, 0);
-			size_t i = 0;
-			for (; i + sha1_info.chunk_size < file_data.size; i += sha1_info.chunk_size) {
-				sha1_info.chunks.push_back(hash_sha1(file_data.ptr+i, sha1_info.chunk_size));
+		// same file as last time, skip hashing
+		FileHashCache::Key cache_key;
+		const bool cache_key_good = FileHashCache::keyFromFile(file_path_, cache_key) && cache_key.size == sha1_info.file_size;
+		bool from_cache {false};
+		if (cache_key_good) {
+			std::lock_guard l{ibs->hash_cache_mutex};
+			if (ibs->hash_cache) {
+				const auto* entry = ibs->hash_cache->get(cache_key);
+				if (entry != nullptr && entry->chunk_size == sha1_info.chunk_size) {
+					sha1_info.chunks = entry->chunks;
+					from_cache = true;
+				}
 			}
+		}
 
-			if (i < file_data.size) {
-				sha1_info.chunks.push_back(hash_sha1(file_data.ptr+i, file_data.size-i));
+		if (!from_cache) { // build chunks
+			{
+				// HACK: load file fully
+				// ... its only a hack if its not memory mapped, but reading in chunk_sized chunks is probably a good idea anyway
+				const auto file_data = file_impl->read(file_impl->_file_size, 0);
+
+				std::lock_guard l{ibs->hash_pool_mutex};
+				if (!ibs->hash_pool) {
+					const size_t threads = ibs->hash_threads != 0 ? ibs->hash_threads : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+					ibs->hash_pool = std::make_unique<WorkerPool>(threads);
+				}
+				hash_sha1_chunks(file_data.ptr, file_data.size, sha1_info.chunk_size, sha1_info.chunks, ibs->hash_pool.get());
+			}
+
+			// only if the file did not change while hashing
+			FileHashCache::Key cache_key_after;
+			if (
+				cache_key_good &&
+				FileHashCache::keyFromFile(file_path_, cache_key_after) &&
+				cache_key_after == cache_key &&
+				FileHashCache::keyIsStable(cache_key)
+			) {
+				std::lock_guard l{ibs->hash_cache_mutex};
+				if (ibs->hash_cache) {
+					ibs->hash_cache->put(cache_key, sha1_info.chunk_size, sha1_info.chunks);
+				}
 			}
 		}
 
@@ -20,6 +20,13 @@ struct SHA1MappedFilesystem : public StorageBackendIMeta, public StorageBackendI
 	);
 	~SHA1MappedFilesystem(void);
 
+	// threads hashing the chunks in newFromFile(), 0 for one per core (default)
+	void setHashThreads(size_t threads);
+
+	// persist chunk hashes of shared files in this file, so sharing them again skips hashing
+	// empty path disables it (default)
+	void setHashCachePath(std::string_view path, size_t max_bytes = 16*1024*1024);
+
 	// pull from info builder queue
 	// call from main thread (os thread?) often
 	void tick(float current_time);
@@ -0,0 +1,64 @@
+// chunk hashing throughput over the number of threads, like SHA1MappedFilesystem::newFromFile()
+// usage: bench_hash_chunks [size_mib] [max_threads]
+
+#include "./hash_utils.hpp"
+#include "./ft1_sha1_info.hpp"
+
+#include <solanaceae/ngc_ft1/worker_pool.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+int main(int argc, char** argv) {
+	size_t size_mib {512};
+	size_t max_threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+	if (argc > 1) {
+		size_mib = std::max<size_t>(std::stoul(argv[1]), 1);
+	}
+	if (argc > 2) {
+		max_threads = std::max<size_t>(std::stoul(argv[2]), 1);
+	}
+
+	std::vector<uint8_t> data(size_mib*1024*1024);
+	for (size_t i = 0; i < data.size(); i++) {
+		data[i] = (i * 2654435761u) >> 24;
+	}
+	const uint32_t chunk_size = chunkSizeFromFileSize(data.size());
+
+	std::cout << "size: " << size_mib << "MiB chunk_size: " << chunk_size << "\n";
+	std::cout << "threads\tGiB/s\n";
+
+	std::vector<SHA1Digest> reference;
+	for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+		std::unique_ptr<WorkerPool> pool;
+		if (threads > 1) {
+			pool = std::make_unique<WorkerPool>(threads);
+		}
+
+		// best of 3
+		double best {0.};
+		std::vector<SHA1Digest> chunks;
+		for (size_t run = 0; run < 3; run++) {
+			const auto time_start = std::chrono::steady_clock::now();
+			hash_sha1_chunks(data.data(), data.size(), chunk_size, chunks, pool.get());
+			const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - time_start;
+			best = std::max(best, (data.size() / (1024.*1024.*1024.)) / duration.count());
+		}
+
+		if (reference.empty()) {
+			reference = chunks;
+		} else if (chunks != reference) {
+			std::cerr << "error: hashes differ with " << threads << " threads\n";
+			return 1;
+		}
+
+		std::cout << threads << "\t" << best << "\n";
+	}
+
+	return 0;
+}
+
@@ -0,0 +1,49 @@
+// throughput of every sha1 implementation the cpu supports, single and multi buffer
+// usage: bench_sha1_impls
+
+#include "./sha1_impl.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+int main(void) {
+	constexpr size_t lanes {8};
+	constexpr size_t bytes_per_run {64*1024*1024};
+
+	std::vector<uint8_t> data(lanes * 1024*1024);
+	for (size_t i = 0; i < data.size(); i++) {
+		data[i] = (i * 2654435761u) >> 24;
+	}
+
+	std::cout << "impl\tsize\tsingle(MiB/s)\tmulti x" << lanes << "(MiB/s)\n";
+	for (const auto& impl : sha1ImplsSupported()) {
+		for (const size_t size : {size_t(64), size_t(1024), size_t(32*1024), size_t(1024*1024)}) {
+			const size_t iterations = bytes_per_run / size;
+			uint8_t digests[lanes*20];
+
+			const auto time_single = std::chrono::steady_clock::now();
+			for (size_t i = 0; i < iterations; i++) {
+				sha1_hash(impl, data.data() + (i % lanes) * size, size, digests);
+			}
+			const std::chrono::duration<double> duration_single = std::chrono::steady_clock::now() - time_single;
+
+			const uint8_t* msgs[lanes];
+			for (size_t i = 0; i < lanes; i++) {
+				msgs[i] = data.data() + i*size;
+			}
+
+			const auto time_multi = std::chrono::steady_clock::now();
+			for (size_t i = 0; i < iterations / lanes; i++) {
+				sha1_hash_multi(impl, msgs, size, lanes, digests);
+			}
+			const std::chrono::duration<double> duration_multi = std::chrono::steady_clock::now() - time_multi;
+
+			const double mib = bytes_per_run / (1024.*1024.);
+			std::cout << impl.name << "\t" << size << "\t" << mib / duration_single.count() << "\t" << mib / duration_multi.count() << "\n";
+		}
+	}
+
+	return 0;
+}
+
@@ -0,0 +1,124 @@
+#include "./chunk_verify_queue.hpp"
+
+#include "./sha1_impl.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+struct ChunkVerifyQueue_State {
+	struct Job {
+		std::vector<uint8_t> data;
+		SHA1Digest expected_hash;
+		ChunkVerifyQueue::ResultFN fn;
+	};
+
+	struct Result {
+		bool good {false};
+		SHA1Digest got_hash;
+		ChunkVerifyQueue::ResultFN fn;
+	};
+
+	std::mutex jobs_mutex;
+	std::condition_variable jobs_cv;
+	std::deque<Job> jobs;
+	bool stop {false};
+
+	std::atomic_bool results_dirty {false};
+	std::mutex results_mutex;
+	std::vector<Result> results;
+
+	std::thread worker;
+
+	void run(void);
+};
+
+void ChunkVerifyQueue_State::run(void) {
+	const SHA1Impl& impl = sha1ImplActive();
+
+	// reused
+	std::vector<Job> batch;
+	std::vector<const uint8_t*> batch_data;
+	std::vector<uint8_t> batch_digests;
+
+	while (true) {
+		batch.clear();
+		{
+			std::unique_lock l{jobs_mutex};
+			jobs_cv.wait(l, [this]{ return stop || !jobs.empty(); });
+			if (stop) {
+				return;
+			}
+
+			// the first job and whatever else has the same size, up to a full set of lanes
+			// (same size is the common case, all but the last chunk of a file are)
+			const size_t size = jobs.front().data.size();
+			for (auto it = jobs.begin(); it != jobs.end() && batch.size() < impl.lanes;) {
+				if (batch.empty() || it->data.size() == size) {
+					batch.push_back(std::move(*it));
+					it = jobs.erase(it);
+				} else {
+					it++;
+				}
+			}
+		}
+
+		batch_data.clear();
+		for (const auto& job : batch) {
+			batch_data.push_back(job.data.data());
+		}
+		batch_digests.resize(batch.size()*20);
+
+		sha1_hash_multi(impl, batch_data.data(), batch.front().data.size(), batch.size(), batch_digests.data());
+
+		std::lock_guard l{results_mutex};
+		for (size_t i = 0; i < batch.size(); i++) {
+			SHA1Digest got_hash{batch_digests.data() + i*20, 20};
+			const bool good = got_hash == batch[i].expected_hash;
+			results.push_back({good, got_hash, std::move(batch[i].fn)});
+		}
+		results_dirty = true; // set before mutex unlock
+	}
+}
+
+ChunkVerifyQueue::ChunkVerifyQueue(void) : _state(std::make_unique<ChunkVerifyQueue_State>()) {
+	_state->worker = std::thread([state = _state.get()]() { state->run(); });
+}
+
+ChunkVerifyQueue::~ChunkVerifyQueue(void) {
+	{
+		std::lock_guard l{_state->jobs_mutex};
+		_state->stop = true;
+	}
+	_state->jobs_cv.notify_one();
+	_state->worker.join();
+}
+
+void ChunkVerifyQueue::push(std::vector<uint8_t>&& data, const SHA1Digest& expected_hash, ResultFN&& fn) {
+	{
+		std::lock_guard l{_state->jobs_mutex};
+		_state->jobs.push_back({std::move(data), expected_hash, std::move(fn)});
+	}
+	_state->jobs_cv.notify_one();
+}
+
+void ChunkVerifyQueue::tick(void) {
+	if (!_state->results_dirty) {
+		return;
+	}
+
+	std::vector<ChunkVerifyQueue_State::Result> results;
+	{
+		std::lock_guard l{_state->results_mutex};
+		_state->results_dirty = false; // set while holding lock
+		results.swap(_state->results);
+	}
+
+	// outside the lock, the callbacks might push again
+	for (auto& it : results) {
+		it.fn(it.good, it.got_hash);
+	}
+}
+
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "./ft1_sha1_info.hpp"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+// fwd to hide the threading headers
+struct ChunkVerifyQueue_State;
+
+// checks received chunks against their hash on a worker thread
+// pending chunks of the same size are hashed together (multi buffer sha1, if the cpu has it)
+struct ChunkVerifyQueue {
+	// called from tick(), with the hash the data actually had
+	using ResultFN = std::function<void(bool good, const SHA1Digest& got_hash)>;
+
+	std::unique_ptr<ChunkVerifyQueue_State> _state;
+
+	ChunkVerifyQueue(void);
+	// drops results not yet picked up
+	~ChunkVerifyQueue(void);
+
+	// data needs to be owned, the file might get closed before the worker gets to it
+	void push(std::vector<uint8_t>&& data, const SHA1Digest& expected_hash, ResultFN&& fn);
+
+	// hand out finished results
+	// call from main thread (os thread?) often
+	void tick(void);
+};
+
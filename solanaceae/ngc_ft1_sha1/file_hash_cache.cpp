@@ -0,0 +1,297 @@
+#include "./file_hash_cache.hpp"
+
+#include "./hash_utils.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#if defined(_WIN32)
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#include <windows.h>
+#else
+	#include <sys/stat.h>
+#endif
+
+// file layout, little endian:
+// magic "SFHC", u32 version, u32 entry count
+// per entry: u64 dev, u64 inode, u64 size, i64 mtime_ns, u64 last_used, u32 chunk_size, u32 chunk count, chunk count * 20 bytes
+// 20 bytes sha1 of everything before
+static constexpr uint8_t file_magic[4] {'S', 'F', 'H', 'C'};
+static constexpr uint32_t file_version {1};
+static constexpr size_t file_header_bytes {4+4+4};
+static constexpr size_t file_trailer_bytes {20};
+
+// files changed less than this ago might change again within the mtime granularity
+static constexpr int64_t stable_age_ns {INT64_C(2)*1000*1000*1000};
+
+template<typename T>
+static void writeLE(std::vector<uint8_t>& buffer, T value) {
+	for (size_t i = 0; i < sizeof(T); i++) {
+		buffer.push_back((uint64_t(value) >> (i*8)) & 0xff);
+	}
+}
+
+template<typename T>
+static bool readLE(const std::vector<uint8_t>& buffer, size_t& pos, T& value_out) {
+	if (pos + sizeof(T) > buffer.size()) {
+		return false;
+	}
+
+	uint64_t value {0};
+	for (size_t i = 0; i < sizeof(T); i++) {
+		value |= uint64_t(buffer[pos+i]) << (i*8);
+	}
+	value_out = static_cast<T>(value);
+	pos += sizeof(T);
+	return true;
+}
+
+FileHashCache::FileHashCache(std::string_view path, size_t max_bytes) : _path(path), _max_bytes(max_bytes) {
+}
+
+FileHashCache::~FileHashCache(void) {
+	if (_dirty) {
+		save();
+	}
+}
+
+bool FileHashCache::keyFromFile(std::string_view file_path, Key& key_out) {
+#if defined(_WIN32)
+	// _stat64 has no inode on windows, the volume serial and file index are the equivalent
+	// no access rights needed for the metadata, and it must not get in the way of others using the file
+	const HANDLE file = CreateFileW(
+		std::filesystem::u8path(file_path).c_str(),
+		0,
+		FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		nullptr,
+		OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL,
+		nullptr
+	);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	BY_HANDLE_FILE_INFORMATION info;
+	const bool got_info = GetFileInformationByHandle(file, &info);
+	CloseHandle(file);
+	if (!got_info) {
+		return false;
+	}
+
+	key_out.dev = info.dwVolumeSerialNumber;
+	key_out.inode = (uint64_t(info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+	key_out.size = (uint64_t(info.nFileSizeHigh) << 32) | info.nFileSizeLow;
+	// 100ns ticks since 1601, to ns since the unix epoch like on posix (keyIsStable() compares with the system clock)
+	const int64_t write_time = int64_t((uint64_t(info.ftLastWriteTime.dwHighDateTime) << 32) | info.ftLastWriteTime.dwLowDateTime);
+	key_out.mtime_ns = (write_time - INT64_C(116444736000000000)) * 100;
+
+	return true;
+#else
+	struct stat st;
+	if (::stat(std::string{file_path}.c_str(), &st) != 0) {
+		return false;
+	}
+
+	key_out.dev = st.st_dev;
+	key_out.inode = st.st_ino;
+	key_out.size = st.st_size;
+	#if defined(__APPLE__)
+	key_out.mtime_ns = int64_t(st.st_mtimespec.tv_sec)*1000*1000*1000 + st.st_mtimespec.tv_nsec;
+	#else
+	key_out.mtime_ns = int64_t(st.st_mtim.tv_sec)*1000*1000*1000 + st.st_mtim.tv_nsec;
+	#endif
+
+	return true;
+#endif
+}
+
+bool FileHashCache::keyIsStable(const Key& key) {
+	const int64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::system_clock::now().time_since_epoch()
+	).count();
+
+	return now_ns - key.mtime_ns >= stable_age_ns;
+}
+
+size_t FileHashCache::entryBytes(size_t chunk_count) {
+	return 8+8+8+8+8+4+4 + chunk_count*20;
+}
+
+const FileHashCache::Entry* FileHashCache::get(const Key& key) {
+	load();
+
+	for (auto& it : _entries) {
+		if (it.key == key) {
+			it.last_used = ++_use_counter;
+			// saved with the next put or on destruction, a hit should not cost a write
+			_dirty = true;
+			return &it;
+		}
+	}
+
+	return nullptr;
+}
+
+void FileHashCache::put(const Key& key, uint32_t chunk_size, const std::vector<SHA1Digest>& chunks) {
+	load();
+
+	if (file_header_bytes + entryBytes(chunks.size()) + file_trailer_bytes > _max_bytes) {
+		return; // would never fit
+	}
+
+	// replace
+	for (auto it = _entries.begin(); it != _entries.end(); it++) {
+		if (it->key == key) {
+			_bytes -= entryBytes(it->chunks.size());
+			_entries.erase(it);
+			break;
+		}
+	}
+
+	// evict
+	while (!_entries.empty() && file_header_bytes + _bytes + entryBytes(chunks.size()) + file_trailer_bytes > _max_bytes) {
+		auto lru_it = std::min_element(_entries.begin(), _entries.end(), [](const Entry& a, const Entry& b) {
+			return a.last_used < b.last_used;
+		});
+		_bytes -= entryBytes(lru_it->chunks.size());
+		_entries.erase(lru_it);
+	}
+
+	_entries.push_back({key, ++_use_counter, chunk_size, chunks});
+	_bytes += entryBytes(chunks.size());
+
+	_dirty = !save();
+}
+
+void FileHashCache::load(void) {
+	if (_loaded) {
+		return;
+	}
+	_loaded = true;
+
+	std::ifstream file(std::filesystem::u8path(_path), std::ios::binary);
+	if (!file.is_open()) {
+		return; // no cache yet
+	}
+
+	const std::vector<uint8_t> buffer{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+
+	if (buffer.size() < file_header_bytes + file_trailer_bytes || std::memcmp(buffer.data(), file_magic, sizeof(file_magic)) != 0) {
+		std::cerr << "FileHashCache warning: '" << _path << "' is not a hash cache, ignoring\n";
+		return;
+	}
+
+	{ // integrity
+		const size_t body_size = buffer.size() - file_trailer_bytes;
+		const auto hash = hash_sha1(buffer.data(), body_size);
+		if (!std::equal(hash.cbegin(), hash.cend(), buffer.cbegin() + body_size)) {
+			std::cerr << "FileHashCache warning: '" << _path << "' is corrupt, ignoring\n";
+			return;
+		}
+	}
+
+	size_t pos {sizeof(file_magic)};
+	uint32_t version {0};
+	uint32_t entry_count {0};
+	readLE(buffer, pos, version);
+	readLE(buffer, pos, entry_count);
+	if (version != file_version) {
+		std::cerr << "FileHashCache warning: '" << _path << "' has unknown version " << version << ", ignoring\n";
+		return;
+	}
+
+	const size_t body_end = buffer.size() - file_trailer_bytes;
+	std::vector<Entry> entries;
+	for (size_t i = 0; i < entry_count; i++) {
+		Entry entry;
+		uint32_t chunk_count {0};
+		if (
+			!readLE(buffer, pos, entry.key.dev) ||
+			!readLE(buffer, pos, entry.key.inode) ||
+			!readLE(buffer, pos, entry.key.size) ||
+			!readLE(buffer, pos, entry.key.mtime_ns) ||
+			!readLE(buffer, pos, entry.last_used) ||
+			!readLE(buffer, pos, entry.chunk_size) ||
+			!readLE(buffer, pos, chunk_count) ||
+			pos + size_t(chunk_count)*20 > body_end
+		) {
+			std::cerr << "FileHashCache warning: '" << _path << "' is truncated, ignoring\n";
+			return;
+		}
+
+		entry.chunks.reserve(chunk_count);
+		for (size_t j = 0; j < chunk_count; j++) {
+			entry.chunks.emplace_back(buffer.data() + pos, 20);
+			pos += 20;
+		}
+
+		entries.push_back(std::move(entry));
+	}
+
+	_entries = std::move(entries);
+	_bytes = 0;
+	for (const auto& it : _entries) {
+		_bytes += entryBytes(it.chunks.size());
+		_use_counter = std::max(_use_counter, it.last_used);
+	}
+}
+
+bool FileHashCache::save(void) const {
+	std::vector<uint8_t> buffer;
+	buffer.reserve(file_header_bytes + _bytes + file_trailer_bytes);
+
+	buffer.insert(buffer.end(), std::begin(file_magic), std::end(file_magic));
+	writeLE<uint32_t>(buffer, file_version);
+	writeLE<uint32_t>(buffer, _entries.size());
+
+	for (const auto& it : _entries) {
+		writeLE<uint64_t>(buffer, it.key.dev);
+		writeLE<uint64_t>(buffer, it.key.inode);
+		writeLE<uint64_t>(buffer, it.key.size);
+		writeLE<int64_t>(buffer, it.key.mtime_ns);
+		writeLE<uint64_t>(buffer, it.last_used);
+		writeLE<uint32_t>(buffer, it.chunk_size);
+		writeLE<uint32_t>(buffer, it.chunks.size());
+		for (const auto& chunk : it.chunks) {
+			buffer.insert(buffer.end(), chunk.data.cbegin(), chunk.data.cend());
+		}
+	}
+
+	const auto hash = hash_sha1(buffer.data(), buffer.size());
+	buffer.insert(buffer.end(), hash.cbegin(), hash.cend());
+
+	// write next to it and move over, so a crash never leaves a half written cache
+	const auto path = std::filesystem::u8path(_path);
+	auto tmp_path = path;
+	tmp_path += ".tmp";
+	{
+		std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+		if (!file.is_open()) {
+			std::cerr << "FileHashCache error: failed to write '" << tmp_path.generic_u8string() << "'\n";
+			return false;
+		}
+		file.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+		if (!file.good()) {
+			std::cerr << "FileHashCache error: failed to write '" << tmp_path.generic_u8string() << "'\n";
+			return false;
+		}
+	}
+
+	std::error_code err;
+	std::filesystem::rename(tmp_path, path, err);
+	if (err) {
+		std::cerr << "FileHashCache error: failed to replace '" << _path << "': " << err.message() << "\n";
+		return false;
+	}
+
+	return true;
+}
+
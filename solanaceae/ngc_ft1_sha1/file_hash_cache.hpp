@@ -0,0 +1,65 @@
+#pragma once
+
+#include "./ft1_sha1_info.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// persistent cache of the chunk hashes of local files, so sharing the same file again skips hashing
+// files are identified by their file id, size and modification time, the content is not looked at
+// not thread safe
+struct FileHashCache {
+	struct Key {
+		uint64_t dev {0};
+		uint64_t inode {0};
+		uint64_t size {0};
+		int64_t mtime_ns {0};
+
+		bool operator==(const Key& other) const {
+			return dev == other.dev && inode == other.inode && size == other.size && mtime_ns == other.mtime_ns;
+		}
+	};
+
+	struct Entry {
+		Key key;
+		uint64_t last_used {0}; // _use_counter at last get/put, for lru
+		uint32_t chunk_size {0};
+		std::vector<SHA1Digest> chunks;
+	};
+
+	std::string _path;
+	size_t _max_bytes; // on disk
+
+	bool _loaded {false};
+	bool _dirty {false}; // use order changed since the last save
+	std::vector<Entry> _entries;
+	uint64_t _use_counter {0};
+	size_t _bytes {0};
+
+	FileHashCache(std::string_view path, size_t max_bytes = 16*1024*1024);
+	// writes the use order of hits since the last put, so the lru survives restarts
+	~FileHashCache(void);
+
+	// from stat() on posix, the volume serial, file index and last write time on windows
+	// false if the file can not be looked at
+	static bool keyFromFile(std::string_view file_path, Key& key_out);
+
+	// changed files, or ones modified so recently that the mtime might not catch the next change, have no stable key
+	static bool keyIsStable(const Key& key);
+
+	// returns nullptr on miss, counts as use
+	const Entry* get(const Key& key);
+
+	// replaces, evicts least recently used entries to stay under max_bytes and writes the cache file
+	void put(const Key& key, uint32_t chunk_size, const std::vector<SHA1Digest>& chunks);
+
+	private:
+		// reads the cache file, a missing or corrupt file is an empty cache
+		void load(void);
+		bool save(void) const;
+
+		static size_t entryBytes(size_t chunk_count);
+};
+
@@ -1,26 +1,64 @@
 #include "./hash_utils.hpp"
 
-#include <sha1.h>
+#include "./ft1_sha1_info.hpp"
+
+#include <solanaceae/ngc_ft1/worker_pool.hpp>
+
+#include "./sha1_impl.hpp"
+
+#include <algorithm>
+#include <cassert>
 
 // returns the 20bytes sha1 hash
 std::vector<uint8_t> hash_sha1(const uint8_t* data, size_t size) {
-	SHA1_CTX ctx;
-	SHA1Init(&ctx);
-
-	{ // lib only takes uint32_t sizes, so chunk it
-		constexpr size_t hash_block_size {0xffffffff};
-		size_t i = 0;
-		for (; i + hash_block_size < size; i += hash_block_size) {
-			SHA1Update(&ctx, reinterpret_cast<const uint8_t*>(data) + i, hash_block_size);
+	std::vector<uint8_t> digest(20);
+	sha1_hash(sha1ImplActive(), data, size, digest.data());
+	return digest;
+}
+
+void hash_sha1_chunks(const uint8_t* data, size_t size, size_t chunk_size, std::vector<SHA1Digest>& chunks, WorkerPool* pool) {
+	assert(chunk_size > 0);
+
+	// preallocated, every task writes only its own slots, so the order is kept without merging
+	chunks.resize((size + chunk_size - 1) / chunk_size);
+
+	// full chunks are hashed lanes at a time, if the impl does multi buffer
+	const SHA1Impl& impl = sha1ImplActive();
+	const size_t full_chunks = size / chunk_size;
+	const size_t groups = (full_chunks + impl.lanes - 1) / impl.lanes;
+
+	const auto hash_group = [&](size_t, size_t g) {
+		if (g == groups) {
+			// the smaller last chunk
+			const size_t offset = full_chunks * chunk_size;
+			sha1_hash(impl, data + offset, size - offset, chunks.back().data.data());
+			return;
 		}
 
-		if (i < size) {
-			SHA1Update(&ctx, reinterpret_cast<const uint8_t*>(data) + i, size - i);
+		const size_t first = g * impl.lanes;
+		const size_t count = std::min(impl.lanes, full_chunks - first);
+
+		constexpr size_t max_lanes {8};
+		assert(count <= max_lanes);
+		const uint8_t* lane_data[max_lanes] {};
+		uint8_t digests[max_lanes*20];
+		for (size_t i = 0; i < count; i++) {
+			lane_data[i] = data + (first + i) * chunk_size;
 		}
-	}
+		sha1_hash_multi(impl, lane_data, chunk_size, count, digests);
 
-	std::vector<uint8_t> sha1_hash(20);
-	SHA1Final(sha1_hash.data(), &ctx);
-	return sha1_hash;
+		for (size_t i = 0; i < count; i++) {
+			chunks[first + i] = SHA1Digest{digests + i*20, 20};
+		}
+	};
+
+	const size_t task_count = groups + (full_chunks < chunks.size() ? 1 : 0);
+	if (pool != nullptr) {
+		pool->parallelFor(task_count, hash_group);
+	} else {
+		for (size_t g = 0; g < task_count; g++) {
+			hash_group(0, g);
+		}
+	}
 }
 
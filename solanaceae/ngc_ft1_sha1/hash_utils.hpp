@@ -4,8 +4,15 @@
 #include <cstddef>
 #include <vector>
 
+struct SHA1Digest;
+struct WorkerPool;
+
 // returns the 20bytes sha1 hash
 std::vector<uint8_t> hash_sha1(const uint8_t* data, size_t size);
 
 inline std::vector<uint8_t> hash_sha1(const char* data, size_t size) { return hash_sha1(reinterpret_cast<const uint8_t*>(data), size); }
 
+// hashes data in chunk_size chunks (the last can be smaller), chunks is resized to fit
+// the chunks are independent, so they are spread over pool, if given
+void hash_sha1_chunks(const uint8_t* data, size_t size, size_t chunk_size, std::vector<SHA1Digest>& chunks, WorkerPool* pool = nullptr);
+
@@ -27,13 +27,13 @@ void ReceivingTransfers::tick(float delta) {
 	}
 }
 
-ReceivingTransfers::Entry& ReceivingTransfers::emplaceInfo(uint32_t group_number, uint32_t peer_number, uint8_t transfer_id, const Entry::Info& info) {
+ReceivingTransfers::Entry& ReceivingTransfers::emplaceInfo(uint32_t group_number, uint32_t peer_number, uint16_t transfer_id, const Entry::Info& info) {
 	auto& ent = _data[combine_ids(group_number, peer_number)][transfer_id];
 	ent.v = info;
 	return ent;
 }
 
-ReceivingTransfers::Entry& ReceivingTransfers::emplaceChunk(uint32_t group_number, uint32_t peer_number, uint8_t transfer_id, const Entry::Chunk& chunk) {
+ReceivingTransfers::Entry& ReceivingTransfers::emplaceChunk(uint32_t group_number, uint32_t peer_number, uint16_t transfer_id, const Entry::Chunk& chunk) {
 	assert(!chunk.chunk_indices.empty());
 	assert(!containsPeerChunk(group_number, peer_number, chunk.content, chunk.chunk_indices.front()));
 	auto& ent = _data[combine_ids(group_number, peer_number)][transfer_id];
@@ -41,7 +41,7 @@ ReceivingTransfers::Entry& ReceivingTransfers::emplaceChunk(uint32_t group_numbe
 	return ent;
 }
 
-bool ReceivingTransfers::containsPeerTransfer(uint32_t group_number, uint32_t peer_number, uint8_t transfer_id) const {
+bool ReceivingTransfers::containsPeerTransfer(uint32_t group_number, uint32_t peer_number, uint16_t transfer_id) const {
 	auto it = _data.find(combine_ids(group_number, peer_number));
 	if (it == _data.end()) {
 		return false;
@@ -103,7 +103,7 @@ void ReceivingTransfers::removePeer(uint32_t group_number, uint32_t peer_number)
 	_data.erase(combine_ids(group_number, peer_number));
 }
 
-void ReceivingTransfers::removePeerTransfer(uint32_t group_number, uint32_t peer_number, uint8_t transfer_id) {
+void ReceivingTransfers::removePeerTransfer(uint32_t group_number, uint32_t peer_number, uint16_t transfer_id) {
 	auto it = _data.find(combine_ids(group_number, peer_number));
 	if (it == _data.end()) {
 		return;
@@ -5,6 +5,7 @@
 #include <entt/container/dense_map.hpp>
 
 #include "./util.hpp"
+#include "./sha1_impl.hpp"
 
 #include <cstdint>
 #include <variant>
@@ -24,6 +25,11 @@ struct ReceivingTransfers {
 			std::vector<size_t> chunk_indices;
 			// or data?
 			// if memmapped, this would be just a pointer
+
+			// hashed as the data comes in, so done does not need to read the chunk back
+			// ngcft1 hands out data in order, if it ever does not, or writing to the file failed, the chunk is read back and hashed on done
+			SHA1Stream hash_stream;
+			bool hash_stream_good {true};
 		};
 
 		std::variant<Info, Chunk> v;
@@ -42,23 +48,23 @@ struct ReceivingTransfers {
 	// key is groupid + peerid
 	// TODO: replace with contact
 	//using ReceivingTransfers = entt::dense_map<uint64_t, entt::dense_map<uint8_t, ReceivingTransferE>>;
-	entt::dense_map<uint64_t, entt::dense_map<uint8_t, Entry>> _data;
+	entt::dense_map<uint64_t, entt::dense_map<uint16_t, Entry>> _data;
 
 	void tick(float delta);
 
-	Entry& emplaceInfo(uint32_t group_number, uint32_t peer_number, uint8_t transfer_id, const Entry::Info& info);
-	Entry& emplaceChunk(uint32_t group_number, uint32_t peer_number, uint8_t transfer_id, const Entry::Chunk& chunk);
+	Entry& emplaceInfo(uint32_t group_number, uint32_t peer_number, uint16_t transfer_id, const Entry::Info& info);
+	Entry& emplaceChunk(uint32_t group_number, uint32_t peer_number, uint16_t transfer_id, const Entry::Chunk& chunk);
 
 	bool containsPeer(uint32_t group_number, uint32_t peer_number) const { return _data.count(combine_ids(group_number, peer_number)); }
-	bool containsPeerTransfer(uint32_t group_number, uint32_t peer_number, uint8_t transfer_id) const;
+	bool containsPeerTransfer(uint32_t group_number, uint32_t peer_number, uint16_t transfer_id) const;
 	bool containsChunk(ObjectHandle o, size_t chunk_idx) const;
 	bool containsPeerChunk(uint32_t group_number, uint32_t peer_number, ObjectHandle o, size_t chunk_idx) const;
 
 	auto& getPeer(uint32_t group_number, uint32_t peer_number) { return _data.at(combine_ids(group_number, peer_number)); }
-	auto& getTransfer(uint32_t group_number, uint32_t peer_number, uint8_t transfer_id) { return getPeer(group_number, peer_number).at(transfer_id); }
+	auto& getTransfer(uint32_t group_number, uint32_t peer_number, uint16_t transfer_id) { return getPeer(group_number, peer_number).at(transfer_id); }
 
 	void removePeer(uint32_t group_number, uint32_t peer_number);
-	void removePeerTransfer(uint32_t group_number, uint32_t peer_number, uint8_t transfer_id);
+	void removePeerTransfer(uint32_t group_number, uint32_t peer_number, uint16_t transfer_id);
 
 	size_t size(void) const;
 	size_t sizePeer(uint32_t group_number, uint32_t peer_number) const;
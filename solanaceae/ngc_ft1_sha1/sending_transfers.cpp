@@ -30,20 +30,20 @@ void SendingTransfers::tick(float delta) {
 	}
 }
 
-SendingTransfers::Entry& SendingTransfers::emplaceInfo(uint32_t group_number, uint32_t peer_number, uint8_t transfer_id, const Entry::Info& info) {
+SendingTransfers::Entry& SendingTransfers::emplaceInfo(uint32_t group_number, uint32_t peer_number, uint16_t transfer_id, const Entry::Info& info) {
 	auto& ent = _data[combine_ids(group_number, peer_number)][transfer_id];
 	ent.v = info;
 	return ent;
 }
 
-SendingTransfers::Entry& SendingTransfers::emplaceChunk(uint32_t group_number, uint32_t peer_number, uint8_t transfer_id, const Entry::Chunk& chunk) {
+SendingTransfers::Entry& SendingTransfers::emplaceChunk(uint32_t group_number, uint32_t peer_number, uint16_t transfer_id, const Entry::Chunk& chunk) {
 	assert(!containsPeerChunk(group_number, peer_number, chunk.o, chunk.chunk_index));
 	auto& ent = _data[combine_ids(group_number, peer_number)][transfer_id];
 	ent.v = chunk;
 	return ent;
 }
 
-bool SendingTransfers::containsPeerTransfer(uint32_t group_number, uint32_t peer_number, uint8_t transfer_id) const {
+bool SendingTransfers::containsPeerTransfer(uint32_t group_number, uint32_t peer_number, uint16_t transfer_id) const {
 	auto it = _data.find(combine_ids(group_number, peer_number));
 	if (it == _data.end()) {
 		return false;
@@ -101,7 +101,7 @@ void SendingTransfers::removePeer(uint32_t group_number, uint32_t peer_number) {
 	_data.erase(combine_ids(group_number, peer_number));
 }
 
-void SendingTransfers::removePeerTransfer(uint32_t group_number, uint32_t peer_number, uint8_t transfer_id) {
+void SendingTransfers::removePeerTransfer(uint32_t group_number, uint32_t peer_number, uint16_t transfer_id) {
 	auto it = _data.find(combine_ids(group_number, peer_number));
 	if (it == _data.end()) {
 		return;
@@ -0,0 +1,255 @@
+#include "./sha1_impl.hpp"
+
+#include <sha1.h>
+
+#include <array>
+#include <algorithm>
+#include <cstring>
+#include <cassert>
+#include <iostream>
+
+#if SHA1_IMPL_X86
+	#if defined(_MSC_VER)
+		#include <intrin.h>
+	#else
+		#include <cpuid.h>
+	#endif
+#endif
+
+#if SHA1_IMPL_ARM64
+	#if defined(__linux__)
+		#include <sys/auxv.h>
+		#include <asm/hwcap.h>
+	#elif defined(_WIN32)
+		#include <windows.h>
+	#endif
+#endif
+
+void sha1_compress_portable(uint32_t state[5], const uint8_t* blocks, size_t block_count) {
+	for (size_t i = 0; i < block_count; i++) {
+		SHA1Transform(state, blocks + i*64);
+	}
+}
+
+#if SHA1_IMPL_X86
+struct CPUIDRegs {
+	uint32_t eax {0};
+	uint32_t ebx {0};
+	uint32_t ecx {0};
+	uint32_t edx {0};
+};
+
+static CPUIDRegs cpuid(uint32_t leaf, uint32_t subleaf) {
+	CPUIDRegs r;
+#if defined(_MSC_VER)
+	int regs[4];
+	__cpuidex(regs, leaf, subleaf);
+	r.eax = regs[0];
+	r.ebx = regs[1];
+	r.ecx = regs[2];
+	r.edx = regs[3];
+#else
+	__cpuid_count(leaf, subleaf, r.eax, r.ebx, r.ecx, r.edx);
+#endif
+	return r;
+}
+
+// which register states the os saves
+static uint64_t xgetbv0(void) {
+#if defined(_MSC_VER)
+	return _xgetbv(0);
+#else
+	uint32_t eax, edx;
+	__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return (uint64_t(edx) << 32) | eax;
+#endif
+}
+#endif
+
+static std::vector<SHA1Impl> detectImpls(void) {
+	std::vector<SHA1Impl> impls;
+	impls.push_back({"portable", sha1_compress_portable});
+
+#if SHA1_IMPL_X86
+	const uint32_t max_leaf = cpuid(0, 0).eax;
+	const CPUIDRegs leaf1 = cpuid(1, 0);
+	const CPUIDRegs leaf7 = max_leaf >= 7 ? cpuid(7, 0) : CPUIDRegs{};
+
+	const bool ssse3 = leaf1.ecx & (1u << 9);
+	const bool sse41 = leaf1.ecx & (1u << 19);
+	const bool osxsave = leaf1.ecx & (1u << 27);
+	const bool sha = leaf7.ebx & (1u << 29);
+	// the os has to save the ymm registers too
+	const bool avx2 = (leaf7.ebx & (1u << 5)) && osxsave && (xgetbv0() & 0x6) == 0x6;
+
+	if (ssse3) {
+		impls.push_back({"ssse3 x4", sha1_compress_portable, sha1_compress_multi_ssse3, 4});
+	}
+	if (avx2) {
+		impls.push_back({"avx2 x8", sha1_compress_portable, sha1_compress_multi_avx2, 8});
+	}
+	if (sha && sse41) {
+		impls.push_back({"sha-ni", sha1_compress_shani});
+	}
+#endif
+
+#if SHA1_IMPL_ARM64
+	#if defined(__linux__)
+	const bool sha1_ext = getauxval(AT_HWCAP) & HWCAP_SHA1;
+	#elif defined(__APPLE__)
+	const bool sha1_ext = true; // all apple arm64 have it
+	#elif defined(_WIN32)
+	// the crypto extension as a whole, sha1 is part of it
+	const bool sha1_ext = IsProcessorFeaturePresent(PF_ARM_V8_CRYPTO_INSTRUCTIONS_AVAILABLE);
+	#else
+	const bool sha1_ext = false; // no way to ask, portable it is
+	#endif
+	if (sha1_ext) {
+		impls.push_back({"armv8", sha1_compress_armv8});
+	}
+#endif
+
+	return impls;
+}
+
+const std::vector<SHA1Impl>& sha1ImplsSupported(void) {
+	static const std::vector<SHA1Impl> impls = detectImpls();
+	return impls;
+}
+
+const SHA1Impl& sha1ImplActive(void) {
+	// the instructions win over multi buffer, wider multi buffer over narrower
+	// so the last one detected
+	static const SHA1Impl& impl = [](void) -> const SHA1Impl& {
+		const auto& impl = sha1ImplsSupported().back();
+		std::cout << "SHA1 using " << impl.name << "\n";
+		return impl;
+	}();
+	return impl;
+}
+
+static constexpr std::array<uint32_t, 5> sha1_initial_state {
+	0x67452301u, 0xEFCDAB89u, 0x98BADCFEu, 0x10325476u, 0xC3D2E1F0u
+};
+
+// pads the last (partial) block, returns the number of blocks written to tail (1 or 2)
+// rest_data is the last size % 64 bytes of the message
+static size_t padTail(const uint8_t* rest_data, uint64_t size, uint8_t tail[128]) {
+	const size_t rest = size % 64;
+	std::memcpy(tail, rest_data, rest);
+	tail[rest] = 0x80;
+
+	// needs space for the 0x80 and the 8 byte length
+	const size_t tail_blocks = rest + 1 + 8 <= 64 ? 1 : 2;
+	std::memset(tail + rest + 1, 0, tail_blocks*64 - (rest + 1));
+
+	const uint64_t bit_size = uint64_t(size) * 8;
+	for (size_t i = 0; i < 8; i++) {
+		tail[tail_blocks*64 - 1 - i] = (bit_size >> (i*8)) & 0xff;
+	}
+
+	return tail_blocks;
+}
+
+static void writeDigest(const uint32_t state[5], uint8_t* digest) {
+	for (size_t i = 0; i < 5; i++) {
+		digest[i*4+0] = (state[i] >> 24) & 0xff;
+		digest[i*4+1] = (state[i] >> 16) & 0xff;
+		digest[i*4+2] = (state[i] >> 8) & 0xff;
+		digest[i*4+3] = (state[i] >> 0) & 0xff;
+	}
+}
+
+void sha1_hash(const SHA1Impl& impl, const uint8_t* data, size_t size, uint8_t* digest) {
+	uint32_t state[5];
+	std::memcpy(state, sha1_initial_state.data(), sizeof(state));
+
+	impl.compress(state, data, size / 64);
+
+	uint8_t tail[128];
+	const size_t tail_blocks = padTail(data + (size - size % 64), size, tail);
+	impl.compress(state, tail, tail_blocks);
+
+	writeDigest(state, digest);
+}
+
+void sha1_hash_multi(const SHA1Impl& impl, const uint8_t* const* data, size_t size, size_t count, uint8_t* digests) {
+	if (impl.compress_multi == nullptr) {
+		for (size_t i = 0; i < count; i++) {
+			sha1_hash(impl, data[i], size, digests + i*20);
+		}
+		return;
+	}
+
+	constexpr size_t max_lanes {8};
+	assert(impl.lanes <= max_lanes);
+
+	uint32_t states[max_lanes][5];
+	const uint8_t* lane_data[max_lanes];
+	uint8_t tails[max_lanes][128];
+	const uint8_t* lane_tails[max_lanes];
+
+	for (size_t first = 0; first < count; first += impl.lanes) {
+		const size_t used = std::min(impl.lanes, count - first);
+		if (used == 1) {
+			sha1_hash(impl, data[first], size, digests + first*20);
+			continue;
+		}
+
+		// unused lanes hash the first message again, cheaper than doing the rest one by one
+		for (size_t lane = 0; lane < impl.lanes; lane++) {
+			std::memcpy(states[lane], sha1_initial_state.data(), sizeof(states[lane]));
+			lane_data[lane] = data[first + (lane < used ? lane : 0)];
+		}
+
+		impl.compress_multi(states, lane_data, size / 64);
+
+		size_t tail_blocks {0};
+		for (size_t lane = 0; lane < impl.lanes; lane++) {
+			tail_blocks = padTail(lane_data[lane] + (size - size % 64), size, tails[lane]);
+			lane_tails[lane] = tails[lane];
+		}
+		impl.compress_multi(states, lane_tails, tail_blocks);
+
+		for (size_t lane = 0; lane < used; lane++) {
+			writeDigest(states[lane], digests + (first + lane)*20);
+		}
+	}
+}
+
+SHA1Stream::SHA1Stream(const SHA1Impl& impl_) : impl(&impl_) {
+	std::memcpy(state, sha1_initial_state.data(), sizeof(state));
+}
+
+void SHA1Stream::update(const uint8_t* data, size_t size) {
+	size_t buffered = total_size % 64;
+	total_size += size;
+
+	// fill up the partial block first
+	if (buffered != 0) {
+		const size_t fill = std::min<size_t>(64 - buffered, size);
+		std::memcpy(buffer + buffered, data, fill);
+		data += fill;
+		size -= fill;
+		buffered += fill;
+
+		if (buffered < 64) {
+			return;
+		}
+		impl->compress(state, buffer, 1);
+	}
+
+	// straight from data
+	impl->compress(state, data, size / 64);
+
+	std::memcpy(buffer, data + (size - size % 64), size % 64);
+}
+
+void SHA1Stream::finish(uint8_t* digest) {
+	uint8_t tail[128];
+	const size_t tail_blocks = padTail(buffer, total_size, tail);
+	impl->compress(state, tail, tail_blocks);
+
+	writeDigest(state, digest);
+}
+
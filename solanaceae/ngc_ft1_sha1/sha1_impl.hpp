@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// sha1 block functions, the fastest one the cpu supports is picked at runtime
+// (cpuid on x86, hwcap on arm64)
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+	#define SHA1_IMPL_X86 1
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+	#define SHA1_IMPL_ARM64 1
+#endif
+
+// state is the 5 word sha1 state, blocks is block_count*64 bytes
+using SHA1CompressFN = void(*)(uint32_t state[5], const uint8_t* blocks, size_t block_count);
+
+// lanes independent messages at once, each with block_count*64 bytes at blocks[lane]
+using SHA1CompressMultiFN = void(*)(uint32_t (*states)[5], const uint8_t* const* blocks, size_t block_count);
+
+struct SHA1Impl {
+	const char* name;
+	SHA1CompressFN compress;
+
+	// multi buffer, only worth it without the sha instructions
+	// compress is used for single messages
+	SHA1CompressMultiFN compress_multi {nullptr};
+	size_t lanes {1};
+};
+
+// all the cpu supports, the portable one first
+const std::vector<SHA1Impl>& sha1ImplsSupported(void);
+
+// what hash_sha1() uses, picked once
+const SHA1Impl& sha1ImplActive(void);
+
+// digest is 20 bytes
+void sha1_hash(const SHA1Impl& impl, const uint8_t* data, size_t size, uint8_t* digest);
+
+// count messages of the same size, in groups of impl.lanes
+// digests is count*20 bytes
+void sha1_hash_multi(const SHA1Impl& impl, const uint8_t* const* data, size_t size, size_t count, uint8_t* digests);
+
+// incremental, for data that arrives in pieces
+struct SHA1Stream {
+	const SHA1Impl* impl;
+	uint32_t state[5];
+	uint8_t buffer[64]; // partial block
+	uint64_t total_size {0};
+
+	SHA1Stream(void) : SHA1Stream(sha1ImplActive()) {}
+	SHA1Stream(const SHA1Impl& impl_);
+
+	// bytes fed so far
+	uint64_t size(void) const { return total_size; }
+
+	void update(const uint8_t* data, size_t size);
+
+	// digest is 20 bytes, the stream is done after this
+	void finish(uint8_t* digest);
+};
+
+// implementations, only built for their arch
+// (the cpu specific ones get their own compile flags, only call them if the cpu has the instructions)
+
+void sha1_compress_portable(uint32_t state[5], const uint8_t* blocks, size_t block_count);
+
+#if SHA1_IMPL_X86
+void sha1_compress_shani(uint32_t state[5], const uint8_t* blocks, size_t block_count);
+// 4 lanes
+void sha1_compress_multi_ssse3(uint32_t (*states)[5], const uint8_t* const* blocks, size_t block_count);
+// 8 lanes
+void sha1_compress_multi_avx2(uint32_t (*states)[5], const uint8_t* const* blocks, size_t block_count);
+#endif
+
+#if SHA1_IMPL_ARM64
+void sha1_compress_armv8(uint32_t state[5], const uint8_t* blocks, size_t block_count);
+#endif
+
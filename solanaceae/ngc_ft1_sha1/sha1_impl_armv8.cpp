@@ -0,0 +1,75 @@
+#include "./sha1_impl.hpp"
+
+// built with the armv8 crypto extension enabled
+
+#if SHA1_IMPL_ARM64
+
+#include <arm_neon.h>
+
+// W+K for each group of 4 rounds
+static inline uint32x4_t sha1WK(uint32x4_t w, int group) {
+	static constexpr uint32_t k[4] {0x5A827999u, 0x6ED9EBA1u, 0x8F1BBCDCu, 0xCA62C1D6u};
+	return vaddq_u32(w, vdupq_n_u32(k[group/5]));
+}
+
+// 4 rounds (a group) per step, with the message schedule for the later groups interleaved
+template<int G>
+static inline void sha1GroupARMv8(uint32x4_t& abcd, uint32_t& e0, uint32_t& e1, uint32x4_t (&msg)[4], uint32x4_t (&wk)[2]) {
+	uint32_t& e_in = G%2 == 0 ? e0 : e1;
+	uint32_t& e_out = G%2 == 0 ? e1 : e0;
+
+	e_out = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+	if constexpr (G < 5) {
+		abcd = vsha1cq_u32(abcd, e_in, wk[G%2]);
+	} else if constexpr (G >= 10 && G < 15) {
+		abcd = vsha1mq_u32(abcd, e_in, wk[G%2]);
+	} else {
+		abcd = vsha1pq_u32(abcd, e_in, wk[G%2]);
+	}
+
+	if constexpr (G <= 17) {
+		wk[G%2] = sha1WK(msg[(G+2)%4], G+2);
+	}
+	if constexpr (G >= 1 && G <= 16) {
+		msg[(G+3)%4] = vsha1su1q_u32(msg[(G+3)%4], msg[(G+2)%4]);
+	}
+	if constexpr (G <= 15) {
+		msg[G%4] = vsha1su0q_u32(msg[G%4], msg[(G+1)%4], msg[(G+2)%4]);
+	}
+
+	if constexpr (G < 19) {
+		sha1GroupARMv8<G+1>(abcd, e0, e1, msg, wk);
+	}
+}
+
+void sha1_compress_armv8(uint32_t state[5], const uint8_t* blocks, size_t block_count) {
+	uint32x4_t abcd = vld1q_u32(state);
+	uint32_t e0 = state[4];
+
+	for (size_t i = 0; i < block_count; i++) {
+		const uint8_t* block = blocks + i*64;
+
+		const uint32x4_t abcd_save = abcd;
+		const uint32_t e0_save = e0;
+
+		uint32x4_t msg[4];
+		for (size_t j = 0; j < 4; j++) {
+			// big endian words
+			msg[j] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(block + j*16)));
+		}
+
+		uint32x4_t wk[2] {sha1WK(msg[0], 0), sha1WK(msg[1], 1)};
+		uint32_t e1;
+		sha1GroupARMv8<0>(abcd, e0, e1, msg, wk);
+
+		// the e of the next block is the last e_out
+		e0 += e0_save;
+		abcd = vaddq_u32(abcd, abcd_save);
+	}
+
+	vst1q_u32(state, abcd);
+	state[4] = e0;
+}
+
+#endif
+
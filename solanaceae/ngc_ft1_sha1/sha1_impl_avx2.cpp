@@ -0,0 +1,79 @@
+#include "./sha1_impl.hpp"
+
+// built with avx2 enabled
+
+#if SHA1_IMPL_X86
+
+#include <immintrin.h>
+
+namespace {
+
+struct OpsAVX2 {
+	using V = __m256i;
+	static constexpr size_t LANES {8};
+
+	static V load(const uint32_t* p) { return _mm256_load_si256(reinterpret_cast<const __m256i*>(p)); }
+	static void store(uint32_t* p, V v) { _mm256_store_si256(reinterpret_cast<__m256i*>(p), v); }
+	static V set1(uint32_t x) { return _mm256_set1_epi32(static_cast<int>(x)); }
+
+	static V add(V a, V b) { return _mm256_add_epi32(a, b); }
+	static V bxor(V a, V b) { return _mm256_xor_si256(a, b); }
+	static V band(V a, V b) { return _mm256_and_si256(a, b); }
+	static V bor(V a, V b) { return _mm256_or_si256(a, b); }
+	static V rotl(V x, int n) { return _mm256_or_si256(_mm256_slli_epi32(x, n), _mm256_srli_epi32(x, 32-n)); }
+
+	static void loadBlock(const uint8_t* const* blocks, size_t offset, V (&w)[16]) {
+		const __m256i bswap = _mm256_set_epi8(
+			12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+			12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3
+		);
+
+		for (size_t h = 0; h < 2; h++) {
+			__m256i r[8];
+			for (size_t lane = 0; lane < 8; lane++) {
+				r[lane] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(blocks[lane] + offset + h*32));
+			}
+
+			// 8x8 transpose, first within the 128bit halves
+			const __m256i t0 = _mm256_unpacklo_epi32(r[0], r[1]);
+			const __m256i t1 = _mm256_unpackhi_epi32(r[0], r[1]);
+			const __m256i t2 = _mm256_unpacklo_epi32(r[2], r[3]);
+			const __m256i t3 = _mm256_unpackhi_epi32(r[2], r[3]);
+			const __m256i t4 = _mm256_unpacklo_epi32(r[4], r[5]);
+			const __m256i t5 = _mm256_unpackhi_epi32(r[4], r[5]);
+			const __m256i t6 = _mm256_unpacklo_epi32(r[6], r[7]);
+			const __m256i t7 = _mm256_unpackhi_epi32(r[6], r[7]);
+
+			// lanes 0-3 | 4-7, words 0 and 4, 1 and 5, ...
+			const __m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+			const __m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+			const __m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+			const __m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+			const __m256i u4 = _mm256_unpacklo_epi64(t4, t6);
+			const __m256i u5 = _mm256_unpackhi_epi64(t4, t6);
+			const __m256i u6 = _mm256_unpacklo_epi64(t5, t7);
+			const __m256i u7 = _mm256_unpackhi_epi64(t5, t7);
+
+			// then across
+			w[h*8+0] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(u0, u4, 0x20), bswap);
+			w[h*8+1] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(u1, u5, 0x20), bswap);
+			w[h*8+2] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(u2, u6, 0x20), bswap);
+			w[h*8+3] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(u3, u7, 0x20), bswap);
+			w[h*8+4] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(u0, u4, 0x31), bswap);
+			w[h*8+5] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(u1, u5, 0x31), bswap);
+			w[h*8+6] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(u2, u6, 0x31), bswap);
+			w[h*8+7] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(u3, u7, 0x31), bswap);
+		}
+	}
+};
+
+} // namespace
+
+#include "./sha1_impl_multi.hpp"
+
+void sha1_compress_multi_avx2(uint32_t (*states)[5], const uint8_t* const* blocks, size_t block_count) {
+	sha1CompressMulti<OpsAVX2>(states, blocks, block_count);
+}
+
+#endif
+
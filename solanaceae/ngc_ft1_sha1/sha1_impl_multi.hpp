@@ -0,0 +1,85 @@
+#pragma once
+
+// multi buffer sha1 rounds, shared by the simd implementations
+// only include from a file built for the instructions Ops uses, Ops has to be file local
+
+#include <cstdint>
+#include <cstddef>
+
+// Ops::V holds the same word of Ops::LANES independent messages
+// Ops::loadBlock(blocks, offset, w) loads the 16 message words, big endian, transposed
+template<typename Ops>
+static inline void sha1CompressMulti(uint32_t (*states)[5], const uint8_t* const* blocks, size_t block_count) {
+	using V = typename Ops::V;
+	constexpr size_t lanes = Ops::LANES;
+
+	V s[5];
+	for (size_t i = 0; i < 5; i++) {
+		alignas(32) uint32_t tmp[lanes];
+		for (size_t lane = 0; lane < lanes; lane++) {
+			tmp[lane] = states[lane][i];
+		}
+		s[i] = Ops::load(tmp);
+	}
+
+	for (size_t block = 0; block < block_count; block++) {
+		V w[16];
+		Ops::loadBlock(blocks, block*64, w);
+
+		V a = s[0], b = s[1], c = s[2], d = s[3], e = s[4];
+
+		const auto round = [&](const V f, const V k, const V wt) {
+			const V tmp = Ops::add(Ops::add(Ops::rotl(a, 5), f), Ops::add(Ops::add(e, k), wt));
+			e = d;
+			d = c;
+			c = Ops::rotl(b, 30);
+			b = a;
+			a = tmp;
+		};
+
+		// w is a ring of the last 16
+		const auto schedule = [&](const size_t t) -> V {
+			if (t >= 16) {
+				w[t%16] = Ops::rotl(Ops::bxor(Ops::bxor(w[(t-3)%16], w[(t-8)%16]), Ops::bxor(w[(t-14)%16], w[t%16])), 1);
+			}
+			return w[t%16];
+		};
+
+		const V k0 = Ops::set1(0x5A827999u);
+		for (size_t t = 0; t < 20; t++) {
+			// ch: d ^ (b & (c ^ d))
+			round(Ops::bxor(d, Ops::band(b, Ops::bxor(c, d))), k0, schedule(t));
+		}
+
+		const V k1 = Ops::set1(0x6ED9EBA1u);
+		for (size_t t = 20; t < 40; t++) {
+			round(Ops::bxor(Ops::bxor(b, c), d), k1, schedule(t));
+		}
+
+		const V k2 = Ops::set1(0x8F1BBCDCu);
+		for (size_t t = 40; t < 60; t++) {
+			// maj: (b & c) | (d & (b | c))
+			round(Ops::bor(Ops::band(b, c), Ops::band(d, Ops::bor(b, c))), k2, schedule(t));
+		}
+
+		const V k3 = Ops::set1(0xCA62C1D6u);
+		for (size_t t = 60; t < 80; t++) {
+			round(Ops::bxor(Ops::bxor(b, c), d), k3, schedule(t));
+		}
+
+		s[0] = Ops::add(s[0], a);
+		s[1] = Ops::add(s[1], b);
+		s[2] = Ops::add(s[2], c);
+		s[3] = Ops::add(s[3], d);
+		s[4] = Ops::add(s[4], e);
+	}
+
+	for (size_t i = 0; i < 5; i++) {
+		alignas(32) uint32_t tmp[lanes];
+		Ops::store(tmp, s[i]);
+		for (size_t lane = 0; lane < lanes; lane++) {
+			states[lane][i] = tmp[lane];
+		}
+	}
+}
+
@@ -0,0 +1,70 @@
+#include "./sha1_impl.hpp"
+
+// built with sse4.1 and sha enabled
+
+#if SHA1_IMPL_X86
+
+#include <immintrin.h>
+
+// 4 rounds (a group) per step, with the message schedule for the later groups interleaved
+// the round function (immediate) is G/5
+template<int G>
+static inline void sha1GroupSHANI(__m128i& abcd, __m128i& e0, __m128i& e1, __m128i (&msg)[4], const uint8_t* block, const __m128i mask) {
+	__m128i& w = msg[G%4];
+	__m128i& e_in = G%2 == 0 ? e0 : e1;
+	__m128i& e_out = G%2 == 0 ? e1 : e0;
+
+	if constexpr (G < 4) {
+		w = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block + G*16)), mask);
+	}
+
+	if constexpr (G == 0) {
+		e_in = _mm_add_epi32(e_in, w);
+	} else {
+		e_in = _mm_sha1nexte_epu32(e_in, w);
+	}
+	e_out = abcd;
+
+	if constexpr (G >= 3 && G <= 18) {
+		msg[(G+1)%4] = _mm_sha1msg2_epu32(msg[(G+1)%4], w);
+	}
+
+	abcd = _mm_sha1rnds4_epu32(abcd, e_in, G/5);
+
+	if constexpr (G >= 1 && G <= 16) {
+		msg[(G+3)%4] = _mm_sha1msg1_epu32(msg[(G+3)%4], w);
+	}
+	if constexpr (G >= 2 && G <= 17) {
+		msg[(G+2)%4] = _mm_xor_si128(msg[(G+2)%4], w);
+	}
+
+	if constexpr (G < 19) {
+		sha1GroupSHANI<G+1>(abcd, e0, e1, msg, block, mask);
+	}
+}
+
+void sha1_compress_shani(uint32_t state[5], const uint8_t* blocks, size_t block_count) {
+	// big endian words
+	const __m128i mask = _mm_set_epi64x(0x0001020304050607ll, 0x08090a0b0c0d0e0fll);
+
+	__m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0x1b);
+	__m128i e0 = _mm_set_epi32(state[4], 0, 0, 0);
+
+	for (size_t i = 0; i < block_count; i++) {
+		const __m128i abcd_save = abcd;
+		const __m128i e0_save = e0;
+
+		__m128i e1;
+		__m128i msg[4];
+		sha1GroupSHANI<0>(abcd, e0, e1, msg, blocks + i*64, mask);
+
+		e0 = _mm_sha1nexte_epu32(e0, e0_save);
+		abcd = _mm_add_epi32(abcd, abcd_save);
+	}
+
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(state), _mm_shuffle_epi32(abcd, 0x1b));
+	state[4] = _mm_extract_epi32(e0, 3);
+}
+
+#endif
+
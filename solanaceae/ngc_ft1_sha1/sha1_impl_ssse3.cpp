@@ -0,0 +1,57 @@
+#include "./sha1_impl.hpp"
+
+// built with ssse3 enabled
+
+#if SHA1_IMPL_X86
+
+#include <immintrin.h>
+
+namespace {
+
+struct OpsSSSE3 {
+	using V = __m128i;
+	static constexpr size_t LANES {4};
+
+	static V load(const uint32_t* p) { return _mm_load_si128(reinterpret_cast<const __m128i*>(p)); }
+	static void store(uint32_t* p, V v) { _mm_store_si128(reinterpret_cast<__m128i*>(p), v); }
+	static V set1(uint32_t x) { return _mm_set1_epi32(static_cast<int>(x)); }
+
+	static V add(V a, V b) { return _mm_add_epi32(a, b); }
+	static V bxor(V a, V b) { return _mm_xor_si128(a, b); }
+	static V band(V a, V b) { return _mm_and_si128(a, b); }
+	static V bor(V a, V b) { return _mm_or_si128(a, b); }
+	static V rotl(V x, int n) { return _mm_or_si128(_mm_slli_epi32(x, n), _mm_srli_epi32(x, 32-n)); }
+
+	static void loadBlock(const uint8_t* const* blocks, size_t offset, V (&w)[16]) {
+		const __m128i bswap = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+
+		for (size_t q = 0; q < 4; q++) {
+			const __m128i r0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks[0] + offset + q*16));
+			const __m128i r1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks[1] + offset + q*16));
+			const __m128i r2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks[2] + offset + q*16));
+			const __m128i r3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks[3] + offset + q*16));
+
+			// 4x4 transpose
+			const __m128i t0 = _mm_unpacklo_epi32(r0, r1);
+			const __m128i t1 = _mm_unpacklo_epi32(r2, r3);
+			const __m128i t2 = _mm_unpackhi_epi32(r0, r1);
+			const __m128i t3 = _mm_unpackhi_epi32(r2, r3);
+
+			w[q*4+0] = _mm_shuffle_epi8(_mm_unpacklo_epi64(t0, t1), bswap);
+			w[q*4+1] = _mm_shuffle_epi8(_mm_unpackhi_epi64(t0, t1), bswap);
+			w[q*4+2] = _mm_shuffle_epi8(_mm_unpacklo_epi64(t2, t3), bswap);
+			w[q*4+3] = _mm_shuffle_epi8(_mm_unpackhi_epi64(t2, t3), bswap);
+		}
+	}
+};
+
+} // namespace
+
+#include "./sha1_impl_multi.hpp"
+
+void sha1_compress_multi_ssse3(uint32_t (*states)[5], const uint8_t* const* blocks, size_t block_count) {
+	sha1CompressMulti<OpsSSSE3>(states, blocks, block_count);
+}
+
+#endif
+
@@ -263,7 +263,17 @@ SHA1_NGCFT1::SHA1_NGCFT1(
 	;
 }
 
+void SHA1_NGCFT1::setHashThreads(size_t threads) {
+	_mfb.setHashThreads(threads);
+}
+
+void SHA1_NGCFT1::setHashCachePath(std::string_view path, size_t max_bytes) {
+	_mfb.setHashCachePath(path, max_bytes);
+}
+
 float SHA1_NGCFT1::iterate(float delta) {
+	_chunk_verify_queue.tick();
+
 	_mfb.tick(getTimeNow()); // does not need to be called as often, once every sec would be enough, but the pointer deref + atomic bool should be very fast
 
 	_peer_open_requests.clear();
@@ -399,7 +409,7 @@ float SHA1_NGCFT1::iterate(float delta) {
 				if (!_sending_transfers.containsPeerChunk(group_number, peer_number, ce, chunk_idx_vec.front())) {
 					const auto& info = ce.get<Components::FT1InfoSHA1>();
 
-					uint8_t transfer_id {0};
+					uint16_t transfer_id {0};
 					if (_nft.NGC_FT1_send_init_private(
 						group_number, peer_number,
 						static_cast<uint32_t>(NGCFT1_file_kind_old::HASH_SHA1_CHUNK),
@@ -473,7 +483,7 @@ float SHA1_NGCFT1::iterate(float delta) {
 	);
 
 	_file_inactivity_timer += delta;
-	if (_file_inactivity_timer >= 21.554f) {
+	if (_file_inactivity_timer >= file_inactivity_interval) {
 		_file_inactivity_timer = 0.f;
 		Systems::file_inactivity(_os.registry(), getTimeNow());
 	}
@@ -481,13 +491,38 @@ float SHA1_NGCFT1::iterate(float delta) {
 	// transfer statistics systems
 	Systems::transfer_tally_update(_os.registry(), getTimeNow());
 
-	if (_peer_open_requests.empty()) {
-		return 2.f;
-	} else {
-		// ft1 will go lower for us, if we have unresolved info,
+	// queued up work is done one per tick
+	if (
+		!_queue_send_bitset.empty() ||
+		(!_queue_requested_chunk.empty() && _sending_transfers.size() < _max_concurrent_out)
+	) {
+		return 0.005f;
+	}
+
+	float next_deadline = 2.f;
+
+	if (!_queue_content_want_info.empty() && _receiving_transfers.size() < _max_concurrent_info_in) {
+		// we might not find a peer for a while,
 		// we dont want to be stuck in a high tickrate
-		return 0.5f;
+		next_deadline = 0.5f;
 	}
+
+	if (_receiving_transfers.size() > 0 || !_peer_open_requests.empty()) {
+		// chunk pickers get tagged by transfer events and should request the next chunks soon
+		next_deadline = std::min(next_deadline, 0.05f);
+	}
+
+	_cs.registry().view<ChunkPickerTimer>().each([&next_deadline](const ChunkPickerTimer& cpt) {
+		next_deadline = std::min(next_deadline, cpt.timer);
+	});
+
+	_os.registry().view<Components::ReAnnounceTimer>().each([&next_deadline](const Components::ReAnnounceTimer& rat) {
+		next_deadline = std::min(next_deadline, rat.timer);
+	});
+
+	next_deadline = std::min(next_deadline, file_inactivity_interval - _file_inactivity_timer);
+
+	return std::max(next_deadline, 0.001f);
 }
 
 // gets called back on main thread after a "new" file info got built on a different thread
@@ -828,13 +863,15 @@ bool SHA1_NGCFT1::onEvent(const Events::NGCFT1_recv_request& e) {
 
 		// TODO: queue instead
 		//queueUpRequestInfo(e.group_number, e.peer_number, info_hash);
-		uint8_t transfer_id {0};
+		uint16_t transfer_id {0};
 		if (_nft.NGC_FT1_send_init_private(
 			e.group_number, e.peer_number,
 			static_cast<uint32_t>(e.file_kind),
 			e.file_id, e.file_id_size,
 			o.get<Components::FT1InfoSHA1Data>().data.size(),
-			&transfer_id
+			&transfer_id,
+			false,
+			NGCFT1_Priority::HIGH // small and needed before anything else
 		)) {
 			_sending_transfers.emplaceInfo(
 				e.group_number, e.peer_number,
@@ -990,11 +1027,12 @@ bool SHA1_NGCFT1::onEvent(const Events::NGCFT1_recv_init& e) {
 			return false;
 		}
 
-		_receiving_transfers.emplaceChunk(
+		auto& chunk_transfer = _receiving_transfers.emplaceChunk(
 			e.group_number, e.peer_number,
 			e.transfer_id,
 			ReceivingTransfers::Entry::Chunk{o, idx_vec}
-		);
+		).getChunk();
+		chunk_transfer.hash_stream_good = _chunk_hash_streaming;
 
 		e.accept = true;
 
@@ -1028,19 +1066,33 @@ bool SHA1_NGCFT1::onEvent(const Events::NGCFT1_recv_data& e) {
 			info_data[i+e.data_offset] = e.data[i];
 		}
 	} else if (transfer.isChunk()) {
-		auto o = transfer.getChunk().content;
+		auto& chunk_transfer = transfer.getChunk();
+		auto o = chunk_transfer.content;
 
 		const auto chunk_size = o.get<Components::FT1InfoSHA1>().chunk_size;
-		for (const auto chunk_index : transfer.getChunk().chunk_indices) {
+		for (const auto chunk_index : chunk_transfer.chunk_indices) {
 			const auto offset_into_file = chunk_index * chunk_size;
 
 			auto* file2 = objGetFile2Write(o);
 			if (file2 == nullptr) {
 				std::cerr << "SHA1_NGCFT1 error: writing file failed, no file object\n";
+				// the stream would vouch for data that is not in the file
+				chunk_transfer.hash_stream_good = false;
 				return false; // early out
 			}
 			if (!file2->write({e.data, e.data_size}, offset_into_file + e.data_offset)) {
 				std::cerr << "SHA1_NGCFT1 error: writing file failed o:" << entt::to_integral(o.entity()) << "@" << offset_into_file + e.data_offset << "\n";
+				chunk_transfer.hash_stream_good = false;
+			}
+		}
+
+		// same data for all indices, hash once
+		if (chunk_transfer.hash_stream_good) {
+			if (e.data_offset == chunk_transfer.hash_stream.size()) {
+				chunk_transfer.hash_stream.update(e.data, e.data_size);
+			} else {
+				// gap or resend, fall back to reading it back
+				chunk_transfer.hash_stream_good = false;
 			}
 		}
 
@@ -1140,6 +1192,109 @@ bool SHA1_NGCFT1::onEvent(const Events::NGCFT1_send_data& e) {
 	return true;
 }
 
+void SHA1_NGCFT1::onChunkVerified(ObjectHandle o, uint32_t group_number, uint32_t peer_number, const std::vector<size_t>& chunk_indices, bool good, const SHA1Digest& got_hash) {
+	// content might have been destroyed or reset while hashing
+	if (!static_cast<bool>(o) || !o.all_of<Components::FT1InfoSHA1, Components::FT1ChunkSHA1Cache>()) {
+		return;
+	}
+
+	const auto& info = o.get<Components::FT1InfoSHA1>();
+	auto& cc = o.get<Components::FT1ChunkSHA1Cache>(); // is this assumption save?
+
+	if (good) {
+		std::cout << "SHA1_NGCFT1: got chunk [" << got_hash << "]\n";
+
+		if (!o.all_of<ObjComp::F::TagLocalHaveAll>()) {
+			{
+				auto& lhb = o.get_or_emplace<ObjComp::F::LocalHaveBitset>(BitSet{info.chunks.size()});
+				for (const auto inner_chunk_index : chunk_indices) {
+					if (lhb.have[inner_chunk_index]) {
+						continue;
+					}
+
+					// new good chunk
+
+					lhb.have.set(inner_chunk_index);
+					cc.have_count += 1;
+
+					// TODO: have wasted + metadata
+					//o.get_or_emplace<Message::Components::Transfer::BytesReceived>().total += chunk_data.size;
+					// we already tallied all of them but maybe we want to set some other progress indicator here?
+
+					if (cc.have_count == info.chunks.size()) {
+						// debug check
+						for ([[maybe_unused]] size_t i = 0; i < info.chunks.size(); i++) {
+							assert(lhb.have[i]);
+						}
+
+						o.emplace_or_replace<ObjComp::F::TagLocalHaveAll>();
+						std::cout << "SHA1_NGCFT1: got all chunks for \n" << info << "\n";
+
+						// close file, as we likely no longer needs the write access we likely had
+						o.remove<Components::FT1File2>();
+						break;
+					}
+				}
+			}
+			if (o.all_of<ObjComp::F::TagLocalHaveAll>()) {
+				o.remove<ObjComp::F::LocalHaveBitset>(); // save space
+			}
+
+			const auto& cr = _cs.registry();
+
+			// queue chunk have for all participants
+			// HACK: send immediatly to all participants
+			for (const auto c_part : o.get<Components::SuspectedParticipants>().participants) {
+				if (!cr.all_of<Contact::Components::ToxGroupPeerEphemeral>(c_part)) {
+					continue;
+				}
+
+				const auto [part_group_number, part_peer_number] = cr.get<Contact::Components::ToxGroupPeerEphemeral>(c_part);
+
+				const auto& info_hash = o.get<Components::FT1InfoSHA1Hash>().hash;
+
+				// convert size_t to uint32_t
+				const std::vector<uint32_t> chunk_indices_u32 {
+					chunk_indices.cbegin(),
+					chunk_indices.cend()
+				};
+
+				_neep.send_ft1_have(
+					part_group_number, part_peer_number,
+					static_cast<uint32_t>(NGCFT1_file_kind_old::HASH_SHA1_INFO),
+					info_hash.data(), info_hash.size(),
+					chunk_indices_u32.data(), chunk_indices_u32.size()
+				);
+			}
+		} else {
+			std::cout << "SHA1_NGCFT1 warning: got chunk duplicate\n";
+		}
+
+		// something happend, update chunk picker
+		auto c = _tcm.getContactGroupPeer(group_number, peer_number);
+		//assert(static_cast<bool>(c));
+		// happened, went offline but chunk was still done o.o
+		if (static_cast<bool>(c)) {
+			c.emplace_or_replace<ChunkPickerUpdateTag>();
+		}
+	} else {
+		// bad chunk
+		std::cout << "SHA1_NGCFT1: got BAD chunk from " << group_number << ":" << peer_number << " [" << info.chunks.at(chunk_indices.front()) << "] ; instead got [" << got_hash << "]\n";
+	}
+
+	// remove from requested
+	// TODO: remove at init and track running transfers differently
+	// should be done, double check later
+	// (only now, so the chunk picker does not request it again while it is being hashed)
+	for (const auto it : chunk_indices) {
+		o.get_or_emplace<Components::FT1ChunkSHA1Requested>().chunks.erase(it);
+	}
+
+	_os.throwEventUpdate(o);
+
+	updateMessages(o); // mostly for received bytes
+}
+
 bool SHA1_NGCFT1::onEvent(const Events::NGCFT1_recv_done& e) {
 	if (!_receiving_transfers.containsPeerTransfer(e.group_number, e.peer_number, e.transfer_id)) {
 		return false;
@@ -1195,7 +1350,6 @@ bool SHA1_NGCFT1::onEvent(const Events::NGCFT1_recv_done& e) {
 	} else if (transfer.isChunk()) {
 		auto o = transfer.getChunk().content;
 		const auto& info = o.get<Components::FT1InfoSHA1>();
-		auto& cc = o.get<Components::FT1ChunkSHA1Cache>(); // is this assumption save?
 
 		// HACK: only check first chunk (they *should* all be the same)
 		const auto chunk_index = transfer.getChunk().chunk_indices.front();
@@ -1205,6 +1359,18 @@ bool SHA1_NGCFT1::onEvent(const Events::NGCFT1_recv_done& e) {
 		const auto chunk_size = info.chunkSize(chunk_index);
 		assert(offset_into_file+chunk_size <= info.file_size);
 
+		auto& chunk_transfer = transfer.getChunk();
+		if (chunk_transfer.hash_stream_good && chunk_transfer.hash_stream.size() == chunk_size) {
+			// already hashed while receiving
+			SHA1Digest got_hash;
+			chunk_transfer.hash_stream.finish(got_hash.data.data());
+
+			onChunkVerified(o, e.group_number, e.peer_number, chunk_transfer.chunk_indices, info.chunks.at(chunk_index) == got_hash, got_hash);
+
+			_receiving_transfers.removePeerTransfer(e.group_number, e.peer_number, e.transfer_id);
+			return true;
+		}
+
 		auto* file2 = objGetFile2Read(o);
 		if (file2 == nullptr) {
 			// rip
@@ -1213,100 +1379,22 @@ bool SHA1_NGCFT1::onEvent(const Events::NGCFT1_recv_done& e) {
 		auto chunk_data = std::move(file2->read(chunk_size, offset_into_file));
 		assert(!chunk_data.empty());
 
-		// check hash of chunk
-		auto got_hash = hash_sha1(chunk_data.ptr, chunk_data.size);
-		if (info.chunks.at(chunk_index) == got_hash) {
-			std::cout << "SHA1_NGCFT1: got chunk [" << SHA1Digest{got_hash} << "]\n";
-
-			if (!o.all_of<ObjComp::F::TagLocalHaveAll>()) {
-				{
-					auto& lhb = o.get_or_emplace<ObjComp::F::LocalHaveBitset>(BitSet{info.chunks.size()});
-					for (const auto inner_chunk_index : transfer.getChunk().chunk_indices) {
-						if (lhb.have[inner_chunk_index]) {
-							continue;
-						}
-
-						// new good chunk
-
-						lhb.have.set(inner_chunk_index);
-						cc.have_count += 1;
-
-						// TODO: have wasted + metadata
-						//o.get_or_emplace<Message::Components::Transfer::BytesReceived>().total += chunk_data.size;
-						// we already tallied all of them but maybe we want to set some other progress indicator here?
-
-						if (cc.have_count == info.chunks.size()) {
-							// debug check
-							for ([[maybe_unused]] size_t i = 0; i < info.chunks.size(); i++) {
-								assert(lhb.have[i]);
-							}
-
-							o.emplace_or_replace<ObjComp::F::TagLocalHaveAll>();
-							std::cout << "SHA1_NGCFT1: got all chunks for \n" << info << "\n";
-
-							// close file, as we likely no longer needs the write access we likely had
-							file2 = nullptr;
-							o.remove<Components::FT1File2>();
-							break;
-						}
-					}
-				}
-				if (o.all_of<ObjComp::F::TagLocalHaveAll>()) {
-					o.remove<ObjComp::F::LocalHaveBitset>(); // save space
-				}
-
-				const auto& cr = _cs.registry();
-
-				// queue chunk have for all participants
-				// HACK: send immediatly to all participants
-				for (const auto c_part : o.get<Components::SuspectedParticipants>().participants) {
-					if (!cr.all_of<Contact::Components::ToxGroupPeerEphemeral>(c_part)) {
-						continue;
-					}
-
-					const auto [part_group_number, part_peer_number] = cr.get<Contact::Components::ToxGroupPeerEphemeral>(c_part);
-
-					const auto& info_hash = o.get<Components::FT1InfoSHA1Hash>().hash;
-
-					// convert size_t to uint32_t
-					const std::vector<uint32_t> chunk_indices {
-						transfer.getChunk().chunk_indices.cbegin(),
-						transfer.getChunk().chunk_indices.cend()
-					};
-
-					_neep.send_ft1_have(
-						part_group_number, part_peer_number,
-						static_cast<uint32_t>(NGCFT1_file_kind_old::HASH_SHA1_INFO),
-						info_hash.data(), info_hash.size(),
-						chunk_indices.data(), chunk_indices.size()
-					);
-				}
-			} else {
-				std::cout << "SHA1_NGCFT1 warning: got chunk duplicate\n";
+		// check hash of chunk, off thread
+		// copy, the read is likely only a view into the mapped file, which can get closed in the meantime
+		_chunk_verify_queue.push(
+			std::vector<uint8_t>{chunk_data.ptr, chunk_data.ptr + chunk_data.size},
+			info.chunks.at(chunk_index),
+			[
+				this,
+				o,
+				group_number = e.group_number,
+				peer_number = e.peer_number,
+				chunk_indices = transfer.getChunk().chunk_indices
+			](bool good, const SHA1Digest& got_hash) {
+				// back on iterate thread
+				onChunkVerified(o, group_number, peer_number, chunk_indices, good, got_hash);
 			}
-
-			// something happend, update chunk picker
-			auto c = _tcm.getContactGroupPeer(e.group_number, e.peer_number);
-			//assert(static_cast<bool>(c));
-			// happened, went offline but chunk was still done o.o
-			if (static_cast<bool>(c)) {
-				c.emplace_or_replace<ChunkPickerUpdateTag>();
-			}
-		} else {
-			// bad chunk
-			std::cout << "SHA1_NGCFT1: got BAD chunk from " << e.group_number << ":" << e.peer_number << " [" << info.chunks.at(chunk_index) << "] ; instead got [" << SHA1Digest{got_hash} << "]\n";
-		}
-
-		// remove from requested
-		// TODO: remove at init and track running transfers differently
-		// should be done, double check later
-		for (const auto it : transfer.getChunk().chunk_indices) {
-			o.get_or_emplace<Components::FT1ChunkSHA1Requested>().chunks.erase(it);
-		}
-
-		_os.throwEventUpdate(o);
-
-		updateMessages(o); // mostly for received bytes
+		);
 	}
 
 	_receiving_transfers.removePeerTransfer(e.group_number, e.peer_number, e.transfer_id);
@@ -1507,7 +1595,7 @@ bool SHA1_NGCFT1::onEvent(const Events::NGCEXT_ft1_have& e) {
 		return false;
 	}
 
-	SHA1Digest info_hash{e.file_id};
+	SHA1Digest info_hash{e.file_id.ptr, e.file_id.size};
 
 	auto itc_it = _info_to_content.find(info_hash);
 	if (itc_it == _info_to_content.end()) {
@@ -1556,7 +1644,8 @@ bool SHA1_NGCFT1::onEvent(const Events::NGCEXT_ft1_have& e) {
 	assert(remote_have_peer.have.size_bits() >= num_total_chunks);
 
 	bool a_valid_change {false};
-	for (const auto c_i : e.chunks) {
+	for (size_t i = 0; i < e.chunks.size(); i++) {
+		const uint32_t c_i = e.chunks[i];
 		if (c_i >= num_total_chunks) {
 			std::cerr << "SHA1_NGCFT1 error: remote sent have with out-of-range chunk index!!!\n";
 			std::cerr << info_hash << ": " << c_i << " >= " << num_total_chunks << "\n";
@@ -1597,7 +1686,7 @@ bool SHA1_NGCFT1::onEvent(const Events::NGCEXT_ft1_have& e) {
 }
 
 bool SHA1_NGCFT1::onEvent(const Events::NGCEXT_ft1_bitset& e) {
-	std::cerr << "SHA1_NGCFT1: got FT1_BITSET o:" << e.start_chunk << " s:" << e.chunk_bitset.size()*8 << "\n";
+	std::cerr << "SHA1_NGCFT1: got FT1_BITSET o:" << e.start_chunk << " s:" << e.chunk_bitset.size*8 << "\n";
 
 	if (
 		e.file_kind != static_cast<uint32_t>(NGCFT1_file_kind_old::HASH_SHA1_INFO) &&
@@ -1606,12 +1695,12 @@ bool SHA1_NGCFT1::onEvent(const Events::NGCEXT_ft1_bitset& e) {
 		return false;
 	}
 
-	if (e.chunk_bitset.empty()) {
+	if (e.chunk_bitset.size == 0) {
 		// what
 		return false;
 	}
 
-	SHA1Digest info_hash{e.file_id};
+	SHA1Digest info_hash{e.file_id.ptr, e.file_id.size};
 
 	auto itc_it = _info_to_content.find(info_hash);
 	if (itc_it == _info_to_content.end()) {
@@ -1639,9 +1728,9 @@ bool SHA1_NGCFT1::onEvent(const Events::NGCEXT_ft1_bitset& e) {
 
 	const size_t num_total_chunks = o.get<Components::FT1InfoSHA1>().chunks.size();
 	// +7 for byte rounding
-	if (num_total_chunks+7 < e.start_chunk + (e.chunk_bitset.size()*8)) {
+	if (num_total_chunks+7 < e.start_chunk + (e.chunk_bitset.size*8)) {
 		std::cerr << "SHA1_NGCFT1 error: got bitset.size+start that is larger then number of chunks!!\n";
-		std::cerr << "total:" << num_total_chunks << " start:" << e.start_chunk << " size:" << e.chunk_bitset.size()*8 << "\n";
+		std::cerr << "total:" << num_total_chunks << " start:" << e.start_chunk << " size:" << e.chunk_bitset.size*8 << "\n";
 		return false;
 	}
 
@@ -1653,7 +1742,7 @@ bool SHA1_NGCFT1::onEvent(const Events::NGCEXT_ft1_bitset& e) {
 
 	auto& remote_have_peer = remote_have.at(c);
 	if (!remote_have_peer.have_all) { // TODO: maybe unset with bitset?
-		BitSet event_bitset{e.chunk_bitset};
+		BitSet event_bitset{std::vector<uint8_t>(e.chunk_bitset.ptr, e.chunk_bitset.ptr+e.chunk_bitset.size)};
 		// TODO: range replace instead
 		remote_have_peer.have.merge(event_bitset, e.start_chunk);
 
@@ -1681,7 +1770,7 @@ bool SHA1_NGCFT1::onEvent(const Events::NGCEXT_ft1_bitset& e) {
 }
 
 bool SHA1_NGCFT1::onEvent(const Events::NGCEXT_ft1_have_all& e) {
-	std::cerr << "SHA1_NGCFT1: got FT1_HAVE_ALL s:" << e.file_id.size() << "\n";
+	std::cerr << "SHA1_NGCFT1: got FT1_HAVE_ALL s:" << e.file_id.size << "\n";
 
 	if (
 		e.file_kind != static_cast<uint32_t>(NGCFT1_file_kind_old::HASH_SHA1_INFO) &&
@@ -1690,7 +1779,7 @@ bool SHA1_NGCFT1::onEvent(const Events::NGCEXT_ft1_have_all& e) {
 		return false;
 	}
 
-	SHA1Digest info_hash{e.file_id};
+	SHA1Digest info_hash{e.file_id.ptr, e.file_id.size};
 
 	auto itc_it = _info_to_content.find(info_hash);
 	if (itc_it == _info_to_content.end()) {
@@ -1722,18 +1811,18 @@ bool SHA1_NGCFT1::onEvent(const Events::NGCEXT_ft1_have_all& e) {
 }
 
 bool SHA1_NGCFT1::onEvent(const Events::NGCEXT_pc1_announce& e) {
-	std::cerr << "SHA1_NGCFT1: got PC1_ANNOUNCE s:" << e.id.size() << "\n";
+	std::cerr << "SHA1_NGCFT1: got PC1_ANNOUNCE s:" << e.id.size << "\n";
 	// id is file_kind + id
 	uint32_t file_kind = 0u;
 
 	static_assert(SHA1Digest{}.size() == 20);
-	if (e.id.size() != sizeof(file_kind) + 20) {
+	if (e.id.size != sizeof(file_kind) + 20) {
 		// not for us
 		return false;
 	}
 
 	for (size_t i = 0; i < sizeof(file_kind); i++) {
-		file_kind |= uint32_t(e.id[i]) << (i*8);
+		file_kind |= uint32_t(e.id.ptr[i]) << (i*8);
 	}
 
 	if (
@@ -1744,7 +1833,7 @@ bool SHA1_NGCFT1::onEvent(const Events::NGCEXT_pc1_announce& e) {
 	}
 
 
-	SHA1Digest hash{e.id.data()+sizeof(file_kind), 20};
+	SHA1Digest hash{e.id.ptr+sizeof(file_kind), 20};
 
 	// if have use hash(-info) for file, add to participants
 	std::cout << "SHA1_NGCFT1: got ParticipationChatter1 announce from " << e.group_number << ":" << e.peer_number << " for " << hash << "\n";
@@ -14,6 +14,7 @@
 #include "./receiving_transfers.hpp"
 
 #include "./backends/sha1_mapped_filesystem.hpp"
+#include "./chunk_verify_queue.hpp"
 
 #include <entt/container/dense_map.hpp>
 
@@ -37,6 +38,9 @@ class SHA1_NGCFT1 : public ToxEventI, public RegistryMessageModelEventI, public
 
 	Backends::SHA1MappedFilesystem _mfb;
 
+	// received chunks waiting for their hash check
+	ChunkVerifyQueue _chunk_verify_queue;
+
 	bool _object_update_lock {false};
 
 	std::minstd_rand _rng {1337*11};
@@ -85,9 +89,14 @@ class SHA1_NGCFT1 : public ToxEventI, public RegistryMessageModelEventI, public
 
 	void queueBitsetSendFull(ContactHandle4 c, ObjectHandle o);
 
+	// rest of recv_done for chunks, once the hash is checked
+	void onChunkVerified(ObjectHandle o, uint32_t group_number, uint32_t peer_number, const std::vector<size_t>& chunk_indices, bool good, const SHA1Digest& got_hash);
+
 	File2I* objGetFile2Write(ObjectHandle o);
 	File2I* objGetFile2Read(ObjectHandle o);
 
+	// odd interval, so it does not line up with other timers
+	static constexpr float file_inactivity_interval {21.554f};
 	float _file_inactivity_timer {0.f};
 
 	public: // TODO: config
@@ -96,6 +105,8 @@ class SHA1_NGCFT1 : public ToxEventI, public RegistryMessageModelEventI, public
 		size_t _max_concurrent_info_in {6}; // info only
 		size_t _max_concurrent_out {4*10}; // HACK: allow "ideal" number for 10 peers
 
+		bool _chunk_hash_streaming {true}; // hash chunks as they arrive, instead of reading them back once done
+
 	public:
 		SHA1_NGCFT1(
 			ObjectStore2& os,
@@ -109,6 +120,10 @@ class SHA1_NGCFT1 : public ToxEventI, public RegistryMessageModelEventI, public
 
 		float iterate(float delta);
 
+		// see SHA1MappedFilesystem, affects files shared from now on
+		void setHashThreads(size_t threads);
+		void setHashCachePath(std::string_view path, size_t max_bytes = 16*1024*1024);
+
 		void onSendFileHashFinished(ObjectHandle o, Message3Registry* reg_ptr, Contact4 c, uint64_t ts);
 
 		// construct the file part in a partially constructed message
@@ -0,0 +1,112 @@
+// persistence, lru eviction and corruption handling of FileHashCache
+
+#include "./file_hash_cache.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static std::vector<SHA1Digest> makeChunks(size_t count, uint8_t seed) {
+	std::vector<SHA1Digest> chunks(count);
+	for (size_t i = 0; i < count; i++) {
+		for (size_t j = 0; j < 20; j++) {
+			chunks[i].data[j] = uint8_t(seed + i*20 + j);
+		}
+	}
+	return chunks;
+}
+
+static FileHashCache::Key makeKey(uint64_t inode) {
+	return {1, inode, 1000*inode, int64_t(inode)*1000*1000*1000};
+}
+
+int main(void) {
+	size_t failed {0};
+	const auto check = [&failed](bool ok, const std::string& what) {
+		if (!ok) {
+			std::cerr << "FAIL " << what << "\n";
+			failed++;
+		}
+	};
+
+	const auto path = (std::filesystem::temp_directory_path() / "test_file_hash_cache.bin").generic_u8string();
+	std::filesystem::remove(std::filesystem::u8path(path));
+
+	{ // roundtrip
+		FileHashCache cache{path};
+		check(cache.get(makeKey(1)) == nullptr, "empty miss");
+		cache.put(makeKey(1), 32*1024, makeChunks(3, 1));
+		cache.put(makeKey(2), 64*1024, makeChunks(5, 2));
+	}
+	{
+		FileHashCache cache{path};
+		const auto* entry = cache.get(makeKey(1));
+		check(entry != nullptr && entry->chunk_size == 32*1024 && entry->chunks == makeChunks(3, 1), "roundtrip 1");
+		entry = cache.get(makeKey(2));
+		check(entry != nullptr && entry->chunk_size == 64*1024 && entry->chunks == makeChunks(5, 2), "roundtrip 2");
+
+		// same file, other mtime
+		auto key = makeKey(1);
+		key.mtime_ns += 1;
+		check(cache.get(key) == nullptr, "changed mtime miss");
+	}
+
+	{ // lru, room for 2 entries of 10 chunks
+		std::filesystem::remove(std::filesystem::u8path(path));
+		FileHashCache cache{path, 12 + 2*(48 + 10*20) + 20};
+		cache.put(makeKey(1), 32*1024, makeChunks(10, 1));
+		cache.put(makeKey(2), 32*1024, makeChunks(10, 2));
+		cache.get(makeKey(1)); // 2 is now the oldest
+		cache.put(makeKey(3), 32*1024, makeChunks(10, 3));
+
+		check(cache.get(makeKey(1)) != nullptr, "lru keeps used");
+		check(cache.get(makeKey(2)) == nullptr, "lru evicts oldest");
+		check(cache.get(makeKey(3)) != nullptr, "lru keeps new");
+		check(std::filesystem::file_size(std::filesystem::u8path(path)) <= cache._max_bytes, "lru file size");
+	}
+
+	{ // the use order of hits survives a restart
+		std::filesystem::remove(std::filesystem::u8path(path));
+		const size_t max_bytes = 12 + 2*(48 + 10*20) + 20;
+		{
+			FileHashCache cache{path, max_bytes};
+			cache.put(makeKey(1), 32*1024, makeChunks(10, 1));
+			cache.put(makeKey(2), 32*1024, makeChunks(10, 2));
+		}
+		{
+			FileHashCache cache{path, max_bytes};
+			cache.get(makeKey(1)); // 2 is now the oldest, only in memory until destruction
+		}
+		{
+			FileHashCache cache{path, max_bytes};
+			cache.put(makeKey(3), 32*1024, makeChunks(10, 3));
+			check(cache.get(makeKey(1)) != nullptr, "persisted lru keeps used");
+			check(cache.get(makeKey(2)) == nullptr, "persisted lru evicts oldest");
+		}
+	}
+
+	{ // flip a byte, the whole cache is dropped
+		{
+			std::fstream file(std::filesystem::u8path(path), std::ios::binary | std::ios::in | std::ios::out);
+			file.seekp(40);
+			file.put('\xff');
+		}
+		FileHashCache cache{path};
+		check(cache.get(makeKey(1)) == nullptr && cache.get(makeKey(3)) == nullptr, "corrupt ignored");
+
+		// and is usable again
+		cache.put(makeKey(4), 32*1024, makeChunks(1, 4));
+		FileHashCache cache2{path};
+		check(cache2.get(makeKey(4)) != nullptr, "rewritten after corrupt");
+	}
+
+	std::filesystem::remove(std::filesystem::u8path(path));
+
+	if (failed > 0) {
+		std::cerr << failed << " checks failed\n";
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,119 @@
+// known answers and cross checks for every sha1 implementation the cpu supports
+
+#include "./sha1_impl.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static std::string toHex(const uint8_t* data, size_t size) {
+	static const char* hex = "0123456789abcdef";
+	std::string str;
+	for (size_t i = 0; i < size; i++) {
+		str.push_back(hex[data[i] >> 4]);
+		str.push_back(hex[data[i] & 0xf]);
+	}
+	return str;
+}
+
+static std::string hashHex(const SHA1Impl& impl, const std::string& msg) {
+	uint8_t digest[20];
+	sha1_hash(impl, reinterpret_cast<const uint8_t*>(msg.data()), msg.size(), digest);
+	return toHex(digest, 20);
+}
+
+int main(void) {
+	size_t failed {0};
+	const auto check = [&failed](bool ok, const std::string& what) {
+		if (!ok) {
+			std::cerr << "FAIL " << what << "\n";
+			failed++;
+		}
+	};
+
+	// fips 180 / rfc 3174
+	const std::vector<std::pair<std::string, std::string>> kats {
+		{"", "da39a3ee5e6b4b0d3255bfef95601890afd80709"},
+		{"abc", "a9993e364706816aba3e25717850c26c9cd0d89d"},
+		{"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", "84983e441c3bd26ebaae4aa1f95129e5e54670f1"},
+		{std::string(1000000, 'a'), "34aa973cd4c4daa4f61eeb2bdbad27316534016f"},
+	};
+
+	std::vector<uint8_t> data(64*1024 + 3);
+	for (size_t i = 0; i < data.size(); i++) {
+		data[i] = (i * 2654435761u) >> 24;
+	}
+
+	const SHA1Impl& portable = sha1ImplsSupported().front();
+
+	for (const auto& impl : sha1ImplsSupported()) {
+		std::cout << "TEST " << impl.name << "\n";
+
+		for (const auto& [msg, expected] : kats) {
+			check(hashHex(impl, msg) == expected, std::string{impl.name} + " kat size " + std::to_string(msg.size()));
+		}
+
+		// every tail length and more than one block, against the portable one
+		std::vector<size_t> sizes;
+		for (size_t size = 0; size <= 200; size++) {
+			sizes.push_back(size);
+		}
+		sizes.push_back(4096);
+		sizes.push_back(data.size());
+
+		for (const size_t size : sizes) {
+			uint8_t expected[20];
+			sha1_hash(portable, data.data(), size, expected);
+
+			uint8_t digest[20];
+			sha1_hash(impl, data.data(), size, digest);
+			check(std::memcmp(digest, expected, 20) == 0, std::string{impl.name} + " size " + std::to_string(size));
+		}
+
+		// multi buffer, with partly filled lane groups
+		for (const size_t size : {size_t(0), size_t(55), size_t(56), size_t(64), size_t(119), size_t(1000), size_t(4096)}) {
+			for (size_t count = 1; count <= 17; count++) {
+				std::vector<const uint8_t*> msgs;
+				for (size_t i = 0; i < count; i++) {
+					msgs.push_back(data.data() + i*7);
+				}
+
+				std::vector<uint8_t> digests(count*20);
+				sha1_hash_multi(impl, msgs.data(), size, count, digests.data());
+
+				for (size_t i = 0; i < count; i++) {
+					uint8_t expected[20];
+					sha1_hash(portable, msgs[i], size, expected);
+					check(std::memcmp(digests.data() + i*20, expected, 20) == 0, std::string{impl.name} + " multi size " + std::to_string(size) + " count " + std::to_string(count) + " msg " + std::to_string(i));
+				}
+			}
+		}
+
+		// streaming, fed in pieces of odd sizes
+		for (const size_t piece : {size_t(1), size_t(13), size_t(64), size_t(100), size_t(1000)}) {
+			SHA1Stream stream{impl};
+			for (size_t offset = 0; offset < data.size(); offset += piece) {
+				stream.update(data.data() + offset, std::min(piece, data.size() - offset));
+			}
+			check(stream.size() == data.size(), std::string{impl.name} + " stream size piece " + std::to_string(piece));
+
+			uint8_t expected[20];
+			sha1_hash(portable, data.data(), data.size(), expected);
+
+			uint8_t digest[20];
+			stream.finish(digest);
+			check(std::memcmp(digest, expected, 20) == 0, std::string{impl.name} + " stream piece " + std::to_string(piece));
+		}
+	}
+
+	std::cout << "active: " << sha1ImplActive().name << "\n";
+
+	if (failed > 0) {
+		std::cerr << failed << " checks failed\n";
+		return 1;
+	}
+	return 0;
+}
+
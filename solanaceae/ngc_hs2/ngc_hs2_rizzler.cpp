@@ -49,7 +49,7 @@ namespace Components {
 			float last_activity {0.f};
 		};
 		// list of transfers
-		entt::dense_map<uint8_t, Entry> list;
+		entt::dense_map<uint16_t, Entry> list;
 	};
 
 	bool RequestedChatLogs::contains(uint64_t ts_start, uint64_t ts_end) {
@@ -50,7 +50,7 @@ namespace Components {
 			std::vector<uint8_t> data; // transfer data in memory
 			float last_activity {0.f};
 		};
-		entt::dense_map<uint8_t, Entry> _list;
+		entt::dense_map<uint16_t, Entry> _list;
 	};
 
 	void IncommingTimeRangeRequestQueue::queueRequest(const TimeRangeRequest& new_request, const ByteSpan fid) {
@@ -144,14 +144,15 @@ float NGCHS2Sigma::iterate(float delta) {
 			// potentially heavy op
 			auto data = buildChatLogFileRange(group_c, request_entry.ir.ts_start, request_entry.ir.ts_end);
 
-			uint8_t transfer_id {0};
+			uint16_t transfer_id {0};
 			if (!_nft.NGC_FT1_send_init_private(
 				group_number, peer_number,
 				static_cast<uint32_t>(NGCFT1_file_kind::HS2_RANGE_TIME_MSGPACK),
 				request_entry.fid.data(), request_entry.fid.size(),
 				data.size(),
 				&transfer_id,
-				true // can_compress (does nothing rn)
+				true, // can_compress, msgpack chat logs compress well
+				NGCFT1_Priority::HIGH
 			)) {
 				// sending failed, we do not pop but wait for next iterate
 				// TODO: cache data